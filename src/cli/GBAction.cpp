@@ -10,11 +10,113 @@
 #include "mathicgb/Scanner.hpp"
 #include "mathicgb/MathicIO.hpp"
 #include "mathicgb/Reducer.hpp"
+#include "mathicgb/GBCheckpoint.hpp"
+#include "mathicgb/ClassicGBTrace.hpp"
+#include "mathicgb/MultiModularGB.hpp"
+#include <csignal>
 #include <fstream>
 #include <iostream>
 
 MATHICGB_NAMESPACE_BEGIN
 
+namespace {
+  void requestCheckpoint(int) {
+    GBCheckpoint::request();
+  }
+
+  typedef PolyRing::Monoid Monoid;
+  typedef MultiModularGB::RationalPoly RationalPoly;
+
+  BigInteger readNatural(Scanner& in) {
+    std::string digits;
+    while (in.peekDigit())
+      digits.push_back(static_cast<char>(in.get()));
+    return BigInteger::fromString(digits);
+  }
+
+  /// Reads a polynomial in the format of MathicIO::readPoly, except that
+  /// the coefficients are rational numbers such as -3/4.
+  RationalPoly readRationalPoly(const Monoid& monoid, Scanner& in) {
+    RationalPoly poly;
+
+    // also skips whitespace
+    if (in.match('0') || in.match("+0") || in.match("-0"))
+      return poly;
+
+    auto mono = monoid.alloc();
+    do {
+      if (!poly.empty() && !in.peekSign())
+        in.expect('+', '-');
+      MultiModularGB::Term term;
+      term.numerator = 1;
+      term.denominator = 1;
+      const bool negate = !in.match('+') && in.match('-');
+      const bool hasCoefficient = in.peekDigit();
+      if (hasCoefficient) {
+        term.numerator = readNatural(in);
+        if (in.peek() == '/') {
+          in.get();
+          if (!in.peekDigit())
+            in.reportError("Expected the denominator of a fraction.");
+          term.denominator = readNatural(in);
+          if (term.denominator.isZero())
+            in.reportError("The denominator of a fraction must not be 0.");
+        }
+      }
+      if (negate)
+        term.numerator = -term.numerator;
+
+      // Identify a number c on its own as the monomial 1 times c.
+      if (hasCoefficient && !in.peekAlpha())
+        monoid.setIdentity(*mono);
+      else
+        MathicIO<>().readMonomial(monoid, false, *mono, in);
+      for (size_t var = 0; var < monoid.varCount(); ++var)
+        term.exponents.push_back(monoid.externalExponent(*mono, var));
+      poly.push_back(std::move(term));
+    } while (!in.peekWhite() && !in.matchEOF());
+    return poly;
+  }
+
+  /// Writes basis in the format of MathicIO::writeBasis, except that the
+  /// coefficients are rational numbers.
+  void writeRationalBasis(
+    const Monoid& monoid,
+    const std::vector<RationalPoly>& basis,
+    std::ostream& out
+  ) {
+    const BigInteger one(1);
+    auto mono = monoid.alloc();
+    out << basis.size() << '\n';
+    for (const auto& poly : basis) {
+      out << ' ';
+      if (poly.empty())
+        out << '0';
+      for (auto it = poly.begin(); it != poly.end(); ++it) {
+        monoid.setIdentity(*mono);
+        for (size_t var = 0; var < monoid.varCount(); ++var)
+          monoid.setExternalExponent(var, it->exponents[var], *mono);
+
+        const bool negative = it->numerator.isNegative();
+        if (negative)
+          out << '-';
+        else if (it != poly.begin())
+          out << '+';
+        const auto numerator = negative ? -it->numerator : it->numerator;
+        if (numerator != one || it->denominator != one) {
+          out << numerator;
+          if (it->denominator != one)
+            out << '/' << it->denominator;
+          if (monoid.isIdentity(*mono))
+            continue;
+        }
+        MathicIO<>().writeMonomial(monoid, false, *mono, out);
+      }
+      out << '\n';
+    }
+  }
+}
+
 GBAction::GBAction():
   mAutoTailReduce(
     "autoTailReduce",
@@ -30,12 +132,86 @@ GBAction::GBAction():
     "classic Buchberger algorithm.",
     true),
 
+  mReducedBasis(
+    "reducedBasis",
+    "Tail reduce all basis elements at the end so that the output is the "
+    "reduced Groebner basis. Only relevant to the "
+    "classic Buchberger algorithm.",
+    false),
+
+  mSugar(
+    "sugar",
+    "Select S-pairs by their sugar degree, which is the degree they would "
+    "have if the input was homogenized. This helps for inhomogeneous "
+    "input. Only relevant to the classic Buchberger algorithm.",
+    false),
+
+  mCheckpoint(
+    "checkpoint",
+    "Write checkpoints of the computation to this file so that it can be "
+    "resumed later with -resume. A checkpoint is written periodically, "
+    "when the process receives the signal SIGUSR1 and at the end. An empty "
+    "value indicates not to write checkpoints. Only relevant to the "
+    "classic Buchberger algorithm.",
+    ""),
+
+  mCheckpointInterval(
+    "checkpointInterval",
+    "The number of seconds between writing checkpoints. A value of 0 "
+    "indicates to only write checkpoints at the end and on SIGUSR1.",
+    3600),
+
+  mResume(
+    "resume",
+    "Continue the computation from the last checkpoint in the file given "
+    "to -checkpoint, if there is one, instead of starting over. It is an "
+    "error if the input is not the same as for the computation that wrote "
+    "the checkpoint.",
+    false),
+
+  mRecordTrace(
+    "recordTrace",
+    "Write a trace of the computation to this file. The trace records the "
+    "groups of S-pairs that are reduced and the structure of the F4 "
+    "matrices. An empty value indicates not to write a trace. Only "
+    "relevant to the classic Buchberger algorithm.",
+    ""),
+
+  mReplayTrace(
+    "replayTrace",
+    "Replay the trace in this file, which was written by -recordTrace. "
+    "Groups of S-pairs that reduced to zero in the trace are skipped and "
+    "the F4 matrices are built without symbolic preprocessing for as long "
+    "as the computation follows the trace. The rows that reduced to zero "
+    "in the trace are left out of the matrices and the S-pairs of the "
+    "trace are not checked for being useless. The result is only correct "
+    "if the input has the same structure as the input of the trace, so it "
+    "is verified unless -verifyReplay is off. An empty value indicates not "
+    "to replay a trace.",
+    ""),
+
+  mVerifyReplay(
+    "verifyReplay",
+    "After replaying a trace, verify the result by computing a Groebner "
+    "basis of it without the trace. If the lead terms differ, a message is "
+    "printed and the verified basis is the result. This is usually fast, "
+    "since the S-polynomials of a Groebner basis reduce to zero.",
+    true),
+
   mSPairGroupSize(
     "sPairGroupSize",
     "Specifies how many S-pair to reduce at one time. A value of 0 "
     "indicates to use an appropriate default.",
     0),
 
+  mMemoryBudget(
+    "memoryBudget",
+    "The number of megabytes of memory that the computation should try to "
+    "stay within by reducing fewer S-pairs at a time once it goes over. "
+    "A value of 0 indicates that there is no budget. Only relevant to the "
+    "classic Buchberger algorithm.",
+    0),
+
   mMinMatrixToStore(
     "storeMatrices",
     "If using a matrix-based reducer, store the matrices that are generated in "
@@ -44,6 +220,29 @@ GBAction::GBAction():
     "A value of 0 indicates not to store any matrices.",
     0),
 
+  mProbabilisticF4(
+    "probabilisticF4",
+    "If using a matrix-based reducer, find the new pivots of each matrix by "
+    "reducing random linear combinations of the bottom rows. This is much "
+    "faster when most rows reduce to zero, as they do late in a "
+    "computation. The result is checked, but with a probability of at most "
+    "2^-40 per matrix, the output is missing some basis elements. For a "
+    "characteristic below 64 the matrices are reduced exactly.",
+    false),
+
+  mRational(
+    "rational",
+    "The coefficients of the input are rational numbers such as -3/4 and "
+    "the output is the reduced Groebner basis over the rational numbers. "
+    "The basis is computed modulo several primes and the coefficients are "
+    "lifted by Chinese remaindering and rational reconstruction. The "
+    "lifted basis is checked modulo one more prime, which makes a wrong "
+    "result unlikely but does not prove the result correct. The "
+    "characteristic in the input file is not used. Of the options that "
+    "control the algorithm, only -reducer is used.",
+    false
+  ),
+
   mModule(
     "module",
     "The input is a basis of a submodule over the polynomial ring instead of "
@@ -75,25 +274,43 @@ void GBAction::performAction() {
   Scanner in(inputFile);
   auto p = MathicIO<>().readRing(true, in);
   auto& ring = *p.first;
+  const auto reducerType = Reducer::reducerType(mGBParams.mReducer.value());
+
+  if (mRational.value()) {
+    if (mModule.value())
+      mic::reportError("Rational coefficients are only supported for ideals.");
+    std::vector<RationalPoly> ideal(in.readInteger<size_t>());
+    for (auto& poly : ideal)
+      poly = readRationalPoly(ring.monoid(), in);
+
+    MultiModularGB alg(ring.monoid().makeOrder(false, false));
+    alg.setReducerType(reducerType);
+    const auto gb = alg.computeGroebnerBasis(ideal);
+    if (mGBParams.mOutputResult.value()) {
+      std::ofstream out(projectName + ".gb");
+      writeRationalBasis(ring.monoid(), gb, out);
+    }
+    return;
+  }
+
   auto basis = MathicIO<>().readBasis(ring, mModule.value(), in);
 
   // run algorithm
-  const auto reducerType = Reducer::reducerType(mGBParams.mReducer.value());
-  std::unique_ptr<Reducer> reducer;
-  if (
-    reducerType != Reducer::Reducer_F4_Old &&
-    reducerType != Reducer::Reducer_F4_New
-  ) {
-    reducer = Reducer::makeReducer(reducerType, ring);
-  } else {
-    auto f4Reducer = makeF4Reducer(
+  const auto makeReducer = [&]() -> std::unique_ptr<Reducer> {
+    if (
+      reducerType != Reducer::Reducer_F4_Old &&
+      reducerType != Reducer::Reducer_F4_New
+    )
+      return Reducer::makeReducer(reducerType, ring);
+    return makeF4Reducer(
       ring,
       reducerType == Reducer::Reducer_F4_Old,
       mMinMatrixToStore.value() > 0 ? projectName : "",
-      mMinMatrixToStore
-    );     
-    reducer = std::move(f4Reducer);
-  }
+      mMinMatrixToStore,
+      mProbabilisticF4.value()
+    );
+  };
+  const auto reducer = makeReducer();
 
   ClassicGBAlgParams params;
   params.reducer = reducer.get();
@@ -104,17 +321,81 @@ void GBAction::performAction() {
   params.printInterval = mGBParams.mPrintInterval.value();
   params.sPairGroupSize = mSPairGroupSize.value();
   params.reducerMemoryQuantum = mGBParams.mMemoryQuantum.value();
+  params.memoryBudget = static_cast<size_t>(mMemoryBudget.value()) << 20;
   params.useAutoTopReduction = mAutoTopReduce.value();
   params.useAutoTailReduction = mAutoTailReduce.value();
+  params.useSugar = mSugar.value();
+  params.useFinalInterreduction = mReducedBasis.value();
+  params.checkpointFile = mCheckpoint.value();
+  params.checkpointInterval = mCheckpointInterval.value();
+  params.resumeFromCheckpoint = mResume.value();
+  ClassicGBTrace recordTrace;
+  ClassicGBTrace replayTrace;
+  params.recordTrace = mRecordTrace.value().empty() ? nullptr : &recordTrace;
+  params.replayTrace = nullptr;
+  if (!mReplayTrace.value().empty()) {
+    replayTrace.read(mReplayTrace.value());
+    params.replayTrace = &replayTrace;
+  }
   params.callback = nullptr;
 
+#ifdef SIGUSR1
+  if (!params.checkpointFile.empty())
+    std::signal(SIGUSR1, requestCheckpoint);
+#endif
+
   const auto gb = mModule.value() ?
     computeModuleGBClassicAlg(std::move(basis), params) :
     computeGBClassicAlg(std::move(basis), params);
 
+  if (params.recordTrace != nullptr)
+    recordTrace.write(mRecordTrace.value());
+
+  // A basis computed from a trace is made of elements of the ideal, so it
+  // is a Groebner basis if the lead terms of a Groebner basis of it are
+  // divisible by its own lead terms. The reducer caches refer to the basis
+  // of the replayed computation, so the verification gets its own reducer.
+  const Basis* result = &gb;
+  std::unique_ptr<Basis> verified;
+  if (
+    params.replayTrace != nullptr &&
+    mVerifyReplay.value() &&
+    params.breakAfter == 0
+  ) {
+    Basis copy(ring);
+    for (size_t i = 0; i < gb.size(); ++i)
+      copy.insert(make_unique<Poly>(*gb.getPoly(i)));
+    const auto verifyReducer = makeReducer();
+    auto verifyParams = params;
+    verifyParams.reducer = verifyReducer.get();
+    verifyParams.checkpointFile.clear();
+    verifyParams.resumeFromCheckpoint = false;
+    verifyParams.recordTrace = nullptr;
+    verifyParams.replayTrace = nullptr;
+    verified = make_unique<Basis>(mModule.value() ?
+      computeModuleGBClassicAlg(std::move(copy), verifyParams) :
+      computeGBClassicAlg(std::move(copy), verifyParams)
+    );
+
+    const auto& monoid = ring.monoid();
+    for (size_t i = 0; i < verified->size(); ++i) {
+      const auto& lead = verified->getPoly(i)->leadMono();
+      bool divisible = false;
+      for (size_t j = 0; !divisible && j < gb.size(); ++j)
+        divisible = monoid.divides(gb.getPoly(j)->leadMono(), lead);
+      if (!divisible) {
+        std::cerr << "The result of replaying the trace " <<
+          mReplayTrace.value() << " is not a Groebner basis. Using the "
+          "verified basis instead." << std::endl;
+        result = verified.get();
+        break;
+      }
+    }
+  }
+
   if (mGBParams.mOutputResult.value()) {
     std::ofstream out(projectName + ".gb");
-    MathicIO<>().writeBasis(gb, mModule.value(), out);
+    MathicIO<>().writeBasis(*result, mModule.value(), out);
   }
 }
 
@@ -142,9 +423,20 @@ void GBAction::pushBackParameters(
   mGBParams.pushBackParameters(parameters);
   parameters.push_back(&mAutoTailReduce);
   parameters.push_back(&mAutoTopReduce);
+  parameters.push_back(&mReducedBasis);
+  parameters.push_back(&mSugar);
+  parameters.push_back(&mCheckpoint);
+  parameters.push_back(&mCheckpointInterval);
+  parameters.push_back(&mResume);
+  parameters.push_back(&mRecordTrace);
+  parameters.push_back(&mReplayTrace);
+  parameters.push_back(&mVerifyReplay);
   parameters.push_back(&mSPairGroupSize);
+  parameters.push_back(&mMemoryBudget);
   parameters.push_back(&mMinMatrixToStore);
+  parameters.push_back(&mProbabilisticF4);
   parameters.push_back(&mModule);
+  parameters.push_back(&mRational);
 }
 
 MATHICGB_NAMESPACE_END
@@ -34,9 +34,20 @@ private:
   GBCommonParams mGBParams;
   mathic::BoolParameter mAutoTailReduce;
   mathic::BoolParameter mAutoTopReduce;
+  mathic::BoolParameter mReducedBasis;
+  mathic::BoolParameter mSugar;
+  mathic::StringParameter mCheckpoint;
+  mathic::IntegerParameter mCheckpointInterval;
+  mathic::BoolParameter mResume;
+  mathic::StringParameter mRecordTrace;
+  mathic::StringParameter mReplayTrace;
+  mathic::BoolParameter mVerifyReplay;
   //mic::IntegerParameter mTermOrder;
   mathic::IntegerParameter mSPairGroupSize;
+  mathic::IntegerParameter mMemoryBudget;
   mathic::IntegerParameter mMinMatrixToStore;
+  mathic::BoolParameter mProbabilisticF4;
+  mathic::BoolParameter mRational;
   mic::BoolParameter mModule;
 };
 
@@ -7,6 +7,7 @@
 #include "MatrixAction.hpp"
 #include "HelpAction.hpp"
 #include "mathicgb/LogDomainSet.hpp"
+#include "mathicgb/TimeTrace.hpp"
 #include <mathic.h>
 #include <cctype>
 #include <iostream>
@@ -43,5 +44,6 @@ int main(int argc, char **argv) {
   }
 
   mgb::LogDomainSet::singleton().printReport(std::cerr);
+  mgb::TimeTrace::finish();
   return 0;
 };
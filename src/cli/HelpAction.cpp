@@ -45,6 +45,12 @@ void HelpAction::performAction() {
     "If there is no suffix then the setting for streaming is unchanged. A "
     "prefix or suffix of 0 means do nothing.\n"
     "\n"
+    "The command trace=F writes the time that each thread spends in each "
+    "timed log and in each chunk of parallel work to the file F at the end, "
+    "whether the logs are enabled or not. The file is in the Chrome trace "
+    "event format, which chrome://tracing and Perfetto can display. For "
+    "example, -log F4,trace=run.json writes the file run.json.\n"
+    "\n"
     "The following is a list of all compile-time enabled logs. The prefixes "
     "and suffixes indicate the default state of the log.\n";
   mathic::display(header);
@@ -6,9 +6,16 @@
 #include "mathicgb/Poly.hpp"
 #include "mathicgb/Reducer.hpp"
 #include "mathicgb/ClassicGBAlg.hpp"
+#include "mathicgb/GBCheckpoint.hpp"
+#include "mathicgb/MultiModularGB.hpp"
 #include "mathicgb/mtbb.hpp"
 #include "mathicgb/LogDomainSet.hpp"
+#include "mathicgb/TimeTrace.hpp"
+#include "mathicgb/ScopeExit.hpp"
 #include <mathic.h>
+#include <algorithm>
+#include <cstring>
+#include <list>
 
 #ifndef MATHICGB_ASSERT
 #ifdef MATHICGB_DEBUG
@@ -360,6 +367,13 @@ struct GroebnerConfiguration::Pimpl {
     mSchreyering(true),
     mReducer(DefaultReducer),
     mMaxSPairGroupSize(0),
+    mMemoryBudget(0),
+    mReducedBasis(false),
+    mSugarStrategy(false),
+    mHilbertNumerator(),
+    mCheckpointFile(),
+    mCheckpointInterval(3600),
+    mResumeFromCheckpoint(false),
     mMaxThreadCount(0),
     mLogging(),
     mCallbackData(0),
@@ -412,6 +426,13 @@ struct GroebnerConfiguration::Pimpl {
   bool mSchreyering;
   Reducer mReducer;
   unsigned int mMaxSPairGroupSize;
+  size_t mMemoryBudget;
+  bool mReducedBasis;
+  bool mSugarStrategy;
+  std::vector<long long> mHilbertNumerator;
+  std::string mCheckpointFile;
+  unsigned int mCheckpointInterval;
+  bool mResumeFromCheckpoint;
   unsigned int mMaxThreadCount;
   std::string mLogging;
   void* mCallbackData;
@@ -582,6 +603,75 @@ uint32 GroebnerConfiguration::maxSPairGroupSize() const {
   return mPimpl->mMaxSPairGroupSize;
 }
 
+void GroebnerConfiguration::setMemoryBudget(size_t bytes) {
+  mPimpl->mMemoryBudget = bytes;
+}
+
+size_t GroebnerConfiguration::memoryBudget() const {
+  return mPimpl->mMemoryBudget;
+}
+
+void GroebnerConfiguration::setReducedBasis(bool value) {
+  mPimpl->mReducedBasis = value;
+}
+
+bool GroebnerConfiguration::reducedBasis() const {
+  return mPimpl->mReducedBasis;
+}
+
+void GroebnerConfiguration::setSugarStrategy(bool value) {
+  mPimpl->mSugarStrategy = value;
+}
+
+bool GroebnerConfiguration::sugarStrategy() const {
+  return mPimpl->mSugarStrategy;
+}
+
+void GroebnerConfiguration::setHilbertNumeratorInternal(
+  const long long* numerator,
+  size_t size
+) {
+  mPimpl->mHilbertNumerator.assign(numerator, numerator + size);
+}
+
+const long long* GroebnerConfiguration::hilbertNumeratorInternal(
+  size_t& size
+) const {
+  size = mPimpl->mHilbertNumerator.size();
+  return mPimpl->mHilbertNumerator.data();
+}
+
+void GroebnerConfiguration::setCheckpointFile(const char* fileName) {
+  if (fileName == 0)
+    mPimpl->mCheckpointFile.clear();
+  else
+    mPimpl->mCheckpointFile = fileName;
+}
+
+const char* GroebnerConfiguration::checkpointFile() const {
+  return mPimpl->mCheckpointFile.c_str();
+}
+
+void GroebnerConfiguration::setCheckpointInterval(unsigned int seconds) {
+  mPimpl->mCheckpointInterval = seconds;
+}
+
+unsigned int GroebnerConfiguration::checkpointInterval() const {
+  return mPimpl->mCheckpointInterval;
+}
+
+void GroebnerConfiguration::setResumeFromCheckpoint(bool value) {
+  mPimpl->mResumeFromCheckpoint = value;
+}
+
+bool GroebnerConfiguration::resumeFromCheckpoint() const {
+  return mPimpl->mResumeFromCheckpoint;
+}
+
+void GroebnerConfiguration::requestCheckpoint() {
+  GBCheckpoint::request();
+}
+
 void GroebnerConfiguration::setMaxThreadCount(unsigned int maxThreadCount) {
   mPimpl->mMaxThreadCount = maxThreadCount;
 }
@@ -623,9 +713,9 @@ namespace {
   }
 }
 
-struct GroebnerInputIdealStream::Pimpl {
-  Pimpl(const GroebnerConfiguration& conf):
-    ring(
+namespace {
+  std::shared_ptr<const PolyRing> makeRing(const GroebnerConfiguration& conf) {
+    return std::make_shared<const PolyRing>(
       PolyRing::Field(conf.modulus()),
       PolyRing::Monoid::Order(
         conf.varCount(),
@@ -635,10 +725,35 @@ struct GroebnerInputIdealStream::Pimpl {
         conf.componentsAscending(),
         conf.schreyering()
       )
-    ),
+    );
+  }
+
+  /// Returns true if the polynomial rings of a and b are the same.
+  bool sameRing(
+    const GroebnerConfiguration& a,
+    const GroebnerConfiguration& b
+  ) {
+    return
+      a.modulus() == b.modulus() &&
+      a.varCount() == b.varCount() &&
+      a.monomialOrder() == b.monomialOrder() &&
+      a.componentBefore() == b.componentBefore() &&
+      a.componentsAscending() == b.componentsAscending() &&
+      a.schreyering() == b.schreyering();
+  }
+}
+
+struct GroebnerInputIdealStream::Pimpl {
+  Pimpl(
+    const GroebnerConfiguration& conf,
+    std::shared_ptr<const PolyRing> sharedRing
+  ):
+    ringOwner(std::move(sharedRing)),
+    ring(*ringOwner),
     basis(ring),
     poly(ring),
     monomial(ring.allocMonomial()),
+    knownGroebnerBasisCount(0),
     conf(conf)
 #ifdef MATHICGB_DEBUG
     , hasBeenDestroyed(false),
@@ -650,10 +765,12 @@ struct GroebnerInputIdealStream::Pimpl {
     ring.freeMonomial(monomial);
   }
 
-  const PolyRing ring;
+  const std::shared_ptr<const PolyRing> ringOwner;
+  const PolyRing& ring;
   Basis basis;
   Poly poly;
   Monomial monomial;
+  size_t knownGroebnerBasisCount;
   const GroebnerConfiguration conf;
   MATHICGB_IF_DEBUG(bool hasBeenDestroyed);
   MATHICGB_IF_DEBUG(StreamStateChecker checker); 
@@ -663,7 +780,7 @@ GroebnerInputIdealStream::GroebnerInputIdealStream(
   const GroebnerConfiguration& conf
 ):
   mExponents(new Exponent[conf.varCount()]),
-  mPimpl(new Pimpl(conf))
+  mPimpl(new Pimpl(conf, makeRing(conf)))
 {
   MATHICGB_ASSERT(debugAssertValid());
 }
@@ -774,6 +891,14 @@ void GroebnerInputIdealStream::idealDone() {
   MATHICGB_IF_DEBUG(mPimpl->checker.idealDone());
 }
 
+void GroebnerInputIdealStream::setKnownGroebnerBasisCount(size_t polyCount) {
+  mPimpl->knownGroebnerBasisCount = polyCount;
+}
+
+size_t GroebnerInputIdealStream::knownGroebnerBasisCount() const {
+  return mPimpl->knownGroebnerBasisCount;
+}
+
 bool GroebnerInputIdealStream::debugAssertValid() const {
   MATHICGB_ASSERT(this != 0);
   MATHICGB_ASSERT(mExponents != 0);
@@ -802,9 +927,21 @@ namespace mgbi {
 // ** Implementation of mgbi::IdealAdapter
 namespace mgbi {
   struct IdealAdapter::Pimpl {
-    Pimpl(): polyIndex(0), mTermIt() {}
+    Pimpl(): ring(nullptr), polyIndex(0), mTermIt() {}
+
+    /// Moves on to the next non-zero polynomial. Zero polynomials are
+    /// kept, while nextTerm() frees each non-zero polynomial as soon as all
+    /// of its terms have been read so that the output basis does not have
+    /// to be kept in memory while it is being streamed out.
+    void toNextNonZeroPoly() {
+      while (polyIndex < polys.size() && polys[polyIndex]->isZero())
+        ++polyIndex;
+      if (polyIndex < polys.size())
+        mTermIt = polys[polyIndex]->begin();
+    }
 
-    std::unique_ptr<Basis> basis;
+    const PolyRing* ring;
+    std::vector<std::unique_ptr<Poly>> polys;
     std::unique_ptr<Exponent[]> tmpTerm;
     size_t polyIndex;
     Poly::ConstTermIterator mTermIt;
@@ -818,39 +955,35 @@ namespace mgbi {
   }
 
   auto IdealAdapter::varCount() const -> VarIndex {
-    MATHICGB_ASSERT(mPimpl->basis.get() != 0);
-    return mPimpl->basis->ring().getNumVars();
+    MATHICGB_ASSERT(mPimpl->ring != nullptr);
+    return mPimpl->ring->getNumVars();
   }
 
   size_t IdealAdapter::polyCount() const {
-    MATHICGB_ASSERT(mPimpl->basis.get() != 0);
-    return mPimpl->basis->size();
+    MATHICGB_ASSERT(mPimpl->ring != nullptr);
+    return mPimpl->polys.size();
   }
 
   size_t IdealAdapter::termCount(PolyIndex poly) const {
-    MATHICGB_ASSERT(mPimpl->basis.get() != 0);
-    MATHICGB_ASSERT(poly < mPimpl->basis->size());
-    return mPimpl->basis->getPoly(poly)->termCount();
+    MATHICGB_ASSERT(mPimpl->ring != nullptr);
+    MATHICGB_ASSERT(poly < mPimpl->polys.size());
+    // A polynomial is freed once its terms have been streamed out, after
+    // which its term count is no longer known.
+    MATHICGB_ASSERT(mPimpl->polys[poly] != nullptr);
+    return mPimpl->polys[poly]->termCount();
   }
 
   void IdealAdapter::toFirstTerm() {
     mPimpl->polyIndex = 0;
-    while (
-      mPimpl->polyIndex < mPimpl->basis->size() &&
-      mPimpl->basis->getPoly(mPimpl->polyIndex)->isZero()
-    )
-      ++(mPimpl->polyIndex);
-
-    if (mPimpl->polyIndex < mPimpl->basis->size())
-      mPimpl->mTermIt = mPimpl->basis->getPoly(mPimpl->polyIndex)->begin();
+    mPimpl->toNextNonZeroPoly();
   }
 
   auto IdealAdapter::nextTerm() const -> ConstTerm {
-    MATHICGB_ASSERT(mPimpl->basis.get() != 0);
-    MATHICGB_ASSERT(mPimpl->polyIndex < mPimpl->basis->size());
+    MATHICGB_ASSERT(mPimpl->ring != nullptr);
+    MATHICGB_ASSERT(mPimpl->polyIndex < mPimpl->polys.size());
 
-    const auto& monoid = mPimpl->basis->ring().monoid();
-    const auto& p = *mPimpl->basis->getPoly(mPimpl->polyIndex);
+    const auto& monoid = mPimpl->ring->monoid();
+    const auto& p = *mPimpl->polys[mPimpl->polyIndex];
     MATHICGB_ASSERT(p.ring().monoid() == monoid);
 
     const auto& from = *mPimpl->mTermIt;
@@ -859,23 +992,18 @@ namespace mgbi {
     for (VarIndex var = 0; var < monoid.varCount(); ++var)
       to[var] = monoid.externalExponent(*from.mono, var);
 
-    ++(mPimpl->mTermIt);
-    if (mPimpl->mTermIt == p.end()) {
-      ++mPimpl->polyIndex;
-      while (
-        mPimpl->polyIndex < mPimpl->basis->size() &&
-        mPimpl->basis->getPoly(mPimpl->polyIndex)->isZero()
-      )
-        ++(mPimpl->polyIndex);
-
-      if (mPimpl->polyIndex < mPimpl->basis->size())
-        mPimpl->mTermIt = mPimpl->basis->getPoly(mPimpl->polyIndex)->begin();
-    }
-
     ConstTerm term;
     term.coef = from.coef;
     term.exponents = to;
     term.com = com;
+
+    ++(mPimpl->mTermIt);
+    if (mPimpl->mTermIt == p.end()) {
+      // The term has been copied out, so p can go.
+      mPimpl->polys[mPimpl->polyIndex].reset();
+      ++mPimpl->polyIndex;
+      mPimpl->toNextNonZeroPoly();
+    }
     return term;
   }
 }
@@ -910,47 +1038,112 @@ namespace {
   };
 }
 
-// ** Implementation of function mgbi::internalComputeGroebnerBasis
-namespace mgbi {
-  bool internalComputeGroebnerBasis(
-    GroebnerInputIdealStream& inputWhichWillBeCleared,
-    IdealAdapter& output
-  ) {
-    /// @todo: make a scheme where the output Groebner basis is freed
-    /// polynomial-by-polynomial as data is transferred to out. Also
-    /// make it so that ideal is not copied.
+// ** Implementation of class GroebnerContext
+struct GroebnerContext::Pimpl {
+  Pimpl(unsigned int maxThreadCount):
+    maxThreadCount(maxThreadCount),
+    arena(
+      maxThreadCount == 0 ?
+        mgb::mtbb::task_arena::automatic :
+        static_cast<int>(maxThreadCount)
+    )
+  {
+    // Many threads can run computations in the arena at the same time, so
+    // it is initialized here rather than by whichever of them comes first.
+    arena.initialize();
+  }
 
-    auto&& basis = PimplOf()(inputWhichWillBeCleared).basis;
-    auto&& conf = inputWhichWillBeCleared.configuration();
-    auto&& ring = basis.ring();
-    const auto varCount = ring.getNumVars();
-    MATHICGB_ASSERT(PimplOf()(conf).debugAssertValid());
+  const unsigned int maxThreadCount;
+  mgb::mtbb::task_arena arena;
+
+  /// The most recently used rings are kept in rings. Once there are more,
+  /// the least recently used ring is dropped. The input streams keep their
+  /// rings alive, so that only stops new streams from sharing it.
+  static const size_t MaxRingCount = 16;
+
+  /// The rings of the input streams made with this context, each with the
+  /// configuration that it was made for, from least to most recently used.
+  std::list<
+    std::pair<GroebnerConfiguration, std::shared_ptr<const PolyRing>>
+  > rings;
+  mgb::mtbb::mutex ringsMutex;
+};
+
+GroebnerContext::GroebnerContext(unsigned int maxThreadCount):
+  mPimpl(new Pimpl(maxThreadCount))
+{}
+
+GroebnerContext::~GroebnerContext() {
+  delete mPimpl;
+}
 
-    // Tell tbb how many threads to use
-    const auto maxThreadCount = int(conf.maxThreadCount());
-    const auto tbbMaxThreadCount = maxThreadCount == 0 ?
-      mgb::mtbb::task_scheduler_init::automatic : maxThreadCount;
-    mgb::mtbb::task_scheduler_init scheduler(tbbMaxThreadCount);
+unsigned int GroebnerContext::maxThreadCount() const {
+  return mPimpl->maxThreadCount;
+}
 
-    // Set up logging
-    LogDomainSet::singleton().reset();
-    LogDomainSet::singleton().performLogCommands(conf.logging());
+namespace {
+  std::shared_ptr<const PolyRing> sharedRing(
+    const GroebnerConfiguration& conf,
+    GroebnerContext& context
+  ) {
+    auto&& pimpl = PimplOf()(context);
+    auto&& rings = pimpl.rings;
+    mgb::mtbb::mutex::scoped_lock lock(pimpl.ringsMutex);
+    for (auto it = rings.begin(); it != rings.end(); ++it) {
+      if (sameRing(it->first, conf)) {
+        // Move the ring to the back as the most recently used one.
+        rings.splice(rings.end(), rings, it);
+        return it->second;
+      }
+    }
+    if (rings.size() == pimpl.MaxRingCount)
+      rings.pop_front();
+    auto ring = makeRing(conf);
+    rings.emplace_back(conf, ring);
+    return ring;
+  }
+}
+
+GroebnerInputIdealStream::GroebnerInputIdealStream(
+  const GroebnerConfiguration& conf,
+  GroebnerContext& context
+):
+  mExponents(new Exponent[conf.varCount()]),
+  mPimpl(new Pimpl(conf, sharedRing(conf, context)))
+{
+  MATHICGB_ASSERT(debugAssertValid());
+}
 
-    // Make reducer
+// ** Implementation of function mgbi::internalComputeGroebnerBasis
+namespace {
+  Reducer::ReducerType reducerType(const GroebnerConfiguration& conf) {
     typedef GroebnerConfiguration GConf;
-    Reducer::ReducerType reducerType;
     switch (conf.reducer()) {
     case GConf::ClassicReducer:
-      reducerType = Reducer::Reducer_Geobucket_Hashed;
-      break;
+      return Reducer::Reducer_Geobucket_Hashed;
 
     default:
     case GConf::DefaultReducer:
     case GConf::MatrixReducer:
-      reducerType = Reducer::Reducer_F4_New;
-      break;
+      return Reducer::Reducer_F4_New;
     }
-    const auto reducer = Reducer::makeReducer(reducerType, ring);
+  }
+
+  /// Returns a Groebner basis of the ideal of input, or null if the
+  /// callback of the configuration of input stopped the computation with no
+  /// output.
+  std::unique_ptr<Basis> computeOne(GroebnerInputIdealStream& input) {
+    // The input polynomials are moved into the computation and the output
+    // polynomials are moved into output, which frees each one once it has
+    // been streamed out. So no polynomials are copied along the way.
+    auto&& basis = PimplOf()(input).basis;
+    const auto knownGroebnerBasisCount =
+      PimplOf()(input).knownGroebnerBasisCount;
+    auto&& conf = input.configuration();
+    auto&& ring = basis.ring();
+    MATHICGB_ASSERT(PimplOf()(conf).debugAssertValid());
+
+    const auto reducer = Reducer::makeReducer(reducerType(conf), ring);
     CallbackAdapter callback(
       PimplOf()(conf).mCallbackData,
       PimplOf()(conf).mCallback
@@ -965,25 +1158,224 @@ namespace mgbi {
     params.printInterval = 0;
     params.sPairGroupSize = conf.maxSPairGroupSize();
     params.reducerMemoryQuantum = 100 * 1024;
+    params.memoryBudget = conf.memoryBudget();
     params.useAutoTopReduction = true;
     params.useAutoTailReduction = false;
+    params.useSugar = conf.sugarStrategy();
+    params.useFinalInterreduction = conf.reducedBasis();
+    params.checkpointFile = conf.checkpointFile();
+    params.checkpointInterval = conf.checkpointInterval();
+    params.resumeFromCheckpoint = conf.resumeFromCheckpoint();
+    params.recordTrace = nullptr;
+    params.replayTrace = nullptr;
+    params.hilbertNumerator = conf.hilbertNumerator();
     params.callback = nullptr;
     if (!callback.isNull())
       params.callback = [&callback](){return callback();};
 
-    auto gb = conf.comCount() == 1 ?
-      computeGBClassicAlg(std::move(basis), params) :
-      computeModuleGBClassicAlg(std::move(basis), params);
+    auto compute = [&]() {
+      if (knownGroebnerBasisCount == 0) {
+        return conf.comCount() == 1 ?
+          computeGBClassicAlg(std::move(basis), params) :
+          computeModuleGBClassicAlg(std::move(basis), params);
+      }
+
+      // Split the input into the known Groebner basis and the new
+      // generators.
+      auto polys = basis.releaseGenerators();
+      const auto gbCount = std::min(knownGroebnerBasisCount, polys.size());
+      Basis groebnerBasis(ring);
+      for (size_t i = 0; i < polys.size(); ++i)
+        (i < gbCount ? groebnerBasis : basis).insert(std::move(polys[i]));
+      return computeIncrementalGBClassicAlg
+        (std::move(groebnerBasis), std::move(basis), params);
+    };
+    auto gb = make_unique<Basis>(compute());
 
     typedef mgb::GroebnerConfiguration::Callback::Action Action;
-    if (callback.lastAction() != Action::StopWithNoOutputAction) {
-      PimplOf()(output).basis = make_unique<Basis>(std::move(gb));
-      PimplOf()(output).tmpTerm =
-        make_unique_array<GConf::Exponent>(basis.ring().varCount());
-      return true;
-    } else
+    if (callback.lastAction() == Action::StopWithNoOutputAction)
+      return nullptr;
+    return gb;
+  }
+
+  void toIdealAdapter(Basis& basis, mgbi::IdealAdapter& output) {
+    auto&& ring = basis.ring();
+    PimplOf()(output).ring = &ring;
+    PimplOf()(output).polys = basis.releaseGenerators();
+    PimplOf()(output).tmpTerm =
+      make_unique_array<GroebnerConfiguration::Exponent>(ring.varCount());
+  }
+
+  /// Held for writing by a computation that has logging on and for reading
+  /// by any other computation. See runComputation.
+  mgb::mtbb::queuing_rw_mutex& loggingMutex() {
+    static mgb::mtbb::queuing_rw_mutex mutex;
+    return mutex;
+  }
+
+  /// Sets up the threads and the logging according to conf and context and
+  /// then calls compute on those threads.
+  ///
+  /// The log domains and the TimeTrace are global and not synchronized. All
+  /// of them are off unless a computation with logging on is running, and
+  /// then nothing else writes to them. So computations without logging
+  /// run at the same time as each other, while a computation with logging
+  /// runs alone and turns the logging off again at the end.
+  template<class Compute>
+  void runComputation(
+    const GroebnerConfiguration& conf,
+    GroebnerContext* context,
+    const Compute& compute
+  ) {
+    const bool logging = conf.logging()[0] != '\0';
+    mgb::mtbb::queuing_rw_mutex::scoped_lock lock(loggingMutex(), logging);
+
+    // Tell tbb how many threads to use, unless the threads of context are
+    // used.
+    std::unique_ptr<mgb::mtbb::task_scheduler_init> scheduler;
+    if (context == nullptr) {
+      const auto maxThreadCount = int(conf.maxThreadCount());
+      const auto tbbMaxThreadCount = maxThreadCount == 0 ?
+        mgb::mtbb::task_scheduler_init::automatic : maxThreadCount;
+      scheduler =
+        make_unique<mgb::mtbb::task_scheduler_init>(tbbMaxThreadCount);
+    }
+
+    // Turn the logging off again even if an error is reported.
+    MATHICGB_SCOPE_EXIT(loggingGuard) {LogDomainSet::singleton().reset();};
+    if (logging)
+      LogDomainSet::singleton().performLogCommands(conf.logging());
+    else
+      loggingGuard.dismiss();
+
+    if (context == nullptr)
+      compute();
+    else
+      PimplOf()(*context).arena.execute(compute);
+    if (logging)
+      TimeTrace::finish();
+  }
+}
+
+namespace mgbi {
+  bool internalComputeGroebnerBasis(
+    GroebnerInputIdealStream& inputWhichWillBeCleared,
+    IdealAdapter& output,
+    GroebnerContext* context
+  ) {
+    std::unique_ptr<Basis> gb;
+    runComputation(
+      inputWhichWillBeCleared.configuration(),
+      context,
+      [&]() {gb = computeOne(inputWhichWillBeCleared);}
+    );
+    if (gb == nullptr)
       return false;
+    toIdealAdapter(*gb, output);
+    return true;
+  }
+
+  void internalComputeGroebnerBases(
+    GroebnerInputIdealStream* const* inputsWhichWillBeCleared,
+    const size_t count,
+    GroebnerContext* context,
+    void* outputData,
+    void (*output)(void*, size_t, IdealAdapter&)
+  ) {
+    if (count == 0)
+      return;
+    MATHICGB_ASSERT(inputsWhichWillBeCleared != nullptr);
+    MATHICGB_ASSERT(output != nullptr);
+
+    // The threads and the logging are set up once for all of the ideals.
+    const auto& conf = inputsWhichWillBeCleared[0]->configuration();
+    for (size_t i = 1; i < count; ++i) {
+      const auto& other = inputsWhichWillBeCleared[i]->configuration();
+      if (context == nullptr && other.maxThreadCount() != conf.maxThreadCount())
+        mathic::reportError("computeGroebnerBases: the inputs must have the "
+          "same maximum number of threads.");
+      if (std::strcmp(other.logging(), conf.logging()) != 0)
+        mathic::reportError("computeGroebnerBases: the inputs must have the "
+          "same logging setting.");
+    }
+
+    // One task per ideal. Each task makes its own reducer since reducers
+    // keep state during a computation. The ring is shared if the inputs
+    // were made with the same context.
+    auto computeIdeal = [&](const size_t i) {
+      MATHICGB_ASSERT(inputsWhichWillBeCleared[i] != nullptr);
+      const auto gb = computeOne(*inputsWhichWillBeCleared[i]);
+      if (gb == nullptr)
+        return;
+      IdealAdapter ideal;
+      toIdealAdapter(*gb, ideal);
+      output(outputData, i, ideal);
+    };
+    runComputation(
+      conf,
+      context,
+      [&]() {
+        if (LogDomainSet::singleton().anyEnabled()) {
+          // The ideals would log to the same log domains at the same time.
+          for (size_t i = 0; i < count; ++i)
+            computeIdeal(i);
+          return;
+        }
+        mgb::mtbb::parallel_for(
+          mgb::mtbb::blocked_range<size_t>(0, count, 1),
+          [&](const mgb::mtbb::blocked_range<size_t>& range) {
+            for (auto i = range.begin(); i != range.end(); ++i)
+              computeIdeal(i);
+          }
+        );
+      }
+    );
+  }
+}
+
+// ** Implementation of function computeRationalGroebnerBasis
+std::vector<RationalPolynomial> computeRationalGroebnerBasis(
+  const GroebnerConfiguration& configuration,
+  const std::vector<RationalPolynomial>& ideal
+) {
+  if (configuration.comCount() != 1)
+    mathic::reportError("Rational coefficients are only supported for ideals.");
+
+  std::vector<MultiModularGB::RationalPoly> internalIdeal(ideal.size());
+  for (size_t i = 0; i < ideal.size(); ++i) {
+    for (const auto& term : ideal[i]) {
+      MultiModularGB::Term internalTerm;
+      internalTerm.numerator = BigInteger::fromString(term.numerator);
+      internalTerm.denominator = BigInteger::fromString(term.denominator);
+      internalTerm.exponents.assign
+        (term.exponents.begin(), term.exponents.end());
+      internalIdeal[i].push_back(std::move(internalTerm));
+    }
+  }
+
+  MultiModularGB alg(PolyRing::Monoid::Order(
+    configuration.varCount(),
+    std::move(configuration.monomialOrder().second),
+    translateBaseOrder(configuration.monomialOrder().first)
+  ));
+  alg.setReducerType(reducerType(configuration));
+  std::vector<MultiModularGB::RationalPoly> gb;
+  runComputation(configuration, nullptr, [&]() {
+    gb = alg.computeGroebnerBasis(internalIdeal);
+  });
+
+  std::vector<RationalPolynomial> basis(gb.size());
+  for (size_t i = 0; i < gb.size(); ++i) {
+    for (const auto& internalTerm : gb[i]) {
+      RationalTerm term;
+      term.numerator = internalTerm.numerator.toString();
+      term.denominator = internalTerm.denominator.toString();
+      term.exponents.assign
+        (internalTerm.exponents.begin(), internalTerm.exponents.end());
+      basis[i].push_back(std::move(term));
+    }
   }
+  return basis;
 }
 
 MATHICGB_NAMESPACE_END
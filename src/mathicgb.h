@@ -3,6 +3,7 @@
 
 #include <ostream>
 #include <vector>
+#include <string>
 #include <utility>
 
 // The main function in this file is computeGroebnerBasis. See the comment
@@ -30,6 +31,8 @@ namespace mgb { // Part of the public interface of MathicGB
     class PimplOf;
   }
 
+  class GroebnerContext;
+
   /// Sets time to the number of seconds accumulated on the internal
   /// MathicGB log named logName. Returns true if the logName log was
   /// found and false otherwise.
@@ -247,6 +250,87 @@ namespace mgb { // Part of the public interface of MathicGB
     void setMaxSPairGroupSize(unsigned int size);
     unsigned int maxSPairGroupSize() const;
 
+    /// Sets the number of bytes of memory that the computation should try
+    /// to stay within. Memory use is checked between steps of the
+    /// computation. When it has gone over the budget, fewer S-pairs are
+    /// reduced at a time, down to reducing them one at a time without
+    /// matrices, and caches are dropped. This makes the computation slower
+    /// but lets it use less memory. The budget is not a hard limit, since
+    /// the computation continues even if it cannot get under the budget.
+    /// A value of 0 indicates that there is no budget, which is the
+    /// default.
+    void setMemoryBudget(size_t bytes);
+    size_t memoryBudget() const;
+
+    /// If value is true then the output is the reduced Groebner basis,
+    /// where no term of any basis element is divisible by the leading
+    /// monomial of another basis element and every basis element is monic.
+    /// Otherwise the output is a minimal Groebner basis whose non-leading
+    /// terms may not be fully reduced. The reduced Groebner basis is
+    /// unique, so this gives canonical output at the cost of a final
+    /// interreduction step.
+    ///
+    /// The default value is false.
+    void setReducedBasis(bool value);
+    bool reducedBasis() const;
+
+    /// If value is true then S-pairs are selected by their sugar degree,
+    /// which is the degree that they would have if the input had been
+    /// homogenized. The S-pairs of the lowest sugar degree are reduced
+    /// together. This often helps for inhomogeneous input, where it avoids
+    /// the large intermediate polynomials that otherwise appear, and it
+    /// makes no difference for homogeneous input.
+    ///
+    /// The default value is false.
+    void setSugarStrategy(bool value);
+    bool sugarStrategy() const;
+
+    /// Sets the numerator N(t) of the Hilbert series N(t)/(1-t)^n of R/I,
+    /// where R is the polynomial ring in n variables and I is the input
+    /// ideal. Element i is the coefficient of t^i. The input ideal must
+    /// then be homogeneous with respect to the total degree. S-pairs of a
+    /// degree are skipped once the leading monomials of the basis computed
+    /// so far have the Hilbert function of I in that degree, since then
+    /// every S-polynomial of that degree reduces to zero. The Hilbert
+    /// series can be computed cheaply from a Groebner basis of I modulo
+    /// another prime. If it is wrong then the output may be wrong, though
+    /// some errors are detected and reported.
+    ///
+    /// The default is an empty numerator, which turns this off.
+    void setHilbertNumerator(const std::vector<long long>& numerator);
+    std::vector<long long> hilbertNumerator() const;
+
+    /// Sets the file that checkpoints of the computation are written to.
+    /// A checkpoint records enough of the state of the computation that it
+    /// can be resumed from there after the process has been stopped - see
+    /// setResumeFromCheckpoint(). Checkpoints are appended to the file, so
+    /// writing a checkpoint costs time proportional to the progress since
+    /// the previous checkpoint. A final checkpoint is written when the
+    /// computation ends, including when a callback stops it early. A null
+    /// or empty string indicates not to write checkpoints, which is the
+    /// default. Ownership of the string is not taken over.
+    void setCheckpointFile(const char* fileName);
+    const char* checkpointFile() const;
+
+    /// Sets how many seconds to let pass between writing checkpoints.
+    /// A value of 0 indicates to only write a checkpoint at the end and
+    /// when requestCheckpoint() has been called. The default is 3600.
+    void setCheckpointInterval(unsigned int seconds);
+    unsigned int checkpointInterval() const;
+
+    /// If value is true and the checkpoint file contains a checkpoint,
+    /// then the computation continues from that checkpoint and the input
+    /// ideal is only used to check that the checkpoint is from a
+    /// computation of the same ideal in the same polynomial ring. The
+    /// default value is false.
+    void setResumeFromCheckpoint(bool value);
+    bool resumeFromCheckpoint() const;
+
+    /// Asks every ongoing computation that writes checkpoints to write a
+    /// checkpoint as soon as possible. This only increments a lock-free
+    /// counter, so it is safe to call from a signal handler.
+    static void requestCheckpoint();
+
     /// Sets the maximum number of threads to use. May use fewer threads.
     /// A value of 0 indicates to let the library decide this value for
     /// itself, which is also the default value.
@@ -255,6 +339,8 @@ namespace mgb { // Part of the public interface of MathicGB
 
     /// Sets logging to occur according to the string. The format of the
     /// string is the same as for the -logs command line parameter.
+    /// The command trace=F writes a timeline of the computation to the
+    /// file F when the computation is done.
     /// Ownership of the string is not taken over.
     /// @todo: describe the format in more detail.
     void setLogging(const char* logging);
@@ -293,6 +379,9 @@ namespace mgb { // Part of the public interface of MathicGB
     bool setMonomialOrderInternal(MonomialOrderData order);
     MonomialOrderData monomialOrderInternal() const;
 
+    void setHilbertNumeratorInternal(const long long* numerator, size_t size);
+    const long long* hilbertNumeratorInternal(size_t& size) const;
+
     static Callback::Action callbackCaller(void* obj);
     void setCallbackInternal(void* data, Callback::Action (*func) (void*));
     void* callbackDataInternal() const;
@@ -306,6 +395,20 @@ namespace mgb { // Part of the public interface of MathicGB
   class GroebnerInputIdealStream {
   public:
     GroebnerInputIdealStream(const GroebnerConfiguration& conf);
+
+    /// As GroebnerInputIdealStream(conf), but the internal polynomial ring
+    /// is shared with the other input streams made with context whose
+    /// configurations have the same modulus, number of variables, monomial
+    /// order and module settings. That saves setting up the same ring again
+    /// for each of many small ideals. context remembers the 16 most recently
+    /// used rings, so streams for more kinds of rings than that set up some
+    /// rings again. context must not be destructed before this stream is
+    /// done being used by computeGroebnerBasis or computeGroebnerBases.
+    GroebnerInputIdealStream(
+      const GroebnerConfiguration& conf,
+      GroebnerContext& context
+    );
+
     ~GroebnerInputIdealStream();
 
     typedef GroebnerConfiguration::Coefficient Coefficient;
@@ -334,6 +437,17 @@ namespace mgb { // Part of the public interface of MathicGB
     void appendPolynomialDone();
     void idealDone();
 
+    /// Declares that the first polyCount polynomials of the ideal are a
+    /// Groebner basis of the ideal that they generate. The S-pairs between
+    /// those polynomials are then not considered, which makes extending a
+    /// known Groebner basis by a few more generators much faster than
+    /// computing a Groebner basis from scratch. The computed basis is
+    /// wrong if those polynomials are not a Groebner basis. The default
+    /// is 0. If polyCount is larger than the number of polynomials, then
+    /// all of the polynomials are taken to be a Groebner basis.
+    void setKnownGroebnerBasisCount(size_t polyCount);
+    size_t knownGroebnerBasisCount() const;
+
   private:
     bool debugAssertValid() const;
     Exponent* const mExponents;
@@ -399,6 +513,119 @@ namespace mgb { // Part of the public interface of MathicGB
     OutputStream& output
   );
 
+  /// Holds the worker threads that Groebner basis computations run on.
+  /// Without a context, each call to computeGroebnerBasis starts up its
+  /// own threads and stops them again at the end, which can take longer
+  /// than computing a small Groebner basis. Passing the same context to
+  /// many computations lets them reuse the same threads.
+  ///
+  /// Computations can be started from different threads at the same time,
+  /// with or without a context and with the same or different contexts.
+  /// They then share the threads of the context. The exception is that a
+  /// computation with logging on runs alone, since the logging is global,
+  /// so it waits for the other computations and they wait for it. Do not
+  /// start a computation from inside a callback of another computation.
+  class GroebnerContext {
+  public:
+    /// Uses at most maxThreadCount threads. A value of 0 indicates to let
+    /// the library decide, which is also the default.
+    GroebnerContext(unsigned int maxThreadCount = 0);
+    ~GroebnerContext();
+
+    unsigned int maxThreadCount() const;
+
+  private:
+    friend class mgbi::PimplOf;
+
+    GroebnerContext(const GroebnerContext&); // not available
+    void operator=(const GroebnerContext&); // not available
+
+    struct Pimpl;
+    Pimpl* const mPimpl;
+  };
+
+  /// As computeGroebnerBasis(input, output), but the computation runs on
+  /// the threads of context. The maximum number of threads of context is
+  /// used instead of that of the configuration of input.
+  template<class OutputStream>
+  void computeGroebnerBasis(
+    GroebnerInputIdealStream& inputWhichWillBeCleared,
+    OutputStream& output,
+    GroebnerContext& context
+  );
+
+  /// Computes a Groebner basis of each of the count ideals
+  /// *inputsWhichWillBeCleared[i] and constructs it on outputs[i], as
+  /// computeGroebnerBasis would for each pair one at a time. The ideals are
+  /// computed in parallel with one task per ideal, which is much faster
+  /// than computing many small Groebner bases one after the other. Make
+  /// the input streams with a shared GroebnerContext to also share the
+  /// polynomial ring between ideals.
+  ///
+  /// The configurations of the inputs must have the same logging setting
+  /// and, unless a context is given, the same maximum number of threads,
+  /// since those are set up once for all of the ideals. Otherwise an error
+  /// is reported. While logging is on, the ideals are computed one at a
+  /// time so that their logs do not mix. The other settings are taken from
+  /// the configuration of each input. The configurations must not share a
+  /// checkpoint file.
+  ///
+  /// The outputs are constructed from inside the library's threads and
+  /// several outputs can be constructed at the same time, but each output is
+  /// only ever used from one thread at a time. The same goes for the
+  /// callbacks of the configurations.
+  template<class OutputStream>
+  void computeGroebnerBases(
+    GroebnerInputIdealStream* const* inputsWhichWillBeCleared,
+    OutputStream* outputs,
+    size_t count
+  );
+
+  /// As computeGroebnerBases(inputs, outputs, count), but the computations
+  /// run on the threads of context.
+  template<class OutputStream>
+  void computeGroebnerBases(
+    GroebnerInputIdealStream* const* inputsWhichWillBeCleared,
+    OutputStream* outputs,
+    size_t count,
+    GroebnerContext& context
+  );
+
+  /// A term of a polynomial with rational coefficients. The coefficient is
+  /// numerator divided by denominator, which are integers written in
+  /// decimal. The numerator can start with a minus sign and the denominator
+  /// must be positive. exponents[i] is the exponent of variable i.
+  struct RationalTerm {
+    std::string numerator;
+    std::string denominator;
+    std::vector<GroebnerConfiguration::Exponent> exponents;
+  };
+
+  /// The terms of a polynomial with rational coefficients. Two terms must
+  /// not have the same exponents.
+  typedef std::vector<RationalTerm> RationalPolynomial;
+
+  /// Returns the reduced Groebner basis over the rational numbers of the
+  /// ideal generated by ideal. The basis is computed modulo several primes
+  /// and the coefficients are lifted by Chinese remaindering and rational
+  /// reconstruction. The lifted basis is checked modulo one more prime,
+  /// which makes a wrong result unlikely but does not prove that the result
+  /// is correct.
+  ///
+  /// The number of variables, the monomial order, the reducer, the maximum
+  /// number of threads and the logging are taken from configuration. The
+  /// modulus and the other settings of configuration are not used.
+  /// configuration must have one component, since only ideals are
+  /// supported.
+  ///
+  /// Every basis element is monic with its terms in descending order and
+  /// the basis elements are in ascending order of their lead monomials.
+  /// The coefficients are in lowest terms.
+  std::vector<RationalPolynomial> computeRationalGroebnerBasis(
+    const GroebnerConfiguration& configuration,
+    const std::vector<RationalPolynomial>& ideal
+  );
+
   class NullIdealStream;
 
   /// Passes on all method calls to an inner ideal stream while printing out
@@ -618,6 +845,23 @@ namespace mgb {
     );
   }
 
+  inline void GroebnerConfiguration::setHilbertNumerator(
+    const std::vector<long long>& numerator
+  ) {
+    // See setMonomialOrder for why this does not use numerator.data().
+    const long long* const data = numerator.empty() ?
+      static_cast<const long long*>(0) : &*numerator.begin();
+    setHilbertNumeratorInternal(data, numerator.size());
+  }
+
+  inline std::vector<long long>
+    GroebnerConfiguration::hilbertNumerator() const
+  {
+    size_t size;
+    const long long* const numerator = hilbertNumeratorInternal(size);
+    return std::vector<long long>(numerator, numerator + size);
+  }
+
   inline GroebnerConfiguration::Callback::Action
   GroebnerConfiguration::callbackCaller(void* obj) {
     return static_cast<Callback*>(obj)->call();
@@ -881,7 +1125,11 @@ namespace mgb {
 
       VarIndex varCount() const;
       size_t polyCount() const;
+
+      /// Must not be called for a non-zero polynomial once all of its terms
+      /// have been read by nextTerm(), since it is freed at that point.
       size_t termCount(PolyIndex poly) const;
+
       Component componentCount() const;
 
       /// Sets the internal position to the first term of the first polynomial.
@@ -897,10 +1145,49 @@ namespace mgb {
       Pimpl* mPimpl;
     };
 
+    /// Runs on the threads of context if context is not null.
     bool internalComputeGroebnerBasis(
       GroebnerInputIdealStream& inputWhichWillBeCleared,
-      IdealAdapter& output
+      IdealAdapter& output,
+      GroebnerContext* context
+    );
+
+    /// Computes the Groebner basis of each of the count ideals in parallel
+    /// and calls output(outputData, i, basis) with the basis of
+    /// *inputsWhichWillBeCleared[i] as soon as it has been computed, unless
+    /// the callback of that ideal stopped the computation with no output.
+    /// Runs on the threads of context if context is not null.
+    void internalComputeGroebnerBases(
+      GroebnerInputIdealStream* const* inputsWhichWillBeCleared,
+      size_t count,
+      GroebnerContext* context,
+      void* outputData,
+      void (*output)(void*, size_t, IdealAdapter&)
+    );
+
+    template<class OutputStream>
+    void computeGroebnerBasis(
+      GroebnerInputIdealStream& inputWhichWillBeCleared,
+      OutputStream& output,
+      GroebnerContext* context
+    );
+
+    template<class OutputStream>
+    void computeGroebnerBases(
+      GroebnerInputIdealStream* const* inputsWhichWillBeCleared,
+      OutputStream* outputs,
+      size_t count,
+      GroebnerContext* context
     );
+
+    /// Constructs ideal on output.
+    template<class OutputStream>
+    void streamIdeal(IdealAdapter& ideal, OutputStream& output);
+
+    template<class OutputStream>
+    void streamIdealToIndex(void* outputs, size_t index, IdealAdapter& ideal) {
+      streamIdeal(ideal, static_cast<OutputStream*>(outputs)[index]);
+    }
   }
 
   template<class OutputStream>
@@ -908,12 +1195,70 @@ namespace mgb {
     GroebnerInputIdealStream& inputWhichWillBeCleared,
     OutputStream& output
   ) {
-    typedef mgbi::IdealAdapter::ConstTerm ConstTerm;
-    mgbi::IdealAdapter ideal;
+    mgbi::computeGroebnerBasis(inputWhichWillBeCleared, output, 0);
+  }
+
+  template<class OutputStream>
+  void computeGroebnerBasis(
+    GroebnerInputIdealStream& inputWhichWillBeCleared,
+    OutputStream& output,
+    GroebnerContext& context
+  ) {
+    mgbi::computeGroebnerBasis(inputWhichWillBeCleared, output, &context);
+  }
+
+  template<class OutputStream>
+  void mgbi::computeGroebnerBasis(
+    GroebnerInputIdealStream& inputWhichWillBeCleared,
+    OutputStream& output,
+    GroebnerContext* context
+  ) {
+    IdealAdapter ideal;
     const bool doOutput =
-      mgbi::internalComputeGroebnerBasis(inputWhichWillBeCleared, ideal);
-    if (!doOutput)
-      return;
+      internalComputeGroebnerBasis(inputWhichWillBeCleared, ideal, context);
+    if (doOutput)
+      streamIdeal(ideal, output);
+  }
+
+  template<class OutputStream>
+  void computeGroebnerBases(
+    GroebnerInputIdealStream* const* inputsWhichWillBeCleared,
+    OutputStream* outputs,
+    size_t count
+  ) {
+    mgbi::computeGroebnerBases(inputsWhichWillBeCleared, outputs, count, 0);
+  }
+
+  template<class OutputStream>
+  void computeGroebnerBases(
+    GroebnerInputIdealStream* const* inputsWhichWillBeCleared,
+    OutputStream* outputs,
+    size_t count,
+    GroebnerContext& context
+  ) {
+    mgbi::computeGroebnerBases
+      (inputsWhichWillBeCleared, outputs, count, &context);
+  }
+
+  template<class OutputStream>
+  void mgbi::computeGroebnerBases(
+    GroebnerInputIdealStream* const* inputsWhichWillBeCleared,
+    OutputStream* outputs,
+    size_t count,
+    GroebnerContext* context
+  ) {
+    internalComputeGroebnerBases(
+      inputsWhichWillBeCleared,
+      count,
+      context,
+      outputs,
+      &streamIdealToIndex<OutputStream>
+    );
+  }
+
+  template<class OutputStream>
+  void mgbi::streamIdeal(IdealAdapter& ideal, OutputStream& output) {
+    typedef IdealAdapter::ConstTerm ConstTerm;
 
     ideal.toFirstTerm();
     const size_t varCount = ideal.varCount();
@@ -35,6 +35,14 @@ public:
     MATHICGB_ASSERT(i < size());
     return mGenerators[i].get();
   }
+  /// Hands the polynomials over to the caller, leaving this basis empty.
+  /// No polynomials are copied.
+  std::vector<std::unique_ptr<Poly>> releaseGenerators() {
+    std::vector<std::unique_ptr<Poly>> generators;
+    generators.swap(mGenerators);
+    return generators;
+  }
+
   size_t size() const {return mGenerators.size();}
   bool empty() const {return mGenerators.empty();}
   void reserve(size_t size) {mGenerators.reserve(size);}
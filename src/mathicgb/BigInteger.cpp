@@ -0,0 +1,281 @@
+// MathicGB copyright 2012 all rights reserved. MathicGB comes with ABSOLUTELY
+// NO WARRANTY and is licensed as GPL v2.0 or later - see LICENSE.txt.
+#include "stdinc.h"
+#include "BigInteger.hpp"
+
+#include <mathic.h>
+#include <algorithm>
+
+MATHICGB_NAMESPACE_BEGIN
+
+namespace {
+  // The functions in this namespace work on absolute values stored as in
+  // BigInteger::mLimbs.
+  typedef std::vector<uint32> Limbs;
+
+  void trim(Limbs& a) {
+    while (!a.empty() && a.back() == 0)
+      a.pop_back();
+  }
+
+  int compareAbs(const Limbs& a, const Limbs& b) {
+    if (a.size() != b.size())
+      return a.size() < b.size() ? -1 : 1;
+    for (auto i = a.size(); i > 0; --i)
+      if (a[i - 1] != b[i - 1])
+        return a[i - 1] < b[i - 1] ? -1 : 1;
+    return 0;
+  }
+
+  /// Sets a to a + b.
+  void addAbs(Limbs& a, const Limbs& b) {
+    if (a.size() < b.size())
+      a.resize(b.size());
+    uint64 carry = 0;
+    for (size_t i = 0; i < a.size(); ++i) {
+      const uint64 sum = carry + a[i] + (i < b.size() ? b[i] : 0);
+      a[i] = static_cast<uint32>(sum);
+      carry = sum >> 32;
+    }
+    if (carry != 0)
+      a.push_back(static_cast<uint32>(carry));
+  }
+
+  /// Sets a to a - b. a must not be less than b.
+  void subtractAbs(Limbs& a, const Limbs& b) {
+    MATHICGB_ASSERT(compareAbs(a, b) >= 0);
+    uint32 borrow = 0;
+    for (size_t i = 0; i < a.size(); ++i) {
+      const uint64 subtrahend = static_cast<uint64>(borrow) +
+        (i < b.size() ? b[i] : 0);
+      borrow = a[i] < subtrahend;
+      a[i] = static_cast<uint32>(a[i] - subtrahend);
+      if (borrow == 0 && i >= b.size())
+        break;
+    }
+    MATHICGB_ASSERT(borrow == 0);
+    trim(a);
+  }
+
+  Limbs multiplyAbs(const Limbs& a, const Limbs& b) {
+    if (a.empty() || b.empty())
+      return Limbs();
+    Limbs product(a.size() + b.size());
+    for (size_t i = 0; i < a.size(); ++i) {
+      uint64 carry = 0;
+      for (size_t j = 0; j < b.size(); ++j) {
+        const uint64 sum = static_cast<uint64>(a[i]) * b[j] +
+          product[i + j] + carry;
+        product[i + j] = static_cast<uint32>(sum);
+        carry = sum >> 32;
+      }
+      product[i + b.size()] = static_cast<uint32>(carry);
+    }
+    trim(product);
+    return product;
+  }
+
+  /// Sets a to a * factor + term.
+  void multiplyAddAbs(Limbs& a, const uint32 factor, const uint32 term) {
+    uint64 carry = term;
+    for (auto& limb : a) {
+      const uint64 sum = static_cast<uint64>(limb) * factor + carry;
+      limb = static_cast<uint32>(sum);
+      carry = sum >> 32;
+    }
+    if (carry != 0)
+      a.push_back(static_cast<uint32>(carry));
+  }
+
+  /// Sets a to a / divisor rounded down and returns a % divisor.
+  uint32 divideAbs(Limbs& a, const uint32 divisor) {
+    MATHICGB_ASSERT(divisor != 0);
+    uint64 remainder = 0;
+    for (auto i = a.size(); i > 0; --i) {
+      const uint64 dividend = (remainder << 32) | a[i - 1];
+      a[i - 1] = static_cast<uint32>(dividend / divisor);
+      remainder = dividend % divisor;
+    }
+    trim(a);
+    return static_cast<uint32>(remainder);
+  }
+
+  size_t bitCount(const Limbs& a) {
+    if (a.empty())
+      return 0;
+    size_t count = 32 * (a.size() - 1);
+    for (auto top = a.back(); top != 0; top >>= 1)
+      ++count;
+    return count;
+  }
+
+  /// Sets a to a * 2^shift.
+  void shiftLeftAbs(Limbs& a, const size_t shift) {
+    if (a.empty())
+      return;
+    const auto limbShift = shift / 32;
+    const auto bitShift = shift % 32;
+    if (bitShift != 0) {
+      uint32 carry = 0;
+      for (auto& limb : a) {
+        const auto shifted = (limb << bitShift) | carry;
+        carry = limb >> (32 - bitShift);
+        limb = shifted;
+      }
+      if (carry != 0)
+        a.push_back(carry);
+    }
+    a.insert(a.begin(), limbShift, 0);
+  }
+
+  /// Sets a to a / 2 rounded down.
+  void halveAbs(Limbs& a) {
+    for (size_t i = 0; i < a.size(); ++i) {
+      a[i] >>= 1;
+      if (i + 1 < a.size())
+        a[i] |= a[i + 1] << 31;
+    }
+    trim(a);
+  }
+
+  /// Sets quotient to a / b rounded down and a to a % b. This is binary long
+  /// division, which takes time proportional to the number of bits of the
+  /// quotient times the number of limbs of a. That is fast for the small
+  /// quotients of Euclid's algorithm.
+  void divideAbs(Limbs& a, const Limbs& b, Limbs& quotient) {
+    MATHICGB_ASSERT(!b.empty());
+    quotient.clear();
+    if (compareAbs(a, b) < 0)
+      return;
+    const auto shift = bitCount(a) - bitCount(b);
+    auto shifted = b;
+    shiftLeftAbs(shifted, shift);
+    quotient.resize(shift / 32 + 1);
+    for (auto bit = shift + 1; bit > 0; --bit) {
+      if (compareAbs(a, shifted) >= 0) {
+        subtractAbs(a, shifted);
+        quotient[(bit - 1) / 32] |= static_cast<uint32>(1) << ((bit - 1) % 32);
+      }
+      halveAbs(shifted);
+    }
+    trim(quotient);
+  }
+}
+
+BigInteger::BigInteger(const int64 value): mNegative(value < 0) {
+  // Negating in unsigned arithmetic also works for the smallest int64.
+  auto abs = static_cast<uint64>(value);
+  if (mNegative)
+    abs = 0 - abs;
+  for (; abs != 0; abs >>= 32)
+    mLimbs.push_back(static_cast<Limb>(abs));
+}
+
+BigInteger BigInteger::fromString(const std::string& text) {
+  const bool negative = !text.empty() && text[0] == '-';
+  const size_t begin = negative ? 1 : 0;
+  if (begin == text.size())
+    mathic::reportError("Expected an integer, but got \"" + text + "\".");
+
+  BigInteger value;
+  for (size_t i = begin; i < text.size(); ++i) {
+    if (text[i] < '0' || text[i] > '9')
+      mathic::reportError("Expected an integer, but got \"" + text + "\".");
+    multiplyAddAbs(value.mLimbs, 10, static_cast<uint32>(text[i] - '0'));
+  }
+  trim(value.mLimbs);
+  value.mNegative = negative && !value.isZero();
+  return value;
+}
+
+std::string BigInteger::toString() const {
+  if (isZero())
+    return "0";
+
+  // Split off 9 decimal digits at a time, starting from the back.
+  std::string text;
+  auto abs = mLimbs;
+  while (!abs.empty()) {
+    auto chunk = divideAbs(abs, 1000000000);
+    for (int digit = 0; digit < 9 && (chunk != 0 || !abs.empty()); ++digit) {
+      text.push_back(static_cast<char>('0' + chunk % 10));
+      chunk /= 10;
+    }
+  }
+  if (mNegative)
+    text.push_back('-');
+  std::reverse(text.begin(), text.end());
+  return text;
+}
+
+uint32 BigInteger::residue(const uint32 m) const {
+  MATHICGB_ASSERT(m != 0);
+  uint64 r = 0;
+  for (auto i = mLimbs.size(); i > 0; --i)
+    r = ((r << 32) | mLimbs[i - 1]) % m;
+  if (mNegative && r != 0)
+    r = m - r;
+  return static_cast<uint32>(r);
+}
+
+BigInteger BigInteger::operator-() const {
+  auto negated = *this;
+  negated.mNegative = !mNegative && !isZero();
+  return negated;
+}
+
+BigInteger& BigInteger::operator+=(const BigInteger& b) {
+  if (mNegative == b.mNegative)
+    addAbs(mLimbs, b.mLimbs);
+  else if (compareAbs(mLimbs, b.mLimbs) >= 0)
+    subtractAbs(mLimbs, b.mLimbs);
+  else {
+    auto limbs = b.mLimbs;
+    subtractAbs(limbs, mLimbs);
+    mLimbs.swap(limbs);
+    mNegative = b.mNegative;
+  }
+  if (isZero())
+    mNegative = false;
+  return *this;
+}
+
+BigInteger& BigInteger::operator-=(const BigInteger& b) {
+  return *this += -b;
+}
+
+BigInteger& BigInteger::operator*=(const BigInteger& b) {
+  mLimbs = multiplyAbs(mLimbs, b.mLimbs);
+  mNegative = mNegative != b.mNegative && !isZero();
+  return *this;
+}
+
+void BigInteger::divide(
+  const BigInteger& a,
+  const BigInteger& b,
+  BigInteger& quotient,
+  BigInteger& remainder
+) {
+  if (b.isZero())
+    mathic::reportInternalError("BigInteger: division by zero.");
+  // quotient and remainder can be the same objects as a and b, so a and b
+  // are not used once quotient or remainder has been changed.
+  const bool quotientNegative = a.mNegative != b.mNegative;
+  const bool remainderNegative = a.mNegative;
+  auto remainderLimbs = a.mLimbs;
+  Limbs quotientLimbs;
+  divideAbs(remainderLimbs, b.mLimbs, quotientLimbs);
+  quotient.mLimbs.swap(quotientLimbs);
+  quotient.mNegative = quotientNegative && !quotient.isZero();
+  remainder.mLimbs.swap(remainderLimbs);
+  remainder.mNegative = remainderNegative && !remainder.isZero();
+}
+
+int BigInteger::compare(const BigInteger& a, const BigInteger& b) {
+  if (a.mNegative != b.mNegative)
+    return a.mNegative ? -1 : 1;
+  const auto abs = compareAbs(a.mLimbs, b.mLimbs);
+  return a.mNegative ? -abs : abs;
+}
+
+MATHICGB_NAMESPACE_END
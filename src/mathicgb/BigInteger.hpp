@@ -0,0 +1,89 @@
+// MathicGB copyright 2012 all rights reserved. MathicGB comes with ABSOLUTELY
+// NO WARRANTY and is licensed as GPL v2.0 or later - see LICENSE.txt.
+#ifndef MATHICGB_BIG_INTEGER_GUARD
+#define MATHICGB_BIG_INTEGER_GUARD
+
+#include <vector>
+#include <string>
+#include <ostream>
+
+MATHICGB_NAMESPACE_BEGIN
+
+/// An integer of any size. Only the arithmetic that MultiModularGB needs to
+/// lift coefficients to the rational numbers is supported. The algorithms
+/// are the schoolbook ones, which is fast enough for coefficients of a few
+/// thousand bits.
+class BigInteger {
+public:
+  /// The value is zero.
+  BigInteger(): mNegative(false) {}
+
+  BigInteger(int64 value);
+
+  /// Reads an optional minus sign followed by one or more decimal digits.
+  /// Reports an error if text is not of that form.
+  static BigInteger fromString(const std::string& text);
+
+  /// Returns the value in decimal with a minus sign if it is negative.
+  std::string toString() const;
+
+  bool isZero() const {return mLimbs.empty();}
+  bool isNegative() const {return mNegative;}
+
+  /// Returns the value modulo m in the range [0, m). m must not be zero.
+  uint32 residue(uint32 m) const;
+
+  BigInteger operator-() const;
+  BigInteger& operator+=(const BigInteger& b);
+  BigInteger& operator-=(const BigInteger& b);
+  BigInteger& operator*=(const BigInteger& b);
+
+  /// Sets quotient and remainder so that a equals quotient * b + remainder,
+  /// rounding the quotient towards zero as the built-in integer types do.
+  /// b must not be zero.
+  static void divide(
+    const BigInteger& a,
+    const BigInteger& b,
+    BigInteger& quotient,
+    BigInteger& remainder
+  );
+
+  /// Returns a negative number, zero or a positive number if a is less
+  /// than, equal to or greater than b, respectively.
+  static int compare(const BigInteger& a, const BigInteger& b);
+
+private:
+  typedef uint32 Limb;
+  typedef std::vector<Limb> Limbs;
+
+  bool mNegative; // never true for zero
+  Limbs mLimbs; // the absolute value in base 2^32, least significant first,
+                // and without zeroes at the end
+};
+
+inline BigInteger operator+(BigInteger a, const BigInteger& b) {return a += b;}
+inline BigInteger operator-(BigInteger a, const BigInteger& b) {return a -= b;}
+inline BigInteger operator*(BigInteger a, const BigInteger& b) {return a *= b;}
+
+inline bool operator==(const BigInteger& a, const BigInteger& b) {
+  return BigInteger::compare(a, b) == 0;
+}
+
+inline bool operator!=(const BigInteger& a, const BigInteger& b) {
+  return BigInteger::compare(a, b) != 0;
+}
+
+inline bool operator<(const BigInteger& a, const BigInteger& b) {
+  return BigInteger::compare(a, b) < 0;
+}
+
+inline bool operator<=(const BigInteger& a, const BigInteger& b) {
+  return BigInteger::compare(a, b) <= 0;
+}
+
+inline std::ostream& operator<<(std::ostream& out, const BigInteger& value) {
+  return out << value.toString();
+}
+
+MATHICGB_NAMESPACE_END
+#endif
@@ -9,6 +9,11 @@
 #include "Basis.hpp"
 #include "LogDomain.hpp"
 #include "MathicIO.hpp"
+#include "GBCheckpoint.hpp"
+#include "ClassicGBTrace.hpp"
+#include "MemoryAccount.hpp"
+#include <algorithm>
+#include <chrono>
 #include <iostream>
 #include <mathic.h>
 #include <memory>
@@ -27,19 +32,27 @@ MATHICGB_DEFINE_LOG_DOMAIN(
   "algorithm."
 );
 
+MATHICGB_DEFINE_LOG_DOMAIN(
+  MemoryBudget,
+  "Displays the steps taken to stay within the memory budget."
+);
+
 MATHICGB_NAMESPACE_BEGIN
 
 /// Calculates a classic Grobner basis using Buchberger's algorithm.
 class ClassicGBAlg {
 public:
+  /// The generators are taken out of basis, which is left empty.
   ClassicGBAlg(
-    const Basis& basis,
+    Basis& basis,
     Reducer& reducer,
     int monoLookupType,
     bool preferSparseReducers,
     size_t queueType
   );
 
+  ~ClassicGBAlg();
+
   // Replaces the current basis with a Grobner basis of the same ideal.
   void computeGrobnerBasis();
 
@@ -53,10 +66,25 @@ public:
   // Shows statistics on what the algorithm has done.
   void printStats(std::ostream& out) const;
 
+  /// Prints the current and peak memory use of each part of the
+  /// computation as of the last step.
   void printMemoryUse(std::ostream& out) const;
 
   size_t getMemoryUse() const;
 
+  const MemoryAccount& memoryAccount() const {return mMemoryAccount;}
+
+  /// Sets the number of bytes of memory that the computation should try to
+  /// stay within. A budget of 0, which is the default, means that there is
+  /// no budget. Memory use is checked after each step. If it has gone over
+  /// the budget, then the number of S-pairs reduced at a time is halved for
+  /// the rest of the computation. Once S-pairs are reduced one at a time,
+  /// an F4 reducer hands them to its classic fall-back reducer, which does
+  /// not build matrices. Reducers can also drop their caches while the
+  /// budget is exceeded. The computation never stops due to the budget, so
+  /// it can still run out of memory.
+  void setMemoryBudget(size_t bytes) {mMemoryAccount.setBudget(bytes);}
+
   void setBreakAfter(unsigned int elements) {
     mBreakAfter = elements;
   }
@@ -81,6 +109,83 @@ public:
     mUseAutoTailReduction = value;
   }
 
+  /// If value is true, then once a Groebner basis has been computed it is
+  /// made into the reduced Groebner basis by tail reducing all of its
+  /// elements in one go.
+  void setUseFinalInterreduction(bool value) {
+    mUseFinalInterreduction = value;
+  }
+
+  /// If value is true, S-pairs are selected by their sugar degree, so the
+  /// groups of S-pairs reduced together have the same sugar degree rather
+  /// than the same degree. This helps for inhomogeneous ideals. Must be
+  /// called before anything has been inserted into the basis.
+  void setUseSugar(bool value) {
+    mUseSugar = value;
+    mSPairs.setUseSugar(value);
+  }
+
+  /// Write checkpoints to the file fileName every intervalSeconds seconds,
+  /// when GBCheckpoint::request() has been called and when the computation
+  /// ends. An intervalSeconds of 0 disables the periodic checkpoints.
+  /// inputHash is as for GBCheckpoint::inputHash.
+  void setCheckpoint(
+    const std::string& fileName,
+    unsigned int intervalSeconds,
+    uint64 inputHash
+  );
+
+  /// Records the groups of S-pairs that are reduced into trace. trace can
+  /// be null, in which case nothing is recorded.
+  void setRecordTrace(ClassicGBTrace* trace) {mRecordTrace = trace;}
+
+  /// Skips the groups of S-pairs that reduced to zero in trace and builds
+  /// the matrices of the other groups from the plans in trace, for as long
+  /// as the computation agrees with trace. trace can be null, in which case
+  /// nothing is replayed.
+  void setReplayTrace(const ClassicGBTrace* trace) {
+    mReplayTrace = trace;
+    mReplayGroup = 0;
+  }
+
+  /// Returns the number of groups of S-pairs skipped due to the replay trace.
+  size_t skippedGroupCount() const {return mSkippedGroupCount;}
+
+  /// Sets the numerator N(t) of the Hilbert series N(t)/(1-t)^n of R/I,
+  /// where R is the polynomial ring in n variables and I is the ideal
+  /// whose basis is being computed. Element i is the coefficient of t^i.
+  /// The input must then be homogeneous with respect to the total degree.
+  /// An S-pair is skipped if the lead monomials of the basis already have
+  /// the Hilbert function of I in the degree of the S-pair, since then
+  /// every S-polynomial of that degree reduces to zero. An empty
+  /// numerator, which is the default, turns this off.
+  void setHilbertNumerator(std::vector<long long> numerator) {
+    mHilbertNumerator = std::move(numerator);
+  }
+
+  /// Returns the number of S-pairs skipped due to the Hilbert numerator.
+  unsigned long long hilbertSkippedPairCount() const {
+    return mHilbertSkippedPairCount;
+  }
+
+  /// Continues the computation from state, which must be read from a
+  /// checkpoint of a computation of the same ideal. Must be called before
+  /// anything has been inserted into the basis.
+  void restore(GBCheckpoint::State&& state);
+
+  /// Inserts the polynomials of groebnerBasis, which must be a Groebner
+  /// basis of the ideal that they generate, without considering the
+  /// S-pairs between them. Polynomials whose lead monomial is divisible by
+  /// the lead monomial of another polynomial are left out. Must be called
+  /// before anything has been inserted into the basis.
+  void insertGroebnerBasis(std::vector<std::unique_ptr<Poly>>&& groebnerBasis);
+
+  /// Reduces the polynomials and inserts them into the basis along with
+  /// their S-pairs.
+  void insertGenerators(std::vector<std::unique_ptr<Poly>>&& polys) {
+    insertPolys(polys);
+  }
+
   /// callback is called every once in a while and then it has the
   /// option of stopping the computation. callback can be null, in
   /// which case no call is made and the computation continues.
@@ -95,14 +200,67 @@ private:
   unsigned int mSPairGroupSize;
   bool mUseAutoTopReduction;
   bool mUseAutoTailReduction;
+  bool mUseFinalInterreduction;
+  bool mUseSugar;
+
+  /// The minimum sugar of the polynomials inserted into the basis. This is
+  /// the sugar of the S-pairs being reduced, if sugar is being used.
+  exponent mInsertSugar;
 
   // Perform a step of the algorithm.
   void step();
 
   void autoTailReduce();
 
+  /// Retires the basis elements that are not lead minimal and tail reduces
+  /// the rest. Only valid once the basis is a Groebner basis.
+  void interreduce();
+
   void insertReducedPoly(std::unique_ptr<Poly> poly);
 
+  /// Records the current memory use and reduces the S-pair group size if
+  /// the memory budget has been exceeded. lastGroupSize is the number of
+  /// S-pairs that were just reduced together.
+  void updateMemoryAccount(size_t lastGroupSize);
+
+  /// Returns true if the replay trace says that all the S-polynomials of
+  /// group reduce to zero. Stops replaying the trace if group is not the
+  /// next group in the trace.
+  bool replaySaysZero(const std::vector<std::pair<size_t, size_t>>& group);
+
+  /// Returns the S-pair at index within the next group of the replay
+  /// trace, or (invalid,invalid) if there is no such S-pair.
+  std::pair<size_t, size_t> replayPair(size_t index) const;
+
+  /// Returns true if the Hilbert function shows that the S-polynomial of
+  /// the pair (a, b) reduces to zero.
+  bool hilbertSaysZero(size_t a, size_t b);
+
+  /// Reports an error if the basis is not homogeneous with respect to the
+  /// total degree or if it is not the basis of an ideal.
+  void checkHilbertInput() const;
+
+  /// Returns the value in degree of the Hilbert function of R/I according
+  /// to the Hilbert numerator.
+  unsigned long long expectedHilbertFunction(exponent degree) const;
+
+  /// Adds to count the number of monomials of total degree degree whose
+  /// exponents of the variables before var are those of mono and that are
+  /// not divisible by any lead monomial of the basis. Stops once count
+  /// exceeds limit.
+  void countStandardMonomials(
+    size_t var,
+    exponent degree,
+    Monoid::MonoRef mono,
+    unsigned long long limit,
+    unsigned long long& count
+  ) const;
+
+  /// Returns true if it is time to write a periodic or requested checkpoint.
+  bool checkpointDue() const;
+
+  void writeCheckpoint();
+
   // clears polynomials.
   void insertPolys(std::vector<std::unique_ptr<Poly> >& polynomials);
 
@@ -112,10 +270,37 @@ private:
   SPairs mSPairs;
   mic::Timer mTimer;
   unsigned long long mSPolyReductionCount;
+
+  MemoryAccount mMemoryAccount;
+
+  std::unique_ptr<GBCheckpoint> mCheckpoint;
+  std::chrono::seconds mCheckpointInterval;
+  std::chrono::steady_clock::time_point mLastCheckpoint;
+
+  /// The S-pairs reduced since the last checkpoint.
+  std::vector<GBCheckpoint::Pair> mHandledPairs;
+
+  ClassicGBTrace* mRecordTrace;
+  const ClassicGBTrace* mReplayTrace;
+  size_t mReplayGroup;
+  size_t mSkippedGroupCount;
+
+  std::vector<long long> mHilbertNumerator;
+  unsigned long long mHilbertSkippedPairCount;
+
+  /// mHilbertComplete[d] is true if the lead monomials of the basis have
+  /// the expected Hilbert function in degree d.
+  std::vector<bool> mHilbertComplete;
+
+  /// The basis size when mHilbertIncompleteDegree was last found to be
+  /// incomplete. The lead monomials only change when an element is added,
+  /// so the degree does not have to be checked again until then.
+  size_t mHilbertCheckedBasisSize;
+  exponent mHilbertIncompleteDegree;
 };
 
 ClassicGBAlg::ClassicGBAlg(
-  const Basis& basis,
+  Basis& basis,
   Reducer& reducer,
   int monoLookupType,
   bool preferSparseReducers,
@@ -127,6 +312,9 @@ ClassicGBAlg::ClassicGBAlg(
   mSPairGroupSize(reducer.preferredSetSize()),
   mUseAutoTopReduction(true),
   mUseAutoTailReduction(false),
+  mUseFinalInterreduction(false),
+  mUseSugar(false),
+  mInsertSugar(0),
   mRing(*basis.getPolyRing()),
   mReducer(reducer),
   mBasis(mRing,
@@ -136,16 +324,27 @@ ClassicGBAlg::ClassicGBAlg(
     )->make(preferSparseReducers, true)
   ),
   mSPairs(mBasis, preferSparseReducers),
-  mSPolyReductionCount(0)
+  mSPolyReductionCount(0),
+  mCheckpointInterval(0),
+  mRecordTrace(nullptr),
+  mReplayTrace(nullptr),
+  mReplayGroup(0),
+  mSkippedGroupCount(0),
+  mHilbertSkippedPairCount(0),
+  mHilbertCheckedBasisSize(static_cast<size_t>(-1)),
+  mHilbertIncompleteDegree(0)
 {
+  mReducer.setMemoryAccount(&mMemoryAccount);
+
   // Reduce and insert the generators of the ideal into the starting basis
-  size_t const basisSize = basis.size();
-  std::vector<std::unique_ptr<Poly> > polys;
-  for (size_t gen = 0; gen != basisSize; ++gen)
-    polys.push_back(make_unique<Poly>(*basis.getPoly(gen)));
+  auto polys = basis.releaseGenerators();
   insertPolys(polys);
 }
 
+ClassicGBAlg::~ClassicGBAlg() {
+  mReducer.setMemoryAccount(nullptr);
+}
+
 void ClassicGBAlg::setSPairGroupSize(unsigned int groupSize) {
   if (groupSize == 0)
     groupSize = mReducer.preferredSetSize();
@@ -153,6 +352,75 @@ void ClassicGBAlg::setSPairGroupSize(unsigned int groupSize) {
     mSPairGroupSize = groupSize;
 }
 
+void ClassicGBAlg::setCheckpoint(
+  const std::string& fileName,
+  const unsigned int intervalSeconds,
+  const uint64 inputHash
+) {
+  mCheckpoint = make_unique<GBCheckpoint>(fileName, mRing, inputHash);
+  mCheckpointInterval = std::chrono::seconds(intervalSeconds);
+  mLastCheckpoint = std::chrono::steady_clock::now();
+}
+
+void ClassicGBAlg::restore(GBCheckpoint::State&& state) {
+  MATHICGB_ASSERT(mBasis.size() == 0);
+  MATHICGB_ASSERT(state.sugar.size() == state.basis.size());
+  for (size_t i = 0; i < state.basis.size(); ++i) {
+    if (state.basis[i] == nullptr)
+      mBasis.insertRetired();
+    else
+      mBasis.insert(std::move(state.basis[i]), state.sugar[i]);
+  }
+  mSPairs.restorePairs(state.handledPairs);
+  mSPolyReductionCount = state.sPolyReductionCount;
+
+  // The first checkpoint written rewrites the file from scratch, so it has
+  // to include the pairs handled before the computation was resumed.
+  if (mCheckpoint != nullptr)
+    mHandledPairs = std::move(state.handledPairs);
+}
+
+void ClassicGBAlg::insertGroebnerBasis(
+  std::vector<std::unique_ptr<Poly>>&& groebnerBasis
+) {
+  MATHICGB_ASSERT(mBasis.size() == 0);
+  const auto& monoid = mRing.monoid();
+
+  // A divisor of a monomial is not greater than it, so after sorting the
+  // lead monomials ascending a polynomial with a non-minimal lead monomial
+  // comes after a divisor of its lead monomial.
+  auto polys = std::move(groebnerBasis);
+  polys.erase(
+    std::remove_if(polys.begin(), polys.end(),
+      [](const std::unique_ptr<Poly>& p) {return p->isZero();}),
+    polys.end()
+  );
+  std::sort(polys.begin(), polys.end(),
+    [&](const std::unique_ptr<Poly>& a, const std::unique_ptr<Poly>& b) {
+      return monoid.lessThan(a->leadMono(), b->leadMono());
+    }
+  );
+  for (auto it = polys.begin(); it != polys.end(); ++it)
+    if (mBasis.divisor((*it)->leadMono()) == static_cast<size_t>(-1))
+      mBasis.insert(std::move(*it));
+  mSPairs.addGroebnerBasis();
+}
+
+bool ClassicGBAlg::checkpointDue() const {
+  MATHICGB_ASSERT(mCheckpoint != nullptr);
+  if (mCheckpoint->takeRequest())
+    return true;
+  return
+    mCheckpointInterval.count() != 0 &&
+    std::chrono::steady_clock::now() - mLastCheckpoint >= mCheckpointInterval;
+}
+
+void ClassicGBAlg::writeCheckpoint() {
+  MATHICGB_ASSERT(mCheckpoint != nullptr);
+  mCheckpoint->write(mBasis, mHandledPairs, mSPolyReductionCount);
+  mLastCheckpoint = std::chrono::steady_clock::now();
+}
+
 void ClassicGBAlg::insertPolys(
   std::vector<std::unique_ptr<Poly> >& polynomials
 ) {
@@ -167,7 +435,7 @@ void ClassicGBAlg::insertPolys(
           continue;
       }
 
-      mBasis.insert(std::move(*it));
+      mBasis.insert(std::move(*it), mInsertSugar);
       mSPairs.addPairs(mBasis.size() - 1);
     }
     polynomials.clear();
@@ -201,7 +469,7 @@ void ClassicGBAlg::insertPolys(
           MathicIO<>().writePoly(**it, true, stream);
           stream << '\n';
         };
-        mBasis.insert(std::move(*it));
+        mBasis.insert(std::move(*it), mInsertSugar);
         MATHICGB_ASSERT(toRetire.empty());
         mSPairs.addPairsAssumeAutoReduce(mBasis.size() - 1, toRetire);
         for (auto r = toRetire.begin(); r != toRetire.end(); ++r)
@@ -249,7 +517,7 @@ void ClassicGBAlg::insertReducedPoly(
 
   if (!mUseAutoTopReduction) {
     size_t const newGen = mBasis.size();
-    mBasis.insert(std::move(polyToInsert));
+    mBasis.insert(std::move(polyToInsert), mInsertSugar);
     mSPairs.addPairs(newGen);
     return;
   }
@@ -286,7 +554,7 @@ void ClassicGBAlg::insertReducedPoly(
         if (reduced->isZero())
           continue;
         reduced->makeMonic(); 
-        mBasis.insert(std::move(reduced));
+        mBasis.insert(std::move(reduced), mInsertSugar);
       }
 
       // form S-pairs and retire basis elements that become top reducible.
@@ -316,6 +584,8 @@ void ClassicGBAlg::computeGrobnerBasis() {
 
   if (mUseAutoTailReduction)
     autoTailReduce();
+  if (!mHilbertNumerator.empty())
+    checkHilbertInput();
 
   while (!mSPairs.empty()) {
     if (mCallback != nullptr && !mCallback())
@@ -330,16 +600,17 @@ void ClassicGBAlg::computeGrobnerBasis() {
     }
     if (mPrintInterval != 0 && (++counter % mPrintInterval) == 0)
       printStats(std::cerr);
+    if (mCheckpoint != nullptr && checkpointDue())
+      writeCheckpoint();
   }
-  if (mPrintInterval != 0)
+  if (mCheckpoint != nullptr)
+    writeCheckpoint();
+  if (mUseFinalInterreduction && mSPairs.empty())
+    interreduce();
+  if (mPrintInterval != 0) {
     printStats(std::cerr);
-  //mReducer->dump();
-  /*
-  for (size_t i = 0; i < mBasis.size(); ++i)
-    if (!mBasis.retired(i))
-      mBasis.replaceSameLeadTerm
-        (i, mReducer->classicTailReduce(mBasis.poly(i), mBasis));
-        */
+    printMemoryUse(std::cerr);
+  }
 }
 
 void ClassicGBAlg::step() {
@@ -350,8 +621,8 @@ void ClassicGBAlg::step() {
   MATHICGB_ASSERT(mSPairGroupSize >= 1);
   std::vector<std::pair<size_t, size_t> > spairGroup;
   exponent w = 0;
-  for (unsigned int i = 0; i < mSPairGroupSize; ++i) {
-    auto p = mSPairs.pop(w);
+  while (spairGroup.size() < mSPairGroupSize) {
+    auto p = mSPairs.pop(w, replayPair(spairGroup.size()));
     if (p.first == static_cast<size_t>(-1)) {
       MATHICGB_ASSERT(p.second == static_cast<size_t>(-1));
       break; // no more S-pairs
@@ -360,18 +631,58 @@ void ClassicGBAlg::step() {
     MATHICGB_ASSERT(p.second != static_cast<size_t>(-1));
     MATHICGB_ASSERT(!mBasis.retired(p.first));
     MATHICGB_ASSERT(!mBasis.retired(p.second));
-    
+
+    if (!mHilbertNumerator.empty() && hilbertSaysZero(p.first, p.second)) {
+      ++mHilbertSkippedPairCount;
+      if (mCheckpoint != nullptr)
+        mHandledPairs.push_back(p);
+      continue;
+    }
     spairGroup.push_back(p);
   }
   if (spairGroup.empty())
     return; // no more s-pairs
+  mSPolyReductionCount += spairGroup.size();
+  if (mCheckpoint != nullptr)
+    mHandledPairs.insert
+      (mHandledPairs.end(), spairGroup.begin(), spairGroup.end());
   std::vector<std::unique_ptr<Poly>> reduced;
 
-  // w is the negative of the degree of the lcm's of the chosen spairs
-  MATHICGB_LOG(SPairDegree) <<
-    spairGroup.size() << " pairs in degree " << -w << std::endl;
+  // w is the negative of the degree of the lcm's of the chosen spairs,
+  // or the sugar degree of the chosen spairs if using sugar.
+  MATHICGB_LOG(SPairDegree) << spairGroup.size() << " pairs in " <<
+    (mUseSugar ? "sugar degree " : "degree ") << (mUseSugar ? w : -w) <<
+    std::endl;
 
-  mReducer.classicReduceSPolySet(spairGroup, mBasis, reduced);
+  F4MatrixPlan* recordPlan = nullptr;
+  if (mRecordTrace != nullptr) {
+    mRecordTrace->matrixPlans.emplace_back();
+    recordPlan = &mRecordTrace->matrixPlans.back();
+  }
+  if (replaySaysZero(spairGroup))
+    ++mSkippedGroupCount;
+  else {
+    const F4MatrixPlan* replayPlan = nullptr;
+    if (
+      mReplayTrace != nullptr &&
+      mReplayGroup - 1 < mReplayTrace->matrixPlans.size()
+    )
+      replayPlan = &mReplayTrace->matrixPlans[mReplayGroup - 1];
+    mReducer.setMatrixPlans(recordPlan, replayPlan);
+    mReducer.classicReduceSPolySet(spairGroup, mBasis, reduced);
+    mReducer.setMatrixPlans(nullptr, nullptr);
+    if (
+      mReplayTrace != nullptr &&
+      mReplayTrace->nonZeroCounts[mReplayGroup - 1] != reduced.size()
+    )
+      mReplayTrace = nullptr; // the computation no longer follows the trace
+  }
+  if (mRecordTrace != nullptr) {
+    auto& trace = *mRecordTrace;
+    trace.pairs.insert(trace.pairs.end(), spairGroup.begin(), spairGroup.end());
+    trace.groupEnds.push_back(trace.pairs.size());
+    trace.nonZeroCounts.push_back(reduced.size());
+  }
 
   // sort the elements to get deterministic behavior. The order will change
   // arbitrarily when running multithreaded. Also, if preferring older
@@ -409,10 +720,209 @@ void ClassicGBAlg::step() {
     return false;
   };
   std::sort(reduced.begin(), reduced.end(), order);
-  
+
+  if (mUseSugar)
+    mInsertSugar = w;
   insertPolys(reduced);
+  mInsertSugar = 0;
   if (mUseAutoTailReduction)
     autoTailReduce();
+  updateMemoryAccount(spairGroup.size());
+}
+
+void ClassicGBAlg::updateMemoryAccount(const size_t lastGroupSize) {
+  mMemoryAccount.setUse(MemoryAccount::BasisMemory, mBasis.getMemoryUse());
+  mMemoryAccount.setUse(MemoryAccount::SPairMemory, mSPairs.getMemoryUse());
+  mMemoryAccount.setUse
+    (MemoryAccount::ReducerMemory, mReducer.getMemoryUse());
+  mMemoryAccount.setUse(MemoryAccount::MonomialMemory, mRing.getMemoryUse());
+  if (!mMemoryAccount.takeBudgetExceeded())
+    return;
+
+  // The group size can be far above the number of S-pairs that were
+  // available, so halve the size of the group that was actually reduced.
+  const auto newGroupSize = std::max<size_t>(
+    1,
+    std::min<size_t>(mSPairGroupSize, lastGroupSize) / 2
+  );
+  if (newGroupSize < mSPairGroupSize) {
+    mSPairGroupSize = static_cast<unsigned int>(newGroupSize);
+    MATHICGB_LOG(MemoryBudget) << "Memory use of " <<
+      mMemoryAccount.peakTotalUse() << " bytes is over the budget of " <<
+      mMemoryAccount.budget() << " bytes. Reducing at most " <<
+      mSPairGroupSize << " S-pairs at a time." << std::endl;
+  }
+}
+
+bool ClassicGBAlg::replaySaysZero(
+  const std::vector<std::pair<size_t, size_t>>& group
+) {
+  if (mReplayTrace == nullptr)
+    return false;
+  const auto& trace = *mReplayTrace;
+  MATHICGB_ASSERT(trace.groupEnds.size() == trace.nonZeroCounts.size());
+
+  if (mReplayGroup < trace.groupEnds.size()) {
+    const auto begin = trace.pairs.begin() +
+      (mReplayGroup == 0 ? 0 : trace.groupEnds[mReplayGroup - 1]);
+    const auto end = trace.pairs.begin() + trace.groupEnds[mReplayGroup];
+    if (
+      static_cast<size_t>(end - begin) == group.size() &&
+      std::equal(begin, end, group.begin())
+    )
+      return trace.nonZeroCounts[mReplayGroup++] == 0;
+  }
+  mReplayTrace = nullptr;
+  return false;
+}
+
+std::pair<size_t, size_t> ClassicGBAlg::replayPair(const size_t index) const {
+  const auto invalid = static_cast<size_t>(-1);
+  if (mReplayTrace == nullptr)
+    return std::make_pair(invalid, invalid);
+  const auto& trace = *mReplayTrace;
+  if (mReplayGroup >= trace.groupEnds.size())
+    return std::make_pair(invalid, invalid);
+  const auto begin = mReplayGroup == 0 ? 0 : trace.groupEnds[mReplayGroup - 1];
+  if (begin + index >= trace.groupEnds[mReplayGroup])
+    return std::make_pair(invalid, invalid);
+  return trace.pairs[begin + index];
+}
+
+bool ClassicGBAlg::hilbertSaysZero(const size_t a, const size_t b) {
+  const auto& monoid = mRing.monoid();
+  const auto leadA = mBasis.leadMono(a);
+  const auto leadB = mBasis.leadMono(b);
+  exponent degree = 0;
+  for (size_t var = 0; var < monoid.varCount(); ++var) {
+    degree += std::max
+      (monoid.exponent(leadA, var), monoid.exponent(leadB, var));
+  }
+
+  const auto d = static_cast<size_t>(degree);
+  if (d < mHilbertComplete.size() && mHilbertComplete[d])
+    return true;
+  if (
+    degree == mHilbertIncompleteDegree &&
+    mBasis.size() == mHilbertCheckedBasisSize
+  )
+    return false;
+
+  // The lead monomials generate a subideal of the initial ideal of I, so
+  // there are at least as many standard monomials as expected. If there
+  // are not more, then the lead monomials generate the initial ideal in
+  // this degree, and then every S-polynomial of this degree reduces to
+  // zero. The count stops early once it exceeds the expected count, so
+  // it costs time proportional to the expected count.
+  const auto expected = expectedHilbertFunction(degree);
+  unsigned long long count = 0;
+  auto mono = monoid.alloc();
+  countStandardMonomials(0, degree, *mono, expected, count);
+  if (count < expected) {
+    mathic::reportError(
+      "The lead monomials of the basis have fewer standard monomials than "
+      "the Hilbert numerator allows, so the Hilbert numerator is wrong."
+    );
+  }
+  if (count == expected) {
+    if (d >= mHilbertComplete.size())
+      mHilbertComplete.resize(d + 1);
+    mHilbertComplete[d] = true;
+    return true;
+  }
+  mHilbertIncompleteDegree = degree;
+  mHilbertCheckedBasisSize = mBasis.size();
+  return false;
+}
+
+void ClassicGBAlg::checkHilbertInput() const {
+  const auto& monoid = mRing.monoid();
+  for (size_t i = 0; i < mBasis.size(); ++i) {
+    if (mBasis.retired(i))
+      continue;
+    const auto& poly = mBasis.poly(i);
+    const auto degree = [&](Monoid::ConstMonoRef mono) {
+      exponent sum = 0;
+      for (size_t var = 0; var < monoid.varCount(); ++var)
+        sum += monoid.exponent(mono, var);
+      return sum;
+    };
+    const auto leadDegree = degree(poly.leadMono());
+    const auto end = poly.end();
+    for (auto it = poly.begin(); it != end; ++it) {
+      if (monoid.component(it.mono()) != 0) {
+        mathic::reportError
+          ("A Hilbert numerator is only supported for ideals, not modules.");
+      }
+      if (degree(it.mono()) != leadDegree) {
+        mathic::reportError(
+          "A Hilbert numerator is only supported for ideals that are "
+          "homogeneous with respect to the total degree."
+        );
+      }
+    }
+  }
+}
+
+unsigned long long ClassicGBAlg::expectedHilbertFunction(
+  const exponent degree
+) const {
+  // N(t)/(1-t)^n has coefficient sum_i N_i * binomial(degree - i + n - 1,
+  // n - 1) at t^degree.
+  const auto n = mRing.monoid().varCount();
+  long long value = 0;
+  for (size_t i = 0; i < mHilbertNumerator.size(); ++i) {
+    if (static_cast<exponent>(i) > degree)
+      break;
+    const auto k = static_cast<unsigned long long>(degree - i);
+    if (n == 0) {
+      if (k == 0)
+        value += mHilbertNumerator[i];
+      continue;
+    }
+    unsigned long long binomial = 1; // binomial(k + j, j) for j = n - 1
+    for (size_t j = 1; j < n; ++j)
+      binomial = binomial * (k + j) / j;
+    value += mHilbertNumerator[i] * static_cast<long long>(binomial);
+  }
+  if (value < 0) {
+    mathic::reportError
+      ("The Hilbert numerator gives a negative Hilbert function.");
+  }
+  return static_cast<unsigned long long>(value);
+}
+
+void ClassicGBAlg::countStandardMonomials(
+  const size_t var,
+  const exponent degree,
+  Monoid::MonoRef mono,
+  const unsigned long long limit,
+  unsigned long long& count
+) const {
+  const auto& monoid = mRing.monoid();
+  if (count > limit)
+    return;
+  // If mono is divisible by a lead monomial, then so is every monomial
+  // that has mono as a factor.
+  if (mBasis.divisor(mono) != static_cast<size_t>(-1))
+    return;
+  if (var == monoid.varCount()) {
+    if (degree == 0)
+      ++count;
+    return;
+  }
+  if (var + 1 == monoid.varCount()) {
+    monoid.setExponent(var, degree, mono);
+    if (mBasis.divisor(mono) == static_cast<size_t>(-1))
+      ++count;
+    monoid.setExponent(var, 0, mono);
+    return;
+  }
+  for (exponent e = 0; e <= degree && count <= limit; ++e) {
+    monoid.setExponent(var, e, mono);
+    countStandardMonomials(var + 1, degree - e, mono, limit, count);
+  }
+  monoid.setExponent(var, 0, mono);
 }
 
 void ClassicGBAlg::autoTailReduce() {
@@ -428,6 +938,25 @@ void ClassicGBAlg::autoTailReduce() {
   }
 }
 
+void ClassicGBAlg::interreduce() {
+  MATHICGB_ASSERT(mSPairs.empty());
+
+  // Without auto top reduction there can be elements whose lead monomial
+  // is divisible by that of another element. Those are redundant now.
+  for (size_t i = 0; i < mBasis.size(); ++i)
+    if (!mBasis.retired(i) && !mBasis.leadMinimal(i))
+      mBasis.retire(i);
+
+  std::vector<std::unique_ptr<Poly>> reduced;
+  mReducer.classicTailReduceBasis(mBasis, reduced);
+  MATHICGB_ASSERT(reduced.size() == mBasis.size());
+  for (size_t i = 0; i < mBasis.size(); ++i) {
+    MATHICGB_ASSERT(mBasis.retired(i) == (reduced[i] == nullptr));
+    if (reduced[i] != nullptr)
+      mBasis.replaceSameLeadTerm(i, std::move(reduced[i]));
+  }
+}
+
 size_t ClassicGBAlg::getMemoryUse() const {
   return
     mBasis.getMemoryUse() +
@@ -608,73 +1137,69 @@ void ClassicGBAlg::printStats(std::ostream& out) const {
       << pr << std::flush;
 }
 
-void ClassicGBAlg::printMemoryUse(std::ostream& out) const
-{
-  // Set up printer
-  mic::ColumnPrinter pr;
-  pr.addColumn();
-  pr.addColumn(false);
-  pr.addColumn(false);
-
-  std::ostream& name = pr[0];
-  std::ostream& value = pr[1];
-  std::ostream& extra = pr[2];
-
-  const size_t total = getMemoryUse();
-  { // Grobner basis
-    const size_t basisMem = mBasis.getMemoryUse();
-    name << "Grobner basis:\n";
-    value << mic::ColumnPrinter::bytesInUnit(basisMem) << '\n';
-    extra << mic::ColumnPrinter::percentInteger(basisMem, total) << '\n';
-  }
-  { // Spairs
-    const size_t sPairMem = mSPairs.getMemoryUse();
-    name << "S-pairs:\n";
-    value << mic::ColumnPrinter::bytesInUnit(sPairMem) << '\n';
-    extra << mic::ColumnPrinter::percentInteger(sPairMem, total) << '\n';
-  }
-  { // Reducer
-    const size_t reducerMem = mReducer.getMemoryUse();
-    name << "Reducer:\n";
-    value << mic::ColumnPrinter::bytesInUnit(reducerMem) << '\n';
-    extra << mic::ColumnPrinter::percentInteger(reducerMem, total) << '\n';
-  }
-  { // Signatures
-    const size_t sigMem = mRing.getMemoryUse();
-    name << "Monomials:\n";
-    value << mic::ColumnPrinter::bytesInUnit(sigMem) << '\n';
-    extra << mic::ColumnPrinter::percentInteger(sigMem, total) << '\n';
-  }
-  // total
-  name << "-------------\n";
-  value << '\n';
-  extra << '\n';
-
-  name << "Memory used in total:\n";
-  value << mic::ColumnPrinter::bytesInUnit(total) << "\n";
-  extra << "\n";
-
-  out << "*** Memory use by component ***\n" << pr << std::flush;
+void ClassicGBAlg::printMemoryUse(std::ostream& out) const {
+  mMemoryAccount.print(out);
 }
 
 Basis computeGBClassicAlg(
   Basis&& inputBasis,
   ClassicGBAlgParams params
 ) {
+  Basis noGroebnerBasis(*inputBasis.getPolyRing());
+  return computeIncrementalGBClassicAlg
+    (std::move(noGroebnerBasis), std::move(inputBasis), std::move(params));
+}
+
+Basis computeIncrementalGBClassicAlg(
+  Basis&& groebnerBasis,
+  Basis&& inputBasis,
+  ClassicGBAlgParams params
+) {
+  const auto& ring = *inputBasis.getPolyRing();
+  const auto inputHash = params.checkpointFile.empty() ? 0 :
+    GBCheckpoint::inputHash(groebnerBasis, inputBasis);
+  GBCheckpoint::State state;
+  const bool resume =
+    params.resumeFromCheckpoint &&
+    !params.checkpointFile.empty() &&
+    GBCheckpoint::read(params.checkpointFile, ring, inputHash, state);
+  if (resume) { // the checkpoint already contains the generators
+    groebnerBasis.releaseGenerators();
+    inputBasis.releaseGenerators();
+  }
+
+  // The Groebner basis has to be inserted before the new generators, so
+  // the algorithm starts out from an empty basis.
+  Basis noGenerators(ring);
   ClassicGBAlg alg(
-    inputBasis,
+    noGenerators,
     *params.reducer,
     params.monoLookupType,
     params.preferSparseReducers,
     params.sPairQueueType
   );
+  alg.setUseSugar(params.useSugar);
+  if (!resume) {
+    alg.insertGroebnerBasis(groebnerBasis.releaseGenerators());
+    alg.insertGenerators(inputBasis.releaseGenerators());
+  }
   alg.setBreakAfter(params.breakAfter);
   alg.setPrintInterval(params.printInterval);
   alg.setSPairGroupSize(params.sPairGroupSize);
   alg.setReducerMemoryQuantum(params.reducerMemoryQuantum);
+  alg.setMemoryBudget(params.memoryBudget);
   alg.setUseAutoTopReduction(params.useAutoTopReduction);
   alg.setUseAutoTailReduction(params.useAutoTailReduction);
+  alg.setUseFinalInterreduction(params.useFinalInterreduction);
   alg.setCallback(params.callback);
+  alg.setRecordTrace(params.recordTrace);
+  alg.setReplayTrace(params.replayTrace);
+  alg.setHilbertNumerator(std::move(params.hilbertNumerator));
+  if (!params.checkpointFile.empty())
+    alg.setCheckpoint
+      (params.checkpointFile, params.checkpointInterval, inputHash);
+  if (resume)
+    alg.restore(std::move(state));
 
   alg.computeGrobnerBasis();
   return std::move(*alg.basis().toBasisAndRetireAll());
@@ -4,11 +4,14 @@
 #define MATHICGB_CLASSIC_GB_ALG_GUARD
 
 #include <functional>
+#include <string>
+#include <vector>
 
 MATHICGB_NAMESPACE_BEGIN
 
 class Reducer;
 class Basis;
+struct ClassicGBTrace;
 
 struct ClassicGBAlgParams {
   Reducer* reducer;
@@ -20,13 +23,68 @@ struct ClassicGBAlgParams {
   unsigned int printInterval;
   unsigned int sPairGroupSize;
   size_t reducerMemoryQuantum;
+
+  /// The number of bytes of memory that the computation should try to stay
+  /// within. 0 means that there is no budget. See
+  /// ClassicGBAlg::setMemoryBudget.
+  size_t memoryBudget;
   bool useAutoTopReduction;
   bool useAutoTailReduction;
+
+  /// If true, S-pairs are selected by sugar degree. See SPairs::setUseSugar.
+  bool useSugar;
+
+  /// If true, the basis is turned into the reduced Groebner basis once
+  /// it has been computed.
+  bool useFinalInterreduction;
+
+  /// Checkpoints are written to this file if it is not empty. See
+  /// GBCheckpoint.
+  std::string checkpointFile;
+
+  /// The number of seconds between checkpoints. 0 means to only write a
+  /// checkpoint at the end and when one is requested.
+  unsigned int checkpointInterval;
+
+  /// If true and checkpointFile contains a checkpoint, the computation
+  /// resumes from there and the generators of the input basis are only
+  /// used to check that the checkpoint is for the same input.
+  bool resumeFromCheckpoint;
+
+  /// If not null, the S-pairs that are reduced are recorded here.
+  ClassicGBTrace* recordTrace;
+
+  /// If not null, groups of S-pairs that reduced to zero in this trace
+  /// are skipped and the F4 matrices of the other groups are built from
+  /// the plans in the trace. See ClassicGBTrace.
+  const ClassicGBTrace* replayTrace;
+
+  /// If not empty, the numerator of the Hilbert series of the quotient by
+  /// the ideal, which must then be homogeneous. S-pairs in degrees where
+  /// the lead monomials of the basis already have the Hilbert function of
+  /// the ideal are skipped.
+  std::vector<long long> hilbertNumerator;
   std::function<bool(void)> callback;
 };
 
+/// Returns a Groebner basis of the ideal generated by inputBasis. The
+/// polynomials of inputBasis are moved into the computation rather than
+/// copied, so inputBasis is left empty.
 Basis computeGBClassicAlg(Basis&& inputBasis, ClassicGBAlgParams params);
 Basis computeModuleGBClassicAlg(Basis&& inputBasis, ClassicGBAlgParams params);
 
+/// Returns a Groebner basis of the ideal generated by groebnerBasis and
+/// inputBasis, where groebnerBasis must already be a Groebner basis of the
+/// ideal that it generates. The S-pairs between elements of groebnerBasis
+/// are not considered, so this is much faster than computeGBClassicAlg
+/// when inputBasis is small compared to groebnerBasis. The result is
+/// wrong if groebnerBasis is not a Groebner basis. Both bases are left
+/// empty.
+Basis computeIncrementalGBClassicAlg(
+  Basis&& groebnerBasis,
+  Basis&& inputBasis,
+  ClassicGBAlgParams params
+);
+
 MATHICGB_NAMESPACE_END
 #endif
@@ -0,0 +1,164 @@
+// MathicGB copyright 2012 all rights reserved. MathicGB comes with ABSOLUTELY
+// NO WARRANTY and is licensed as GPL v2.0 or later - see LICENSE.txt.
+#include "stdinc.h"
+#include "ClassicGBTrace.hpp"
+
+#include "CFile.hpp"
+#include <mathic.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+MATHICGB_NAMESPACE_BEGIN
+
+namespace {
+  // The last character is the version of the file format.
+  const char Magic[] = "MGBTRAC2";
+  const size_t MagicSize = sizeof(Magic) - 1;
+
+  void writeCount(size_t count, FILE* file) {
+    const auto value = static_cast<uint64>(count);
+    if (fwrite(&value, sizeof(value), 1, file) != 1)
+      mathic::reportError("error while writing trace file.");
+  }
+
+  template<class T>
+  void writeVector(const std::vector<T>& v, FILE* file) {
+    writeCount(v.size(), file);
+    if (!v.empty() && fwrite(v.data(), sizeof(T), v.size(), file) != v.size())
+      mathic::reportError("error while writing trace file.");
+  }
+
+  void reportCorrupt(const std::string& fileName) {
+    mathic::reportError("The trace file " + fileName + " is corrupt.");
+  }
+
+  size_t readCount(const std::string& fileName, FILE* file) {
+    uint64 value;
+    if (fread(&value, sizeof(value), 1, file) != 1)
+      reportCorrupt(fileName);
+    return static_cast<size_t>(value);
+  }
+
+  template<class T>
+  void readVector(std::vector<T>& v, const std::string& fileName, FILE* file) {
+    const auto size = readCount(fileName, file);
+    // Read in chunks so that a corrupt size cannot make us allocate a huge
+    // amount of memory up front.
+    const size_t chunkSize = 1 << 16;
+    v.clear();
+    while (v.size() < size) {
+      const auto begin = v.size();
+      const auto count = std::min(chunkSize, size - begin);
+      v.resize(begin + count);
+      if (fread(v.data() + begin, sizeof(T), count, file) != count)
+        reportCorrupt(fileName);
+    }
+  }
+}
+
+void F4MatrixPlan::keepZeroRows(const std::vector<char>& isZero) {
+  if (isZero.empty()) {
+    zeroRowPolys.clear();
+    zeroRowLeads.clear();
+    return;
+  }
+  MATHICGB_ASSERT(isZero.size() == zeroRowPolys.size());
+  const auto stride = zeroRowLeads.size() / zeroRowPolys.size();
+  MATHICGB_ASSERT(zeroRowLeads.size() == stride * zeroRowPolys.size());
+  size_t kept = 0;
+  for (size_t row = 0; row < zeroRowPolys.size(); ++row) {
+    if (!isZero[row])
+      continue;
+    zeroRowPolys[kept] = zeroRowPolys[row];
+    std::copy_n(
+      zeroRowLeads.begin() + row * stride,
+      stride,
+      zeroRowLeads.begin() + kept * stride
+    );
+    ++kept;
+  }
+  zeroRowPolys.resize(kept);
+  zeroRowLeads.resize(kept * stride);
+}
+
+void ClassicGBTrace::write(const std::string& fileName) const {
+  MATHICGB_ASSERT(groupEnds.size() == nonZeroCounts.size());
+  MATHICGB_ASSERT(groupEnds.size() == matrixPlans.size());
+
+  // size_t is written as uint64 so that the file is the same on all
+  // platforms, apart from endianness.
+  std::vector<uint64> flatPairs;
+  for (const auto& pair : pairs) {
+    flatPairs.push_back(pair.first);
+    flatPairs.push_back(pair.second);
+  }
+  const std::vector<uint64> ends(groupEnds.begin(), groupEnds.end());
+  const std::vector<uint64> counts(nonZeroCounts.begin(), nonZeroCounts.end());
+
+  CFile cfile(fileName, "wb");
+  FILE* file = cfile.handle();
+  if (fwrite(Magic, 1, MagicSize, file) != MagicSize)
+    mathic::reportError("error while writing trace file.");
+  writeVector(flatPairs, file);
+  writeVector(ends, file);
+  writeVector(counts, file);
+  for (const auto& plan : matrixPlans) {
+    const std::vector<uint64> reducers
+      (plan.reducers.begin(), plan.reducers.end());
+    const std::vector<uint64> zeroRowPolys
+      (plan.zeroRowPolys.begin(), plan.zeroRowPolys.end());
+    writeVector(plan.monomials, file);
+    writeVector(reducers, file);
+    writeVector(zeroRowPolys, file);
+    writeVector(plan.zeroRowLeads, file);
+  }
+}
+
+void ClassicGBTrace::read(const std::string& fileName) {
+  CFile cfile(fileName, "rb");
+  FILE* file = cfile.handle();
+  char magic[MagicSize];
+  if (
+    fread(magic, 1, MagicSize, file) != MagicSize ||
+    std::memcmp(magic, Magic, MagicSize) != 0
+  )
+    mathic::reportError("The file " + fileName + " is not a trace file.");
+
+  std::vector<uint64> flatPairs;
+  std::vector<uint64> ends;
+  std::vector<uint64> counts;
+  readVector(flatPairs, fileName, file);
+  readVector(ends, fileName, file);
+  readVector(counts, fileName, file);
+  if (flatPairs.size() % 2 != 0 || ends.size() != counts.size())
+    reportCorrupt(fileName);
+  for (size_t i = 0; i < ends.size(); ++i)
+    if (ends[i] > flatPairs.size() / 2 || (i > 0 && ends[i] < ends[i - 1]))
+      reportCorrupt(fileName);
+
+  pairs.clear();
+  for (size_t i = 0; i < flatPairs.size(); i += 2) {
+    pairs.emplace_back(
+      static_cast<size_t>(flatPairs[i]),
+      static_cast<size_t>(flatPairs[i + 1])
+    );
+  }
+  groupEnds.assign(ends.begin(), ends.end());
+  nonZeroCounts.assign(counts.begin(), counts.end());
+
+  matrixPlans.clear();
+  matrixPlans.resize(groupEnds.size());
+  std::vector<uint64> reducers;
+  std::vector<uint64> zeroRowPolys;
+  for (auto& plan : matrixPlans) {
+    readVector(plan.monomials, fileName, file);
+    readVector(reducers, fileName, file);
+    readVector(zeroRowPolys, fileName, file);
+    readVector(plan.zeroRowLeads, fileName, file);
+    plan.reducers.assign(reducers.begin(), reducers.end());
+    plan.zeroRowPolys.assign(zeroRowPolys.begin(), zeroRowPolys.end());
+  }
+}
+
+MATHICGB_NAMESPACE_END
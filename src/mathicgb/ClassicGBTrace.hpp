@@ -0,0 +1,85 @@
+// MathicGB copyright 2012 all rights reserved. MathicGB comes with ABSOLUTELY
+// NO WARRANTY and is licensed as GPL v2.0 or later - see LICENSE.txt.
+#ifndef MATHICGB_CLASSIC_G_B_TRACE_GUARD
+#define MATHICGB_CLASSIC_G_B_TRACE_GUARD
+
+#include <string>
+#include <utility>
+#include <vector>
+
+MATHICGB_NAMESPACE_BEGIN
+
+/// The columns of an F4 matrix that were found by symbolic preprocessing,
+/// together with the basis element that was chosen to reduce each of them,
+/// and the rows of the matrix that reduced to zero. A builder that replays
+/// a plan creates these columns and their reducer rows up front instead of
+/// looking for a reducer of each new column, and it leaves out the rows
+/// that reduced to zero.
+struct F4MatrixPlan {
+  /// The column monomials one after the other. Each monomial is its
+  /// exponents followed by its component.
+  std::vector<int32> monomials;
+
+  /// The index of the basis element that reduces each column, or -1 for a
+  /// column without a reducer.
+  std::vector<size_t> reducers;
+
+  /// The bottom rows that reduced to zero by the top rows. Row i is a
+  /// multiple of basis element zeroRowPolys[i] with lead monomial
+  /// zeroRowLeads[i], which is stored as in monomials. Leaving out such a
+  /// row does not change the row space of the matrix, since the top rows
+  /// that it reduced to zero by are still there.
+  ///
+  /// While a matrix is recorded, the builder lists all of its bottom rows
+  /// here in order, and the reducer then calls keepZeroRows.
+  std::vector<size_t> zeroRowPolys;
+  std::vector<int32> zeroRowLeads;
+
+  /// Keeps the rows i of zeroRowPolys and zeroRowLeads for which isZero[i]
+  /// is true. Keeps no rows if isZero is empty, which is for when it is not
+  /// known which rows reduced to zero.
+  void keepZeroRows(const std::vector<char>& isZero);
+
+  void clear() {
+    monomials.clear();
+    reducers.clear();
+    zeroRowPolys.clear();
+    zeroRowLeads.clear();
+  }
+};
+
+/// The groups of S-pairs that a run of computeGBClassicAlg reduced, in
+/// order, together with how many S-polynomials of each group did not reduce
+/// to zero and the plans of the F4 matrices that reduced them. A
+/// computation of an ideal with the same structure - such as the same ideal
+/// modulo a different prime - can replay the trace to skip the groups whose
+/// S-polynomials all reduced to zero, to skip the symbolic preprocessing
+/// and the rows that reduced to zero of the other groups and to skip the
+/// checks for useless S-pairs of the S-pairs in the trace. Skipping groups
+/// and rows is only correct if the computation proceeds the same way, so
+/// the result of a replayed computation has to be verified. Replay stops
+/// as soon as the computation is seen to differ from the trace.
+struct ClassicGBTrace {
+  std::vector<std::pair<size_t, size_t>> pairs;
+
+  /// Group i consists of the pairs from index groupEnds[i - 1] up to but
+  /// not including index groupEnds[i], where groupEnds[-1] is taken to be 0.
+  std::vector<size_t> groupEnds;
+
+  /// The number of non-zero reduced S-polynomials of each group.
+  std::vector<size_t> nonZeroCounts;
+
+  /// The plan of the matrix of each group. The plan is empty for groups
+  /// that were skipped or that were not reduced by an F4 matrix.
+  std::vector<F4MatrixPlan> matrixPlans;
+
+  /// Writes the trace to the file fileName.
+  void write(const std::string& fileName) const;
+
+  /// Replaces the trace by the one in the file fileName. Reports an error
+  /// if the file cannot be read or is not a trace file.
+  void read(const std::string& fileName);
+};
+
+MATHICGB_NAMESPACE_END
+#endif
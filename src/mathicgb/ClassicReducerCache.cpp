@@ -0,0 +1,154 @@
+// MathicGB copyright 2012 all rights reserved. MathicGB comes with ABSOLUTELY
+// NO WARRANTY and is licensed as GPL v2.0 or later - see LICENSE.txt.
+#include "stdinc.h"
+#include "ClassicReducerCache.hpp"
+
+#include "PolyBasis.hpp"
+#include <algorithm>
+#include <limits>
+
+MATHICGB_NAMESPACE_BEGIN
+
+ClassicReducerCache::ClassicReducerCache(
+  const PolyRing& ring,
+  const size_t maxEntryCount
+):
+  mMonoid(ring.monoid()),
+  mMaxEntryCount(std::max<size_t>(1, maxEntryCount)),
+  mBasis(nullptr),
+  mLeads(ring.monoid()),
+  mEntries(0, Hash{&ring.monoid()}, Equal{&ring.monoid()}),
+  mMonos(ring.monoid()),
+  mMonoCount(0)
+{}
+
+auto ClassicReducerCache::mask(ConstMonoRef mono) const -> Mask {
+  // Each variable gets some bits, with thresholds 1, 2, 4 and so on. If
+  // there are more variables than bits, then variables share bits.
+  const size_t maskBits = std::numeric_limits<Mask>::digits;
+  const auto varCount = monoid().varCount();
+  const auto bitsPerVar = varCount == 0 ? size_t(0) :
+    std::min<size_t>(16, std::max<size_t>(1, maskBits / varCount));
+  Mask mask = 0;
+  for (size_t var = 0; var < varCount; ++var) {
+    const auto exponent = monoid().exponent(mono, var);
+    const auto firstBit = (var * bitsPerVar) % maskBits;
+    for (size_t bit = 0; bit < bitsPerVar; ++bit)
+      if (exponent >= (Monoid::Exponent(1) << bit))
+        mask |= Mask(1) << (firstBit + bit);
+  }
+  return mask;
+}
+
+void ClassicReducerCache::update(const PolyBasis& basis) {
+  MATHICGB_ASSERT(&basis.monoid() == &monoid());
+
+  // Make sure that the basis elements known to the cache are still there.
+  bool sameBasis = mLeadRetired.size() <= basis.size();
+  if (sameBasis) {
+    auto lead = mLeads.begin();
+    for (size_t i = 0; i < mLeadRetired.size(); ++i, ++lead) {
+      if (basis.retired(i))
+        continue;
+      if (mLeadRetired[i] != 0 || !monoid().equal(*lead, basis.leadMono(i))) {
+        sameBasis = false;
+        break;
+      }
+    }
+  }
+  mBasis = &basis;
+  if (!sameBasis) {
+    clear();
+    mLeads.clear();
+    mLeadRetired.clear();
+  }
+
+  // Forget the monomials that a new basis element might reduce.
+  struct NewLead {
+    ConstMonoPtr mono;
+    Mask mask;
+  };
+  std::vector<NewLead> newLeads;
+  for (auto i = mLeadRetired.size(); i < basis.size(); ++i) {
+    const bool retired = basis.retired(i);
+    mLeadRetired.push_back(retired);
+    if (retired) {
+      mLeads.push_back();
+      continue;
+    }
+    mLeads.push_back(basis.leadMono(i));
+    if (!mEntries.empty()) {
+      NewLead lead = {basis.leadMono(i).ptr(), mask(basis.leadMono(i))};
+      newLeads.push_back(lead);
+    }
+  }
+  if (newLeads.empty())
+    return;
+
+  for (auto it = mEntries.begin(); it != mEntries.end();) {
+    const auto entryMask = it->second.mask;
+    bool divisible = false;
+    for (const auto& lead : newLeads) {
+      if ((lead.mask & ~entryMask) != 0)
+        continue;
+      if (monoid().dividesWithComponent(*lead.mono, *it->first)) {
+        divisible = true;
+        break;
+      }
+    }
+    if (divisible)
+      it = mEntries.erase(it);
+    else
+      ++it;
+  }
+}
+
+bool ClassicReducerCache::find(ConstMonoRef mono, size_t& reducer) const {
+  MATHICGB_ASSERT(mBasis != nullptr);
+  const auto it = mEntries.find(mono.ptr());
+  if (it == mEntries.end())
+    return false;
+  const auto cached = it->second.reducer;
+  if (cached != static_cast<size_t>(-1) && mBasis->retired(cached))
+    return false;
+  reducer = cached;
+  return true;
+}
+
+void ClassicReducerCache::insert(ConstMonoRef mono, const size_t reducer) {
+  MATHICGB_ASSERT(mBasis != nullptr);
+  MATHICGB_ASSERT(reducer == static_cast<size_t>(-1) ||
+    reducer < mLeadRetired.size());
+
+  const auto it = mEntries.find(mono.ptr());
+  if (it != mEntries.end()) {
+    // The old reducer may have been retired.
+    it->second.reducer = reducer;
+    return;
+  }
+  if (mMonoCount == mMaxEntryCount)
+    clear();
+  mMonos.push_back(mono);
+  ++mMonoCount;
+  const Entry entry = {reducer, mask(mono)};
+  mEntries.emplace(mMonos.back().ptr(), entry);
+}
+
+void ClassicReducerCache::clear() {
+  mEntries.clear();
+  mMonos.clear();
+  mMonoCount = 0;
+}
+
+size_t ClassicReducerCache::getMemoryUse() const {
+  const auto entryBytes =
+    sizeof(ConstMonoPtr) + sizeof(Entry) + 2 * sizeof(void*);
+  return
+    mMonos.memoryBytesUsed() +
+    mLeads.memoryBytesUsed() +
+    mLeadRetired.capacity() +
+    mEntries.size() * entryBytes +
+    mEntries.bucket_count() * sizeof(void*);
+}
+
+MATHICGB_NAMESPACE_END
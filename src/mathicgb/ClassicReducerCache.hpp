@@ -0,0 +1,118 @@
+// MathicGB copyright 2012 all rights reserved. MathicGB comes with ABSOLUTELY
+// NO WARRANTY and is licensed as GPL v2.0 or later - see LICENSE.txt.
+#ifndef MATHICGB_CLASSIC_REDUCER_CACHE_GUARD
+#define MATHICGB_CLASSIC_REDUCER_CACHE_GUARD
+
+#include "PolyRing.hpp"
+#include "MonoArena.hpp"
+#include "NonCopyable.hpp"
+#include <unordered_map>
+#include <vector>
+
+MATHICGB_NAMESPACE_BEGIN
+
+class PolyBasis;
+
+/// Remembers the classic reducer of monomials from one F4 matrix to the
+/// next, since most of the columns of a matrix are also columns of the
+/// matrices that came before it.
+///
+/// The cache depends on the facts that a basis only gets new elements
+/// appended to it and that retiring an element is the only way to remove a
+/// lead monomial. A remembered reducer r of m stays correct until r is
+/// retired or until a new basis element has a lead monomial that divides m,
+/// since the new element might be the better reducer. The same goes for a
+/// monomial that is remembered to have no reducer. update() forgets the
+/// monomials that are divisible by the lead monomials of the new basis
+/// elements, while retired reducers are noticed by find(). Replacing a
+/// basis element by one with the same lead monomial can change which reducer
+/// is preferred, but a remembered reducer remains a valid reducer.
+///
+/// At most maxEntryCount monomials are remembered. Once that many monomials
+/// have been stored, everything is forgotten and the cache starts over, so
+/// memory use is bounded by the size of maxEntryCount monomials.
+class ClassicReducerCache : public NonCopyable<ClassicReducerCache> {
+public:
+  typedef PolyRing::Monoid Monoid;
+  typedef Monoid::ConstMonoRef ConstMonoRef;
+  typedef Monoid::ConstMonoPtr ConstMonoPtr;
+
+  static const size_t DefaultMaxEntryCount = 1 << 20;
+
+  ClassicReducerCache(
+    const PolyRing& ring,
+    size_t maxEntryCount = DefaultMaxEntryCount
+  );
+
+  /// Brings the cache up to date with basis, which must be over the ring of
+  /// this cache. Call this before each use of the cache with the basis
+  /// that the reducers are to come from. Everything is forgotten if basis
+  /// is not the basis that the cache was last updated with.
+  void update(const PolyBasis& basis);
+
+  /// If the reducer of mono is known, sets reducer to it and returns true.
+  /// The reducer is -1 if no basis element divides mono. Several threads
+  /// can call find at the same time as long as no thread changes the cache.
+  bool find(ConstMonoRef mono, size_t& reducer) const;
+
+  /// Remembers that reducer is the classic reducer of mono in the basis of
+  /// the last call to update(). Does nothing if mono is already known.
+  void insert(ConstMonoRef mono, size_t reducer);
+
+  /// Forgets everything.
+  void clear();
+
+  /// Returns the number of monomials whose reducer is known.
+  size_t size() const {return mEntries.size();}
+
+  size_t getMemoryUse() const;
+
+  const Monoid& monoid() const {return mMonoid;}
+
+private:
+  typedef unsigned long long Mask;
+
+  /// Returns a mask where a set bit shows that some exponent of mono is at
+  /// least some threshold. The mask of a monomial that divides mono is a
+  /// subset of the mask of mono.
+  Mask mask(ConstMonoRef mono) const;
+
+  struct Entry {
+    size_t reducer;
+    Mask mask;
+  };
+
+  struct Hash {
+    const Monoid* monoid;
+    size_t operator()(ConstMonoPtr mono) const {
+      return static_cast<size_t>(monoid->hash(*mono));
+    }
+  };
+
+  struct Equal {
+    const Monoid* monoid;
+    bool operator()(ConstMonoPtr a, ConstMonoPtr b) const {
+      return monoid->equal(*a, *b);
+    }
+  };
+
+  const Monoid& mMonoid;
+  const size_t mMaxEntryCount;
+
+  /// The basis of the last call to update().
+  const PolyBasis* mBasis;
+
+  /// Copies of the lead monomials of the basis elements that the cache
+  /// knows about. Retired elements have the identity here.
+  Monoid::MonoVector mLeads;
+  std::vector<char> mLeadRetired;
+
+  /// The keys of mEntries point into mMonos. Forgotten monomials are not
+  /// removed from mMonos, so mMonoCount counts those too.
+  std::unordered_map<ConstMonoPtr, Entry, Hash, Equal> mEntries;
+  MonoArena<Monoid> mMonos;
+  size_t mMonoCount;
+};
+
+MATHICGB_NAMESPACE_END
+#endif
@@ -0,0 +1,63 @@
+// MathicGB copyright 2012 all rights reserved. MathicGB comes with ABSOLUTELY
+// NO WARRANTY and is licensed as GPL v2.0 or later - see LICENSE.txt.
+#include "stdinc.h"
+#include "ConcurrentBufferPool.hpp"
+
+#include <algorithm>
+
+MATHICGB_NAMESPACE_BEGIN
+
+ConcurrentBufferPool::ConcurrentBufferPool(size_t bufferSize):
+  mBufferSize(std::max(bufferSize, sizeof(Node))),
+  mPool(mBufferSize),
+  mCaches([](){
+    Cache cache = {nullptr, 0};
+    return cache;
+  })
+{}
+
+bool ConcurrentBufferPool::fromPool(const void* buffer) const {
+  mgb::mtbb::mutex::scoped_lock lock(mLock);
+  return mPool.fromPool(buffer);
+}
+
+size_t ConcurrentBufferPool::getMemoryUse() const {
+  mgb::mtbb::mutex::scoped_lock lock(mLock);
+  return mPool.getMemoryUse() + mDepot.capacity() * sizeof(Node*);
+}
+
+void ConcurrentBufferPool::refill(Cache& cache) {
+  MATHICGB_ASSERT(cache.head == nullptr);
+  MATHICGB_ASSERT(cache.count == 0);
+
+  mgb::mtbb::mutex::scoped_lock lock(mLock);
+  if (!mDepot.empty()) {
+    cache.head = mDepot.back();
+    mDepot.pop_back();
+  } else {
+    for (size_t i = 0; i < BatchSize; ++i) {
+      const auto node = static_cast<Node*>(mPool.alloc());
+      node->next = cache.head;
+      cache.head = node;
+    }
+  }
+  cache.count = BatchSize;
+}
+
+void ConcurrentBufferPool::spill(Cache& cache) {
+  MATHICGB_ASSERT(cache.count == 2 * BatchSize);
+
+  // Keep the most recently freed buffers since they are likely to still be
+  // in the processor cache, and hand the older half to the depot.
+  auto lastKept = cache.head;
+  for (size_t i = 1; i < BatchSize; ++i)
+    lastKept = lastKept->next;
+  const auto batch = lastKept->next;
+  lastKept->next = nullptr;
+  cache.count = BatchSize;
+
+  mgb::mtbb::mutex::scoped_lock lock(mLock);
+  mDepot.push_back(batch);
+}
+
+MATHICGB_NAMESPACE_END
@@ -0,0 +1,92 @@
+// MathicGB copyright 2012 all rights reserved. MathicGB comes with ABSOLUTELY
+// NO WARRANTY and is licensed as GPL v2.0 or later - see LICENSE.txt.
+#ifndef MATHICGB_CONCURRENT_BUFFER_POOL_GUARD
+#define MATHICGB_CONCURRENT_BUFFER_POOL_GUARD
+
+#include "NonCopyable.hpp"
+#include "mtbb.hpp"
+#include <memtailor.h>
+#include <vector>
+
+MATHICGB_NAMESPACE_BEGIN
+
+/// Like memt::BufferPool, except that alloc and free may be called
+/// concurrently from any thread.
+///
+/// Each thread has its own cache of free buffers, so alloc and free usually
+/// do not synchronize at all. Free buffers move between the thread caches
+/// and a shared depot in batches of BatchSize buffers, so a thread takes the
+/// depot lock at most once every BatchSize calls. A buffer may be freed by a
+/// different thread than the one that allocated it.
+class ConcurrentBufferPool : public NonCopyable<ConcurrentBufferPool> {
+public:
+  ConcurrentBufferPool(size_t bufferSize);
+
+  void* alloc() {
+    auto& cache = mCaches.local();
+    if (cache.head == nullptr)
+      refill(cache);
+    MATHICGB_ASSERT(cache.head != nullptr);
+    MATHICGB_ASSERT(cache.count > 0);
+    const auto buffer = cache.head;
+    cache.head = cache.head->next;
+    --cache.count;
+    return buffer;
+  }
+
+  void free(void* buffer) {
+    MATHICGB_ASSERT(buffer != nullptr);
+    auto& cache = mCaches.local();
+    const auto node = static_cast<Node*>(buffer);
+    node->next = cache.head;
+    cache.head = node;
+    ++cache.count;
+    if (cache.count >= 2 * BatchSize)
+      spill(cache);
+  }
+
+  /// Returns true if buffer was allocated from this pool. This is slow and
+  /// intended for asserts.
+  bool fromPool(const void* buffer) const;
+
+  /// Returns the size of the buffers handed out by alloc(). This may be
+  /// larger than the size passed to the constructor.
+  size_t getBufferSize() const {return mBufferSize;}
+
+  size_t getMemoryUse() const;
+
+private:
+  /// The number of buffers moved to or from the depot at a time.
+  static const size_t BatchSize = 64;
+
+  /// A free buffer stores a pointer to the next free buffer in itself.
+  struct Node {
+    Node* next;
+  };
+
+  struct Cache {
+    Node* head;
+    size_t count;
+  };
+
+  /// Gives cache a batch of free buffers from the depot, allocating new
+  /// buffers if the depot is empty.
+  void refill(Cache& cache);
+
+  /// Moves a batch of free buffers from cache to the depot.
+  void spill(Cache& cache);
+
+  const size_t mBufferSize;
+
+  /// Protects mPool and mDepot.
+  mutable mgb::mtbb::mutex mLock;
+  memt::BufferPool mPool;
+
+  /// Each entry is the head of a list of exactly BatchSize free buffers.
+  std::vector<Node*> mDepot;
+
+  mgb::mtbb::enumerable_thread_specific<Cache> mCaches;
+};
+
+MATHICGB_NAMESPACE_END
+#endif
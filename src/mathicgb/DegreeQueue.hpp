@@ -0,0 +1,247 @@
+// MathicGB copyright 2012 all rights reserved. MathicGB comes with ABSOLUTELY
+// NO WARRANTY and is licensed as GPL v2.0 or later - see LICENSE.txt.
+#ifndef MATHICGB_DEGREE_QUEUE_GUARD
+#define MATHICGB_DEGREE_QUEUE_GUARD
+
+#include <string>
+#include <vector>
+
+MATHICGB_NAMESPACE_BEGIN
+
+/// A priority queue for the classic reducers that offers the parts of the
+/// interface of mathic::Heap, mathic::TourTree and mathic::Geobucket that
+/// the reducers use.
+///
+/// Entries are put into buckets according to the most significant word of
+/// the monomial order, which is the degree for graded orders. The full
+/// comparison of the configuration is only used between entries in the
+/// same bucket, and each bucket is a binary heap. The buckets are kept in
+/// a vector that starts with the bucket of the greatest degree seen, so
+/// pushing the smaller terms that come up during a reduction appends
+/// buckets at the end. If the degrees spread over more than MaxBucketCount
+/// values, then several degrees share a bucket.
+///
+/// The configuration must have the members that the reducers define for the
+/// mathic queues and also a method mono(entry) that returns the monomial
+/// that an entry is ordered by. Entries are never deduplicated.
+template<class C>
+class DegreeQueue {
+public:
+  typedef C Configuration;
+  typedef typename Configuration::Entry Entry;
+
+  static const size_t MaxBucketCount = 1024;
+
+  DegreeQueue(const Configuration& conf):
+    mConf(conf),
+    mSize(0),
+    mTop(0),
+    mBase(0),
+    mShift(0)
+  {}
+
+  const Configuration& getConfiguration() const {return mConf;}
+  Configuration& getConfiguration() {return mConf;}
+
+  std::string getName() const {return "degbucket";}
+
+  bool empty() const {return mSize == 0;}
+  size_t size() const {return mSize;}
+
+  void push(Entry entry) {
+    auto& bucket = mBuckets[bucketIndex(key(entry))];
+    bucket.push_back(entry);
+    siftUp(bucket);
+    ++mSize;
+    MATHICGB_ASSERT(!mBuckets[mTop].empty());
+  }
+
+  template<class It>
+  void push(It begin, It end) {
+    for (; begin != end; ++begin)
+      push(*begin);
+  }
+
+  Entry top() const {
+    MATHICGB_ASSERT(!empty());
+    return mBuckets[mTop].front();
+  }
+
+  Entry pop() {
+    MATHICGB_ASSERT(!empty());
+    auto& bucket = mBuckets[mTop];
+    const auto top = bucket.front();
+    const auto last = bucket.back();
+    bucket.pop_back();
+    if (!bucket.empty())
+      replaceTop(bucket, last);
+    --mSize;
+    if (mSize > 0)
+      while (mBuckets[mTop].empty())
+        ++mTop;
+    return top;
+  }
+
+  /// Replaces the top entry by entry, which must not be greater than the
+  /// top entry.
+  void decreaseTop(Entry entry) {
+    MATHICGB_ASSERT(!empty());
+    MATHICGB_ASSERT(!lessThan(top(), entry));
+    if ((key(entry) >> mShift) == mBase - static_cast<Key>(mTop))
+      replaceTop(mBuckets[mTop], entry);
+    else {
+      pop();
+      push(entry);
+    }
+  }
+
+  void clear() {
+    for (auto& bucket : mBuckets)
+      bucket.clear();
+    mSize = 0;
+    mTop = 0;
+    mShift = 0;
+  }
+
+  template<class T>
+  void forAll(T& t) const {
+    for (const auto& bucket : mBuckets)
+      for (const auto& entry : bucket)
+        if (!t.proceed(entry))
+          return;
+  }
+
+  size_t getMemoryUse() const {
+    auto sum = mBuckets.capacity() * sizeof(mBuckets.front());
+    for (const auto& bucket : mBuckets)
+      sum += bucket.capacity() * sizeof(Entry);
+    return sum;
+  }
+
+private:
+  /// Greater keys belong to greater monomials.
+  typedef long long Key;
+
+  Key key(const Entry& entry) const {
+    const auto& monoid = mConf.ring().monoid();
+    if (monoid.gradingCount() == 0)
+      return 0;
+    const Key degree = monoid.degree(mConf.mono(entry));
+    return monoid.degreesAscending() ? degree : -degree;
+  }
+
+  /// Returns the index of the bucket for key, adding buckets as needed.
+  /// Bucket i holds the keys k with k >> mShift equal to mBase - i.
+  size_t bucketIndex(const Key key) {
+    if (mSize == 0) {
+      mShift = 0;
+      mBase = key;
+      mTop = 0;
+      if (mBuckets.empty())
+        mBuckets.resize(1);
+      return 0;
+    }
+
+    const auto shifted = key >> mShift;
+    if (shifted > mBase) {
+      const auto added = static_cast<size_t>(shifted - mBase);
+      if (mBuckets.size() + added > MaxBucketCount) {
+        rebucket();
+        return bucketIndex(key);
+      }
+      mBuckets.insert(mBuckets.begin(), added, std::vector<Entry>());
+      mBase = shifted;
+      mTop = 0;
+      return 0;
+    }
+
+    const auto index = static_cast<size_t>(mBase - shifted);
+    if (index >= mBuckets.size()) {
+      if (index >= MaxBucketCount) {
+        rebucket();
+        return bucketIndex(key);
+      }
+      mBuckets.resize(index + 1);
+    }
+    if (index < mTop)
+      mTop = index;
+    return index;
+  }
+
+  /// Halves the number of buckets that the current keys spread over.
+  void rebucket() {
+    std::vector<Entry> entries;
+    entries.reserve(mSize);
+    for (auto& bucket : mBuckets) {
+      entries.insert(entries.end(), bucket.begin(), bucket.end());
+      bucket.clear();
+    }
+    mBuckets.erase(mBuckets.begin() + 1, mBuckets.end());
+    mSize = 0;
+    mTop = 0;
+    ++mShift;
+    for (const auto& entry : entries) {
+      // Do not let bucketIndex reset mShift for the first entry.
+      auto& bucket = mBuckets[nonEmptyBucketIndex(entry)];
+      bucket.push_back(entry);
+      siftUp(bucket);
+      ++mSize;
+    }
+  }
+
+  size_t nonEmptyBucketIndex(const Entry& entry) {
+    if (mSize > 0)
+      return bucketIndex(key(entry));
+    mBase = key(entry) >> mShift;
+    return 0;
+  }
+
+  bool lessThan(const Entry& a, const Entry& b) const {
+    return mConf.cmpLessThan(mConf.compare(a, b));
+  }
+
+  /// Restores the heap property after an entry was added at the back.
+  void siftUp(std::vector<Entry>& heap) {
+    auto pos = heap.size() - 1;
+    const auto entry = heap[pos];
+    while (pos > 0) {
+      const auto parent = (pos - 1) / 2;
+      if (!lessThan(heap[parent], entry))
+        break;
+      heap[pos] = heap[parent];
+      pos = parent;
+    }
+    heap[pos] = entry;
+  }
+
+  /// Replaces the top of heap by entry and restores the heap property.
+  void replaceTop(std::vector<Entry>& heap, const Entry entry) {
+    const auto size = heap.size();
+    size_t pos = 0;
+    while (true) {
+      auto child = 2 * pos + 1;
+      if (child >= size)
+        break;
+      if (child + 1 < size && lessThan(heap[child], heap[child + 1]))
+        ++child;
+      if (!lessThan(entry, heap[child]))
+        break;
+      heap[pos] = heap[child];
+      pos = child;
+    }
+    heap[pos] = entry;
+  }
+
+  Configuration mConf;
+  std::vector<std::vector<Entry>> mBuckets;
+  size_t mSize;
+
+  /// The index of the first non-empty bucket, if there is one.
+  size_t mTop;
+
+  Key mBase;
+  unsigned int mShift;
+};
+
+MATHICGB_NAMESPACE_END
+#endif
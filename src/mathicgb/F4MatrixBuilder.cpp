@@ -200,18 +200,20 @@ void F4MatrixBuilder::buildMatrixAndClear(QuadMatrix& matrix) {
     ColReader reader(mMap);
     matrix.leftColumnMonomials.clear();
     matrix.rightColumnMonomials.clear();
+    matrix.monomialStorage.clear();
+    matrix.monomialStorage.emplace_back(monoid());
+    auto& arena = matrix.monomialStorage.back();
     const auto end = reader.end();
     for (auto it = reader.begin(); it != end; ++it) {
       const auto p = *it;
-      auto copy = monoid().alloc();
-      monoid().copy(p.second, copy);
+      arena.push_back(p.second);
       auto& monos = p.first.left() ?
         matrix.leftColumnMonomials : matrix.rightColumnMonomials;
       const auto index = p.first.index();
       if (monos.size() <= index)
         monos.resize(index + 1);
       MATHICGB_ASSERT(monos[index].isNull());
-      monos[index] = copy.release();
+      monos[index] = arena.back().ptr();
     }
   }
 #ifdef MATHICGB_DEBUG
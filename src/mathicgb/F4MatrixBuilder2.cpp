@@ -5,6 +5,14 @@
 
 #include "LogDomain.hpp"
 #include "F4MatrixProjection.hpp"
+#include "SigPolyBasis.hpp"
+#include "MonoArena.hpp"
+#include "ClassicGBTrace.hpp"
+#include "FrozenMonoLookup.hpp"
+#include "ClassicReducerCache.hpp"
+#include <algorithm>
+#include <map>
+#include <unordered_map>
 
 MATHICGB_DEFINE_LOG_DOMAIN(
   F4MatrixBuild2,
@@ -100,6 +108,7 @@ public:
         mMap.insert(std::make_pair(tasks[i].desiredLead, newIndex));
       mIsColumnToLeft.push_back(true);
       const auto& mono = inserted.first.second;
+      addColumnToBucket(newIndex, mono);
 
       // Schedule the two parts of the S-pair as separate rows. This adds a row
       // while creating the column in the hash table without adding a reducer
@@ -107,7 +116,8 @@ public:
       // half of the S-pair and using it as a reducer.
       auto desiredLead = monoid().alloc();
       monoid().copy(*mono, *desiredLead);
-      RowTask newTask = {desiredLead.release(), tasks[i].sPairPoly, nullptr};
+      RowTask newTask =
+        {desiredLead.release(), tasks[i].sPairPoly, nullptr, false, 0};
 
       // Now we can strip off any part of an S-pair with the same cancelling lead
       // term that equals a or b since those rows are in the matrix.
@@ -146,6 +156,10 @@ public:
     }
 
     initializeRowsToReduce(tasks);
+    if (mReplayPlan != nullptr) {
+      skipZeroRows(*mReplayPlan, tasks);
+      seedColumns(*mReplayPlan, tasks);
+    }
 
     // The MonoRef's cannot be Mono's since enumerable_thread_specific
     // apparently requires the stored data type to be copyable and
@@ -154,14 +168,22 @@ public:
       MonoRef tmp1;
       MonoRef tmp2;
       F4ProtoMatrix block;
+      F4ProtoMatrix bottomBlock;
+      std::vector<size_t> bottomIndices; // bottomIndex of each row of
+                                         // bottomBlock
+      std::vector<const Poly*> rowPolys; // poly of each row of block, if
+                                         // recording
     };
 
     mgb::mtbb::enumerable_thread_specific<ThreadData> threadData([&](){  
-      // We need to grab a lock since monoid isn't internally synchronized.
-      mgb::mtbb::mutex::scoped_lock guard(mCreateColumnLock);
+      // No lock needed since the monoid's pool is thread-safe.
       ThreadData data = {
         *monoid().alloc().release(),
-        *monoid().alloc().release()
+        *monoid().alloc().release(),
+        F4ProtoMatrix(),
+        F4ProtoMatrix(),
+        std::vector<size_t>(),
+        std::vector<const Poly*>()
       };
       return data;
     });
@@ -171,7 +193,12 @@ public:
       [&](const RowTask& task, TaskFeeder& feeder)
     {
       auto& data = threadData.local();
+      auto& block = task.bottom ? data.bottomBlock : data.block;
       const auto& poly = *task.poly;
+      if (mRecordPlan != nullptr && !task.bottom)
+        data.rowPolys.push_back(&poly);
+      if (task.bottom)
+        data.bottomIndices.push_back(task.bottomIndex);
 
       // It is perfectly permissible for task.sPairPoly to be non-null. The
       // assert is there because of an interaction between S-pair
@@ -191,55 +218,122 @@ public:
           data.tmp1
         );
         appendRowSPair
-          (poly, data.tmp1, *task.sPairPoly, data.tmp2, data.block, feeder);
+          (poly, data.tmp1, *task.sPairPoly, data.tmp2, block, feeder);
         return;
       }
       if (task.desiredLead == nullptr)
         monoid().setIdentity(data.tmp1);
       else
         monoid().divide(poly.leadMono(), *task.desiredLead, data.tmp1);
-      appendRow(data.tmp1, *task.poly, data.block, feeder);
+      appendRow(data.tmp1, *task.poly, block, feeder);
     });
     MATHICGB_ASSERT(!threadData.empty()); // as tasks empty causes early return
 
+    // The cache copies the monomials, so this has to happen before mMap
+    // goes away.
+    if (mReducerCache != nullptr) {
+      for (const auto& column : mCachedColumns)
+        mReducerCache->insert(*column.first, column.second);
+      mCachedColumns.clear();
+    }
+
     // Free the monomials from all the tasks
     for (const auto& task : tasks)
       if (task.desiredLead != nullptr)
         monoid().freeRaw(*task.desiredLead.castAwayConst());
     tasks.clear();
 
-    // Move the proto-matrices across all threads into the projection.
+    // Move the proto-matrices across all threads into the projection. The
+    // rows keep their place in memory, so a row can be told by its indices.
     F4MatrixProjection projection
       (ring(), static_cast<ColIndex>(mMap.entryCount()));
-    const auto end = threadData.end();
+    std::unordered_map<const ColIndex*, const Poly*> rowPolys;
+    std::vector<std::pair<const F4ProtoMatrix*, RowIndex>> bottomOrder;
     for (auto& data : threadData) {
+      if (mRecordPlan != nullptr) {
+        MATHICGB_ASSERT(data.rowPolys.size() == data.block.rowCount());
+        for (RowIndex r = 0; r < data.block.rowCount(); ++r) {
+          const auto row = data.block.row(r);
+          if (row.entryCount > 0)
+            rowPolys[row.indices] = data.rowPolys[r];
+        }
+      }
       monoid().freeRaw(data.tmp1);
       monoid().freeRaw(data.tmp2);
       projection.addProtoMatrix(std::move(data.block));
+      MATHICGB_ASSERT
+        (data.bottomIndices.size() == data.bottomBlock.rowCount());
+      for (RowIndex r = 0; r < data.bottomBlock.rowCount(); ++r) {
+        const auto index = data.bottomIndices[r];
+        if (bottomOrder.size() <= index)
+          bottomOrder.resize(index + 1);
+        bottomOrder[index] = std::make_pair(&data.bottomBlock, r);
+      }
     }
-
-    // Sort columns by monomial and tell the projection of the resulting order
-    MonomialMap<ColIndex>::Reader reader(mMap);
-    typedef std::pair<ColIndex, ConstMonoPtr> IndexMono;
-    auto toPtr = [](std::pair<ColIndex, ConstMonoRef> p) {
-      return std::make_pair(p.first, &p.second);
-    };
-    std::vector<IndexMono> columns;
-    std::transform
-      (reader.begin(), reader.end(), std::back_inserter(columns), toPtr);
-
+    for (const auto& row : bottomOrder)
+      projection.addBottomRow(*row.first, row.second);
+
+    // The degree is the most significant part of the monomial order, so
+    // only the columns within each degree bucket need to be sorted. The
+    // buckets are then put in order by comparing any one monomial from each.
+    // The column monomials are handed over to the projection without
+    // copying them.
     const auto cmp = [&](const IndexMono& a, const IndexMono b) {
       return monoid().lessThan(*b.second, *a.second);
     };
-    mgb::mtbb::parallel_sort(columns.begin(), columns.end(), cmp);
+    std::vector<std::vector<IndexMono>*> buckets;
+    for (auto& bucket : mColumnsByDegree) {
+      MATHICGB_ASSERT(!bucket.second.empty());
+      mgb::mtbb::parallel_sort(bucket.second.begin(), bucket.second.end(), cmp);
+      buckets.push_back(&bucket.second);
+    }
 
-    const auto colEnd = columns.end();
-    for (auto it = columns.begin(); it != colEnd; ++it) {
-      const auto p = *it;
-      projection.addColumn(p.first, *p.second, mIsColumnToLeft[p.first]);
+    // The bucketed monomials point into mMap, which goes away with this
+    // builder, so copy them into arenas that the matrix will own. Each
+    // thread has its own arena so no locking is needed, and the whole lot
+    // is released in one go when the matrix is done with.
+    mgb::mtbb::enumerable_thread_specific<MonoArena<Monoid>> arenas([&](){
+      return MonoArena<Monoid>(monoid());
+    });
+    for (auto* bucket : buckets) {
+      mgb::mtbb::parallel_for(
+        mgb::mtbb::blocked_range<size_t>(0, bucket->size(), 1024),
+        [&](const mgb::mtbb::blocked_range<size_t>& range) {
+          auto& arena = arenas.local();
+          for (auto i = range.begin(); i != range.end(); ++i) {
+            auto& column = (*bucket)[i];
+            arena.push_back(*column.second);
+            column.second = arena.back().ptr();
+          }
+        }
+      );
+    }
+    std::sort(buckets.begin(), buckets.end(),
+      [&](const std::vector<IndexMono>* a, const std::vector<IndexMono>* b) {
+        return cmp(a->front(), b->front());
+      }
+    );
+    std::vector<ConstMonoPtr> columnMonos;
+    if (mRecordPlan != nullptr)
+      columnMonos.resize(mMap.entryCount());
+    for (const auto* bucket : buckets) {
+      for (const auto& column : *bucket) {
+        projection.addColumn
+          (column.first, column.second, mIsColumnToLeft[column.first]);
+        if (mRecordPlan != nullptr)
+          columnMonos[column.first] = column.second;
+      }
     }
+    mColumnsByDegree.clear();
 
-    quadMatrix = projection.makeAndClear(mMemoryQuantum);
+    std::vector<const ColIndex*> bottomRows;
+    quadMatrix = projection.makeAndClear
+      (mMemoryQuantum, mRecordPlan != nullptr ? &bottomRows : nullptr);
+    if (mRecordPlan != nullptr)
+      recordBottomRows(bottomRows, rowPolys, columnMonos);
+    for (auto& arena : arenas)
+      if (!arena.empty())
+        quadMatrix.monomialStorage.push_back(std::move(arena));
 
     MATHICGB_LOG(F4MatrixSizes) 
       << "F4[" 
@@ -269,12 +363,35 @@ public:
   const Monoid& monoid() const {return ring().monoid();}
   const Field& field() const {return ring().field();}
 
-    Builder(const PolyBasis& basis, const size_t memoryQuantum):
+  Builder(
+    const PolyBasis& basis,
+    const SigPolyBasis* sigBasis,
+    ConstMonoPtr sig,
+    const bool interreduce,
+    F4MatrixPlan* recordPlan,
+    const F4MatrixPlan* replayPlan,
+    ClassicReducerCache* reducerCache,
+    const size_t memoryQuantum
+  ):
     mMemoryQuantum(memoryQuantum),
     mTmp(basis.ring().monoid().alloc()),
+    mMap(basis.ring()),
+    mNewColumns([]() {return NewColumns();}),
     mBasis(basis),
-    mMap(basis.ring())
+    mSigBasis(sigBasis),
+    mSig(sig),
+    mInterreduce(interreduce),
+    mRecordPlan(recordPlan),
+    mReplayPlan(replayPlan),
+    mReducerCache(reducerCache)
   {
+    if (mSigBasis == nullptr)
+      mLookup = make_unique<FrozenMonoLookup>(mBasis);
+    MATHICGB_ASSERT(mSigBasis == nullptr || mReducerCache == nullptr);
+    if (mReducerCache != nullptr)
+      mReducerCache->update(mBasis);
+    MATHICGB_ASSERT((mSigBasis == nullptr) == mSig.isNull());
+    MATHICGB_ASSERT(mSigBasis == nullptr || !mInterreduce);
     // This assert has to be _NO_ASSUME since otherwise the compiler will
     // assume that the error checking branch here cannot be taken and optimize
     // it away.
@@ -284,11 +401,59 @@ public:
       mathic::reportInternalError("F4MatrixBuilder2: too large characteristic.");
   }
 
+  ~Builder() {
+    for (auto& newColumns : mNewColumns)
+      for (auto& product : newColumns.products)
+        monoid().freeRaw(product);
+  }
+
   typedef const Map::Reader ColReader;
   typedef std::vector<monomial> Monomials;
 
   typedef mgb::mtbb::parallel_do_feeder<RowTask> TaskFeeder;
 
+  /// The columns of a row that did not exist when the row was looked up in
+  /// the column map. Each thread has its own. The MonoRef's cannot be Mono's
+  /// for the same reason as in ThreadData.
+  struct NewColumns {
+    void clear() {
+      monos.clear();
+      targets.clear();
+    }
+
+    /// The monomials of the new columns. The first monos.size() entries of
+    /// products are in use. products only grows, so that the monomials can
+    /// be reused for later rows.
+    std::vector<MonoRef> products;
+    std::vector<ConstMonoPtr> monos;
+
+    /// The index of the column of monos[i] is to be written to *targets[i].
+    std::vector<ColIndex*> targets;
+
+    /// The reducer of each column.
+    std::vector<size_t> reducers;
+  };
+
+  /// Computes monoA * monoB into the next free product of newColumns and
+  /// returns it.
+  MonoRef addProduct(
+    ConstMonoRef monoA,
+    ConstMonoRef monoB,
+    NewColumns& newColumns
+  ) {
+    const auto index = newColumns.monos.size();
+    if (index == newColumns.products.size()) {
+      // No lock needed since the monoid's pool is thread-safe.
+      newColumns.products.push_back(*monoid().alloc().release());
+    }
+    auto product = newColumns.products[index];
+    monoid().multiply(monoA, monoB, product);
+    if (!monoid().hasAmpleCapacity(product))
+      mathic::reportError("Monomial exponent overflow in F4MatrixBuilder2.");
+    newColumns.monos.push_back(product.ptr());
+    return product;
+  }
+
   /// Creates a column with monomial label monoA * monoB and schedules a new
   /// row to reduce that column if possible. If such a column already
   /// exists, then a new column is not inserted. In either case, returns
@@ -306,29 +471,106 @@ public:
     ConstMonoRef monoB,
     TaskFeeder& feeder
   ) {
+    // Compute the product and look for a classic reducer before grabbing
+    // the lock, since the frozen lookup can be queried from many threads at
+    // once. If another thread creates the same column in the meantime, then
+    // that work is wasted, but that is rare.
+    auto& newColumns = mNewColumns.local();
+    newColumns.clear();
+    const auto product = addProduct(monoA, monoB, newColumns);
+    auto reducerIndex = static_cast<size_t>(-1);
+    if (
+      mLookup != nullptr &&
+      (mReducerCache == nullptr || !mReducerCache->find(product, reducerIndex))
+    )
+      reducerIndex = mLookup->classicReducer(product);
+
+    mgb::mtbb::mutex::scoped_lock lock(mCreateColumnLock);
+    return insertColumn(product, reducerIndex, feeder);
+  }
+
+  /// Creates the columns of newColumns and writes the index of the column
+  /// of newColumns.monos[i] to *newColumns.targets[i]. Works like
+  /// createColumn, except that the reducers are looked up in one batch and
+  /// that the lock is only grabbed once. The columns of newColumns are
+  /// reordered.
+  MATHICGB_NO_INLINE
+  void createColumns(NewColumns& newColumns, TaskFeeder& feeder) {
+    const auto count = newColumns.monos.size();
+    MATHICGB_ASSERT(newColumns.targets.size() == count);
+    auto& monos = newColumns.monos;
+    auto& targets = newColumns.targets;
+    auto& reducers = newColumns.reducers;
+    reducers.resize(count);
+    if (mLookup == nullptr)
+      std::fill_n(reducers.begin(), count, static_cast<size_t>(-1));
+    else {
+      // Move the columns that are not in the cache to the front and look
+      // up only those in the basis.
+      size_t missCount = count;
+      if (mReducerCache != nullptr) {
+        missCount = 0;
+        for (size_t i = 0; i < count; ++i) {
+          if (mReducerCache->find(*monos[i], reducers[i]))
+            continue;
+          std::swap(monos[i], monos[missCount]);
+          std::swap(targets[i], targets[missCount]);
+          std::swap(reducers[i], reducers[missCount]);
+          ++missCount;
+        }
+      }
+      if (missCount > 0)
+        mLookup->classicReducers(monos.data(), missCount, reducers.data());
+    }
+
     mgb::mtbb::mutex::scoped_lock lock(mCreateColumnLock);
+    for (size_t i = 0; i < count; ++i) {
+      const auto col = insertColumn
+        (*newColumns.monos[i], newColumns.reducers[i], feeder);
+      *newColumns.targets[i] = col.first;
+    }
+  }
+
+  /// Returns the column of mono, creating it if it does not exist yet. If
+  /// the column is created then reducerIndex is its classic reducer. Call
+  /// this only while holding mCreateColumnLock.
+  std::pair<ColIndex, ConstMonoRef> insertColumn(
+    ConstMonoRef mono,
+    size_t reducerIndex,
+    TaskFeeder& feeder
+  ) {
     // see if the column exists now after we have synchronized
     {
-      const auto found(ColReader(mMap).findProduct(monoA, monoB));
+      const auto found(ColReader(mMap).find(mono));
       if (found.first != 0)
         return std::make_pair(*found.first, *found.second);
     }
 
-    // The column really does not exist, so we need to create it
-    monoid().multiply(monoA, monoB, mTmp);
-    if (!monoid().hasAmpleCapacity(*mTmp))
-      mathic::reportError("Monomial exponent overflow in F4MatrixBuilder2.");
-
-    // look for a reducer of mTmp
-    const size_t reducerIndex = mBasis.classicReducer(*mTmp);
-    const bool insertLeft = (reducerIndex != static_cast<size_t>(-1));
+    // The column really does not exist, so we need to create it. The
+    // signature basis does not support concurrent queries, so regular
+    // reducers are looked for while holding the lock.
+    if (mSigBasis != nullptr) {
+      reducerIndex = mSigBasis->regularReducer(*mSig, mono);
+      if (reducerIndex != static_cast<size_t>(-1))
+        mBasis.usedAsReducer(reducerIndex);
+    }
+    // When interreducing, the lead monomial of a basis element must stay on
+    // the right so that the bottom row of that element is not reduced away.
+    const bool insertLeft = reducerIndex != static_cast<size_t>(-1) && !(
+      mInterreduce && monoid().equal(mBasis.leadMono(reducerIndex), mono)
+    );
+    if (mRecordPlan != nullptr)
+      recordColumn(mono, insertLeft ? reducerIndex : size_t(-1));
 
     // Create the new left or right column
     if (mIsColumnToLeft.size() >= std::numeric_limits<ColIndex>::max())
       throw std::overflow_error("Too many columns in QuadMatrix");
     const auto newIndex = static_cast<ColIndex>(mIsColumnToLeft.size());
-    const auto inserted = mMap.insert(std::make_pair(mTmp.ptr(), newIndex));
+    const auto inserted = mMap.insert(std::make_pair(mono.ptr(), newIndex));
     mIsColumnToLeft.push_back(insertLeft);
+    addColumnToBucket(newIndex, inserted.first.second);
+    if (mReducerCache != nullptr)
+      mCachedColumns.emplace_back(inserted.first.second, reducerIndex);
 
     // schedule new task if we found a reducer
     if (insertLeft) {
@@ -341,8 +583,171 @@ public:
     return std::make_pair(*inserted.first.first, *inserted.first.second);
   }
 
+  /// Appends a column with monomial mono and reducer reducer to the
+  /// record plan. Call this only while holding mCreateColumnLock or while
+  /// there is no concurrency.
+  void recordColumn(ConstMonoRef mono, size_t reducer) {
+    auto& monomials = mRecordPlan->monomials;
+    for (size_t var = 0; var < monoid().varCount(); ++var)
+      monomials.push_back(monoid().externalExponent(mono, var));
+    monomials.push_back(monoid().component(mono));
+    mRecordPlan->reducers.push_back(reducer);
+  }
+
+  /// Lists the bottom rows of the matrix in the record plan as the
+  /// candidate zero rows, identified by the index of the basis element they
+  /// are a multiple of and by their lead monomial. The reducer then keeps
+  /// only those that reduced to zero. This has to happen before the column
+  /// monomials go away.
+  void recordBottomRows(
+    const std::vector<const ColIndex*>& bottomRows,
+    const std::unordered_map<const ColIndex*, const Poly*>& rowPolys,
+    const std::vector<ConstMonoPtr>& columnMonos
+  ) {
+    std::unordered_map<const Poly*, size_t> polyIndices;
+    for (size_t i = 0; i < mBasis.size(); ++i)
+      if (!mBasis.retired(i))
+        polyIndices[&mBasis.poly(i)] = i;
+
+    auto& polys = mRecordPlan->zeroRowPolys;
+    auto& leads = mRecordPlan->zeroRowLeads;
+    polys.clear();
+    leads.clear();
+    for (const auto indices : bottomRows) {
+      const auto poly = rowPolys.find(indices);
+      MATHICGB_ASSERT(poly != rowPolys.end());
+      const auto index = polyIndices.find(poly->second);
+      polys.push_back(
+        index == polyIndices.end() ? static_cast<size_t>(-1) : index->second
+      );
+      const auto& lead = *columnMonos[indices[0]];
+      for (size_t var = 0; var < monoid().varCount(); ++var)
+        leads.push_back(monoid().externalExponent(lead, var));
+      leads.push_back(monoid().component(lead));
+    }
+  }
+
+  /// Removes the tasks for the rows that plan says reduced to zero. Those
+  /// were bottom rows, so the top row with the same lead is still there,
+  /// and a row that reduces to zero does not change the result. Only the
+  /// initial tasks are looked at, not the reducer rows found later.
+  void skipZeroRows(const F4MatrixPlan& plan, std::vector<RowTask>& tasks) {
+    const auto varCount = monoid().varCount();
+    const auto stride = varCount + 1;
+    const auto& polys = plan.zeroRowPolys;
+    const auto& leads = plan.zeroRowLeads;
+    if (polys.empty() || leads.size() != polys.size() * stride)
+      return;
+
+    // A zero row is used up once a task matches it, so that of two equal
+    // rows where only one reduced to zero, the other one is kept.
+    std::unordered_multimap<const Poly*, size_t> zeroRows;
+    for (size_t row = 0; row < polys.size(); ++row)
+      if (polys[row] < mBasis.size() && !mBasis.retired(polys[row]))
+        zeroRows.emplace(&mBasis.poly(polys[row]), row);
+    const auto isZeroRow = [&](const RowTask& task) {
+      if (task.sPairPoly != nullptr)
+        return false;
+      const auto& lead = task.desiredLead != nullptr ?
+        *task.desiredLead : task.poly->leadMono();
+      const auto range = zeroRows.equal_range(task.poly);
+      for (auto it = range.first; it != range.second; ++it) {
+        const auto exponents = leads.data() + it->second * stride;
+        bool equal = exponents[varCount] ==
+          static_cast<int32>(monoid().component(lead));
+        for (size_t var = 0; equal && var < varCount; ++var)
+          equal = exponents[var] == monoid().externalExponent(lead, var);
+        if (equal) {
+          zeroRows.erase(it);
+          return true;
+        }
+      }
+      return false;
+    };
+
+    const auto newEnd = std::remove_if(tasks.begin(), tasks.end(),
+      [&](const RowTask& task) {
+        if (!isZeroRow(task))
+          return false;
+        if (task.desiredLead != nullptr)
+          monoid().freeRaw(*task.desiredLead.castAwayConst());
+        return true;
+      }
+    );
+    tasks.erase(newEnd, tasks.end());
+  }
+
+  /// Creates the columns of plan that do not exist yet, and schedules a
+  /// reducer row for each of them that has a reducer. This is done before
+  /// any rows are constructed, so no locking is needed.
+  void seedColumns(const F4MatrixPlan& plan, std::vector<RowTask>& tasks) {
+    MATHICGB_ASSERT(mSigBasis == nullptr);
+    MATHICGB_ASSERT(!mInterreduce);
+    const auto varCount = monoid().varCount();
+    const auto stride = varCount + 1;
+    if (plan.monomials.size() != plan.reducers.size() * stride)
+      return; // not a plan for this ring
+
+    const auto noReducer = static_cast<size_t>(-1);
+    for (size_t col = 0; col < plan.reducers.size(); ++col) {
+      const auto exponents = plan.monomials.data() + col * stride;
+      const auto negative = [](const int32 e) {return e < 0;};
+      if (std::any_of(exponents, exponents + stride, negative))
+        continue;
+      monoid().setIdentity(*mTmp);
+      for (size_t var = 0; var < varCount; ++var)
+        monoid().setExternalExponent(var, exponents[var], *mTmp);
+      monoid().setComponent(exponents[varCount], *mTmp);
+      if (!monoid().hasAmpleCapacity(*mTmp))
+        continue;
+      if (ColReader(mMap).find(*mTmp).first != 0)
+        continue;
+
+      const auto reducer = plan.reducers[col];
+      const bool insertLeft = reducer != noReducer;
+      if (insertLeft && (
+        reducer >= mBasis.size() ||
+        mBasis.retired(reducer) ||
+        !monoid().divides(mBasis.leadMono(reducer), *mTmp)
+      ))
+        continue; // leave it to symbolic preprocessing
+
+      if (mIsColumnToLeft.size() >= std::numeric_limits<ColIndex>::max())
+        throw std::overflow_error("Too many columns in QuadMatrix");
+      const auto newIndex = static_cast<ColIndex>(mIsColumnToLeft.size());
+      const auto inserted = mMap.insert(std::make_pair(mTmp.ptr(), newIndex));
+      mIsColumnToLeft.push_back(insertLeft);
+      addColumnToBucket(newIndex, inserted.first.second);
+      if (mRecordPlan != nullptr)
+        recordColumn(*mTmp, reducer);
+
+      // The monomials of tasks are freed once the rows are built, so the
+      // task gets its own copy of the column monomial.
+      if (insertLeft) {
+        auto desiredLead = monoid().alloc();
+        monoid().copy(*inserted.first.second, *desiredLead);
+        RowTask task = {};
+        task.poly = &mBasis.poly(reducer);
+        task.desiredLead = desiredLead.release();
+        tasks.push_back(task);
+      }
+    }
+  }
+
+  /// Records the monomial of a newly created column in the bucket for its
+  /// degree. mono must point into mMap. It is not copied here so that as
+  /// little work as possible is done while holding the lock. Call this only
+  /// while holding mCreateColumnLock or while there is no concurrency.
+  void addColumnToBucket(ColIndex index, ConstMonoPtr mono) {
+    const auto degree =
+      monoid().gradingCount() == 0 ? 0 : monoid().degree(*mono);
+    mColumnsByDegree[degree].emplace_back(index, mono);
+  }
 
   /// Append multiple * poly to block, creating new columns as necessary.
+  /// The columns that do not exist yet are created together once the rest
+  /// of the row is done, so that their reducers can be looked up in one
+  /// batch.
   void appendRow(
     ConstMonoRef multiple,
     const Poly& poly,
@@ -355,46 +760,46 @@ public:
     MATHICGB_ASSERT(count < std::numeric_limits<ColIndex>::max());
     auto indices = block.makeRowWithTheseScalars(poly);
 
+    auto& newColumns = mNewColumns.local();
+    newColumns.clear();
+    const auto setColumn = [&](const ColIndex* col, ConstMonoRef mono) {
+      if (col != 0)
+        *indices = *col;
+      else {
+        addProduct(mono, multiple, newColumns);
+        newColumns.targets.push_back(indices);
+      }
+      ++indices;
+    };
+
+    const ColReader colMap(mMap);
     auto it = begin;
     if ((count % 2) == 1) {
-      ColReader reader(mMap);
-      const auto col = findOrCreateColumn
-        (it.mono(), multiple, reader, feeder);
-	  MATHICGB_ASSERT(it.coef() < std::numeric_limits<Scalar>::max());
+      MATHICGB_ASSERT(it.coef() < std::numeric_limits<Scalar>::max());
       MATHICGB_ASSERT(!field().isZero(it.coef()));
-      *indices = col.first;
-      ++indices;
+      setColumn(colMap.findProduct(it.mono(), multiple).first, it.mono());
       ++it;
     }
-  updateReader:
-    ColReader colMap(mMap);
     while (it != end) {
-	  MATHICGB_ASSERT(it.coef() < std::numeric_limits<Scalar>::max());
+      MATHICGB_ASSERT(it.coef() < std::numeric_limits<Scalar>::max());
       MATHICGB_ASSERT(!field().isZero(it.coef()));
-      const auto scalar1 = static_cast<Scalar>(it.coef());
       const auto mono1 = it.mono();
 
       auto it2 = it;
       ++it2;
-	  MATHICGB_ASSERT(it2.coef() < std::numeric_limits<Scalar>::max());
+      MATHICGB_ASSERT(it2.coef() < std::numeric_limits<Scalar>::max());
       MATHICGB_ASSERT(!field().isZero(it2.coef()));
-      const auto scalar2 = static_cast<Scalar>(it2.coef());
       const auto mono2 = it2.mono();
 
       const auto colPair = colMap.findTwoProducts(mono1, mono2, multiple);
-      if (colPair.first == 0 || colPair.second == 0) {
-        createColumn(mono1, multiple, feeder);
-        createColumn(mono2, multiple, feeder);
-        goto updateReader;
-      }
-
-      *indices = *colPair.first;
-      ++indices;
-      *indices = *colPair.second;
-      ++indices;
+      setColumn(colPair.first, mono1);
+      setColumn(colPair.second, mono2);
 
       it = ++it2;
     }
+
+    if (!newColumns.targets.empty())
+      createColumns(newColumns, feeder);
   }
 
   /// Append poly*multiply - sPairPoly*sPairMultiply to block, creating new
@@ -526,6 +931,12 @@ public:
   /// If you want to modify the columns, you need to grab this lock first.
   mgb::mtbb::mutex mCreateColumnLock;
 
+  /// The columns, with their monomials in mMap, bucketed by degree. A
+  /// std::map is used since the degrees can be spread far apart while there
+  /// are usually few distinct ones. Protected by mCreateColumnLock.
+  typedef std::pair<ColIndex, ConstMonoPtr> IndexMono;
+  std::map<Monoid::Exponent, std::vector<IndexMono>> mColumnsByDegree;
+
   /// A monomial for temporary scratch calculations. Protected by
   /// mCreateColumnLock.
   Mono mTmp;
@@ -533,16 +944,67 @@ public:
   /// Mapping from monomials to column indices.
   Map mMap;
 
+  /// Scratch space for the new columns of the row that each thread is
+  /// working on.
+  mgb::mtbb::enumerable_thread_specific<NewColumns> mNewColumns;
+
+  /// Supplies classic reducers without locking. Null if mSigBasis is not.
+  std::unique_ptr<FrozenMonoLookup> mLookup;
+
   /// The basis that supplies reducers.
   const PolyBasis& mBasis;
+
+  /// If not null, only regular reducers in signature *mSig are used.
+  const SigPolyBasis* const mSigBasis;
+  const ConstMonoPtr mSig;
+
+  /// If true then lead monomials of basis elements get no reducer rows.
+  const bool mInterreduce;
+
+  /// If not null, the columns created are recorded here. Protected by
+  /// mCreateColumnLock.
+  F4MatrixPlan* const mRecordPlan;
+
+  /// If not null, the columns of this plan are created up front.
+  const F4MatrixPlan* const mReplayPlan;
+
+  /// If not null, classic reducers are looked for here first.
+  ClassicReducerCache* const mReducerCache;
+
+  /// The columns created by insertColumn with their classic reducers, to be
+  /// added to mReducerCache once all rows are constructed. The monomials
+  /// point into mMap. Protected by mCreateColumnLock.
+  std::vector<std::pair<ConstMonoPtr, size_t>> mCachedColumns;
 };
 
 F4MatrixBuilder2::F4MatrixBuilder2(
   const PolyBasis& basis,
   const size_t memoryQuantum
 ):
+  mMemoryQuantum(memoryQuantum),
   mBasis(basis),
-  mMemoryQuantum(memoryQuantum)
+  mSigBasis(nullptr),
+  mInterreduce(false),
+  mRecordPlan(nullptr),
+  mReplayPlan(nullptr),
+  mReducerCache(nullptr),
+  mBottomCount(0)
+{}
+
+F4MatrixBuilder2::F4MatrixBuilder2(
+  const SigPolyBasis& basis,
+  ConstMonoRef sig,
+  const size_t memoryQuantum
+):
+  mMemoryQuantum(memoryQuantum),
+  mBasis(basis.basis()),
+  mSigBasis(&basis),
+  mSig(&sig),
+  mInterreduce(false),
+  mRecordPlan(nullptr),
+  mReplayPlan(nullptr),
+  mReducerCache(nullptr),
+  mBottomCount(0)
 {}
 
 void F4MatrixBuilder2::addSPolynomialToMatrix(
@@ -553,10 +1015,11 @@ void F4MatrixBuilder2::addSPolynomialToMatrix(
   MATHICGB_ASSERT(polyA.isMonic());
   MATHICGB_ASSERT(!polyB.isZero());
   MATHICGB_ASSERT(polyB.isMonic());
+  MATHICGB_ASSERT(mSigBasis == nullptr);
 
   auto desiredLead = monoid().alloc();
   monoid().lcm(polyA.leadMono(), polyB.leadMono(), *desiredLead);
-  RowTask task = {desiredLead.release(), &polyA, &polyB};
+  RowTask task = {desiredLead.release(), &polyA, &polyB, false, 0};
   mTodo.push_back(task);
 }
 
@@ -566,6 +1029,9 @@ void F4MatrixBuilder2::addPolynomialToMatrix(const Poly& poly) {
 
   RowTask task = {};
   task.poly = &poly;
+  task.bottom = mSigBasis != nullptr;
+  if (task.bottom)
+    task.bottomIndex = mBottomCount++;
   mTodo.push_back(task);
 }
 
@@ -578,13 +1044,53 @@ void F4MatrixBuilder2::addPolynomialToMatrix(
 
   auto desiredLead = monoid().alloc();
   monoid().multiply(poly.leadMono(), multiple, desiredLead);
-  RowTask task = {desiredLead.release(), &poly, nullptr};
+  RowTask task = {desiredLead.release(), &poly, nullptr, false, 0};
+  task.bottom = mSigBasis != nullptr;
+  if (task.bottom)
+    task.bottomIndex = mBottomCount++;
   mTodo.push_back(task);
 }
 
+void F4MatrixBuilder2::addBasisElementToInterreduce(const Poly& poly) {
+  MATHICGB_ASSERT(mSigBasis == nullptr);
+  MATHICGB_ASSERT(!poly.isZero());
+  mInterreduce = true;
+
+  RowTask task = {};
+  task.poly = &poly;
+  task.bottom = true;
+  task.bottomIndex = mBottomCount++;
+  mTodo.push_back(task);
+}
+
+void F4MatrixBuilder2::setPlans(
+  F4MatrixPlan* record,
+  const F4MatrixPlan* replay
+) {
+  MATHICGB_ASSERT(mSigBasis == nullptr);
+  mRecordPlan = record;
+  mReplayPlan = replay;
+}
+
+void F4MatrixBuilder2::setReducerCache(ClassicReducerCache* cache) {
+  MATHICGB_ASSERT(mSigBasis == nullptr);
+  mReducerCache = cache;
+}
+
 void F4MatrixBuilder2::buildMatrixAndClear(QuadMatrix& quadMatrix) {
-  Builder builder(mBasis, mMemoryQuantum);
+  MATHICGB_ASSERT(mReplayPlan == nullptr || !mInterreduce);
+  Builder builder(
+    mBasis,
+    mSigBasis,
+    mSig,
+    mInterreduce,
+    mRecordPlan,
+    mReplayPlan,
+    mReducerCache,
+    mMemoryQuantum
+  );
   builder.buildMatrixAndClear(mTodo, quadMatrix);
+  mBottomCount = 0;
 }
 
 MATHICGB_NAMESPACE_END
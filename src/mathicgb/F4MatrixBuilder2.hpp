@@ -15,6 +15,10 @@
 
 MATHICGB_NAMESPACE_BEGIN
 
+class SigPolyBasis;
+struct F4MatrixPlan;
+class ClassicReducerCache;
+
 /// Class for constructing an F4 matrix.
 ///
 /// @todo: this class does not offer exception guarantees. It's just not
@@ -36,6 +40,21 @@ public:
   /// small and double the quantum at each exhaustion.
   F4MatrixBuilder2(const PolyBasis& basis, size_t memoryQuantum = 0);
 
+  /// Constructs a builder for regular reduction in signature sig. A column
+  /// only gets a reducer row if some basis element regular reduces that
+  /// column monomial in signature sig, so every top row of the matrix has
+  /// signature strictly less than sig. Rows scheduled by calling
+  /// addPolynomialToMatrix are always put on the bottom, in the order they
+  /// were scheduled and with one bottom row each. So reducing the bottom rows
+  /// by the top rows performs only regular reduction steps. Each top row
+  /// counts as a use of its basis element as a reducer. sig must remain
+  /// valid until the matrix is constructed.
+  F4MatrixBuilder2(
+    const SigPolyBasis& basis,
+    ConstMonoRef sig,
+    size_t memoryQuantum = 0
+  );
+
   /// Schedules a row representing the S-polynomial between polyA and
   /// polyB to be added to the matrix. No ownership is taken, but polyA
   /// and polyB must remain valid until the matrix is constructed.
@@ -43,6 +62,8 @@ public:
   /// Currently, the two monomials must be monic, though this is just
   /// because they happen always to be monic so there was no reason to
   /// support the non-monic case.
+  ///
+  /// Not supported for builders that construct regular reduction matrices.
   void addSPolynomialToMatrix(const Poly& polyA, const Poly& polyB);
 
   /// Schedules a row representing multiple*poly to be added to the
@@ -54,6 +75,36 @@ public:
   /// As the overload with a multiple, where the multiple is 1.
   void addPolynomialToMatrix(const Poly& poly);
 
+  /// Schedules poly, which must be a non-retired element of a minimal
+  /// basis, as a bottom row for interreduction. Once this has been called,
+  /// columns whose monomial is the lead monomial of a basis element get no
+  /// reducer row. If this is called for every non-retired basis element,
+  /// then the reduced row echelon form of the bottom right matrix consists
+  /// of the elements of the reduced Groebner basis, assuming that the basis
+  /// is a minimal Groebner basis.
+  ///
+  /// Not supported together with S-polynomials or for builders that
+  /// construct regular reduction matrices.
+  void addBasisElementToInterreduce(const Poly& poly);
+
+  /// The columns found by symbolic preprocessing and their reducers are
+  /// recorded into record if it is not null. If replay is not null, the
+  /// columns of replay and their reducer rows are put into the matrix up
+  /// front, which skips looking for reducers of those columns. A column of
+  /// replay is left out if its reducer is retired or no longer divides the
+  /// column monomial, while a column of replay that has no reducer is
+  /// trusted not to have one. Both plans must remain valid until the
+  /// matrix is constructed. Not supported for builders that construct
+  /// regular reduction matrices or that interreduce.
+  void setPlans(F4MatrixPlan* record, const F4MatrixPlan* replay);
+
+  /// If cache is not null, classic reducers are looked for in cache before
+  /// they are looked for in the basis, and the reducers that are found in
+  /// the basis are added to cache. cache is updated to the basis when the
+  /// matrix is constructed. Not supported for builders that construct
+  /// regular reduction matrices.
+  void setReducerCache(ClassicReducerCache* cache);
+
   /// Builds an F4 matrix to the specifications given. Also clears the
   /// information in this object.
   ///
@@ -87,6 +138,8 @@ private:
     ConstMonoPtr desiredLead; // multiply a monomial onto poly to get this lead
     const Poly* poly;
     const Poly* sPairPoly;
+    bool bottom; // if true then this row must not become a top/reducer row
+    size_t bottomIndex; // if bottom, how many bottom rows were added before
   };
 
   class Builder;
@@ -97,8 +150,22 @@ private:
   /// The basis that supplies reducers.
   const PolyBasis& mBasis;
 
+  /// If not null, only regular reducers in signature *mSig are used.
+  const SigPolyBasis* const mSigBasis;
+  const ConstMonoPtr mSig;
+
+  /// If true then lead monomials of basis elements get no reducer rows.
+  bool mInterreduce;
+
+  F4MatrixPlan* mRecordPlan;
+  const F4MatrixPlan* mReplayPlan;
+  ClassicReducerCache* mReducerCache;
+
   /// Stores the rows that have been scheduled to be added.
   std::vector<RowTask> mTodo;
+
+  /// The number of rows in mTodo that must be put on the bottom.
+  size_t mBottomCount;
 };
 
 MATHICGB_NAMESPACE_END
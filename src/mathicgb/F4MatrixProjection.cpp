@@ -17,27 +17,24 @@ F4MatrixProjection::F4MatrixProjection(
 
 void F4MatrixProjection::addColumn(
   const ColIndex projectFrom,
-  ConstMonoRef mono,
+  ConstMonoPtr mono,
   const bool isLeft
 ) {
   MATHICGB_ASSERT(projectFrom < mColProjectTo.size());
   MATHICGB_ASSERT
     (mLeftMonomials.size() + mRightMonomials.size() < mColProjectTo.size());
-
-  auto monoCopy = mRing.monoid().alloc();
-  mRing.monoid().copy(mono, *monoCopy);
+  MATHICGB_ASSERT(!mono.isNull());
 
   auto& projected = mColProjectTo[projectFrom];
   if (isLeft) {
     projected.isLeft = true;
     projected.index = static_cast<ColIndex>(mLeftMonomials.size());
-    mLeftMonomials.push_back(monoCopy.ptr());
+    mLeftMonomials.push_back(mono);
   } else {
     projected.isLeft = false;
     projected.index = static_cast<ColIndex>(mRightMonomials.size());
-    mRightMonomials.push_back(monoCopy.ptr());
+    mRightMonomials.push_back(mono);
   }
-  monoCopy.release();
 }
 
 struct RowData : F4ProtoMatrix::Row {
@@ -62,6 +59,11 @@ public:
     MATHICGB_ASSERT(leftColCount <= std::numeric_limits<ColIndex>::max());
   }
 
+  void addBottomRow(const Row& row) {
+    if (row.entryCount != 0)
+      mBottomRows.push_back(RowMultiple(row, 1));
+  }
+
   void addRow(const Row& row, ColIndex leadIndex, Scalar leadScalar) {
     if (row.entryCount == 0)
       return; // Skip zero rows.
@@ -219,14 +221,20 @@ private:
   SparseMatrix mRight;
 };
 
-QuadMatrix F4MatrixProjection::makeAndClear(const size_t quantum) {
+QuadMatrix F4MatrixProjection::makeAndClear(
+  const size_t quantum,
+  std::vector<const ColIndex*>* bottomRows
+) {
   if (true)
-    return makeAndClearOneStep(quantum);
+    return makeAndClearOneStep(quantum, bottomRows);
   else
     return makeAndClearTwoStep(quantum);
 }
 
-QuadMatrix F4MatrixProjection::makeAndClearOneStep(const size_t quantum) {
+QuadMatrix F4MatrixProjection::makeAndClearOneStep(
+  const size_t quantum,
+  std::vector<const ColIndex*>* bottomRows
+) {
   // Construct top/bottom row permutation
    TopBottom<F4ProtoMatrix::Row> tb(mLeftMonomials.size(), ring());
   const auto end = mMatrices.end();
@@ -256,7 +264,14 @@ QuadMatrix F4MatrixProjection::makeAndClearOneStep(const size_t quantum) {
 done:;
     }
   }
+  for (const auto& row : mBottomRows)
+    tb.addBottomRow(row.first->row(row.second));
   MATHICGB_ASSERT(tb.debugAssertValid());
+  if (bottomRows != nullptr) {
+    bottomRows->clear();
+    for (const auto& row : tb.bottom())
+      bottomRows->push_back(row.first.indices);
+  }
 
   // Split left/right and top/bottom simultaneously
   LeftRight top(mColProjectTo, ring(), quantum);
@@ -317,6 +332,12 @@ QuadMatrix F4MatrixProjection::makeAndClearTwoStep(const size_t quantum) {
   // Split whole matrix into left/right
   LeftRight lr(mColProjectTo, ring(), quantum);
   lr.appendRows(mMatrices);
+  const auto firstBottomOnlyRow = lr.left().rowCount();
+  for (const auto& bottomRow : mBottomRows) {
+    const auto row = bottomRow.first->row(bottomRow.second);
+    if (row.entryCount > 0)
+      lr.appendRow(row);
+  }
 
   // Construct top/bottom matrix permutation
   struct Row {
@@ -333,7 +354,9 @@ QuadMatrix F4MatrixProjection::makeAndClearTwoStep(const size_t quantum) {
       continue; // ignore zero rows
 
     const Row r = {row, entryCount};
-    if (leftEntryCount == 0)
+    if (row >= firstBottomOnlyRow)
+      tb.addBottomRow(r);
+    else if (leftEntryCount == 0)
       tb.addRow(r, std::numeric_limits<ColIndex>::max(), 0);
     else {
       const auto entry = lr.left().rowBegin(row);
@@ -29,15 +29,34 @@ public:
 
   void addProtoMatrix(F4ProtoMatrix&& matrix) {mMatrices.push_back(&matrix);}
 
-  // No reference to mono is retained.
-  void addColumn(ColIndex index, ConstMonoRef mono, const bool isLeft);
-
-  QuadMatrix makeAndClear(const size_t quantum);
+  /// Adds row row of matrix as a row that is always put on the bottom, so
+  /// it never becomes a top/reducer row. These rows come after the other
+  /// bottom rows, in the order they were added. No ownership is taken, but
+  /// matrix must remain valid until the QuadMatrix is made.
+  void addBottomRow(const F4ProtoMatrix& matrix, RowIndex row) {
+    mBottomRows.emplace_back(&matrix, row);
+  }
+
+  /// Adds the column with the given index with monomial mono. mono is not
+  /// copied, so it must stay valid for as long as the QuadMatrix that is
+  /// made. Usually mono lives in the monomialStorage of that matrix.
+  void addColumn(ColIndex index, ConstMonoPtr mono, const bool isLeft);
+
+  /// If bottomRows is not null, then it is set to the indices of the rows
+  /// that became bottom row 0, 1 and so on. The indices identify the rows
+  /// of the proto matrices, since each row has its own.
+  QuadMatrix makeAndClear(
+    const size_t quantum,
+    std::vector<const ColIndex*>* bottomRows = nullptr
+  );
 
   const PolyRing& ring() const {return mRing;}
 
 private:
-  QuadMatrix makeAndClearOneStep(const size_t quantum);
+  QuadMatrix makeAndClearOneStep(
+    const size_t quantum,
+    std::vector<const ColIndex*>* bottomRows
+  );
   QuadMatrix makeAndClearTwoStep(const size_t quantum);
 
   // Utility class for building a left/right projection.
@@ -55,6 +74,7 @@ private:
   std::vector<ColProjectTo> mColProjectTo;
 
   std::vector<F4ProtoMatrix*> mMatrices;
+  std::vector<std::pair<const F4ProtoMatrix*, RowIndex>> mBottomRows;
   std::vector<ConstMonoPtr> mLeftMonomials;
   std::vector<ConstMonoPtr> mRightMonomials;
   const PolyRing& mRing;
@@ -8,6 +8,7 @@
 #include "PolyRing.hpp"
 #include "LogDomain.hpp"
 #include "mtbb.hpp"
+#include "NonCopyable.hpp"
 #include <algorithm>
 #include <vector>
 #include <stdexcept>
@@ -15,6 +16,8 @@
 #include <string>
 #include <cstdio>
 #include <iostream>
+#include <random>
+#include <cmath>
 
 MATHICGB_DEFINE_LOG_DOMAIN(
   F4MatrixReduce,
@@ -31,6 +34,12 @@ MATHICGB_DEFINE_LOG_DOMAIN(
   "Displays time to reduce the bottom right submatrix of each F4 matrix."
 );
 
+MATHICGB_DEFINE_LOG_DOMAIN(
+  F4ProbabilisticRank,
+  "Displays the number of new pivots that the probabilistic reduction of "
+  "F4 matrices finds and how much work it took to find them."
+);
+
 MATHICGB_NAMESPACE_BEGIN
 
 namespace {
@@ -95,6 +104,15 @@ namespace {
 
     void appendTo(SparseMatrix& matrix) {matrix.appendRow(mEntries);}
 
+    /// Appends this row modulo modulus to matrix, scaled so that its leading
+    /// entry is 1. A zero row is appended as an empty row.
+    void appendUnitaryTo(
+      SparseMatrix& matrix,
+      const SparseMatrix::Scalar modulus
+    ) {
+      matrix.appendRowWithModulusNormalized(mEntries, modulus);
+    }
+
     void makeUnitary(const SparseMatrix::Scalar modulus, const size_t lead) {
       MATHICGB_ASSERT(lead < colCount());
       MATHICGB_ASSERT(mEntries[lead] != 0);
@@ -191,27 +209,15 @@ namespace {
     std::vector<ScalarProductSum> mEntries;
   };
 
-  SparseMatrix reduce(
-    const QuadMatrix& qm,
-    SparseMatrix::Scalar modulus
-  ) {
-    const SparseMatrix& toReduceLeft = qm.bottomLeft;
-    const SparseMatrix& toReduceRight = qm.bottomRight;
-    const SparseMatrix& reduceByLeft = qm.topLeft;
-    const SparseMatrix& reduceByRight = qm.topRight;
-
-    const auto leftColCount = qm.computeLeftColCount();
-    const auto rightColCount =
-      static_cast<SparseMatrix::ColIndex>(qm.computeRightColCount());
-    MATHICGB_ASSERT(leftColCount == reduceByLeft.rowCount());
-    const auto pivotCount = leftColCount;
-    const auto rowCount = toReduceLeft.rowCount();
-
-    // ** pre-calculate what rows are pivots for what columns.
+  /// Returns a vector whose entry col is the top row of qm that has its
+  /// leading entry in left column col. Store column indexes instead of row
+  /// indices as the top left matrix is square anyway (so all indices fit)
+  /// and the result is used as column indices later on.
+  std::vector<SparseMatrix::ColIndex> topRowOfLeftColumn(const QuadMatrix& qm) {
+    const auto& reduceByLeft = qm.topLeft;
+    const auto pivotCount = qm.computeLeftColCount();
+    MATHICGB_ASSERT(pivotCount == reduceByLeft.rowCount());
 
-    // Store column indexes instead of row indices as the matrix is square
-    // anyway (so all indices fit) and we are going to store this as a column
-    // index later on.
     std::vector<SparseMatrix::ColIndex> rowThatReducesCol(pivotCount);
 #ifdef MATHICGB_DEBUG
     // fill in an invalid value that can be recognized by asserts to be invalid.
@@ -228,92 +234,600 @@ namespace {
       MATHICGB_ASSERT(rowThatReducesCol[col] < pivotCount);
     }
 #endif
+    return rowThatReducesCol;
+  }
 
-    SparseMatrix reduced(qm.topRight.memoryQuantum());
+  /// Reduces the row whose left part is left and whose right part is right
+  /// by the top rows of qm. This makes left zero. rowThatReducesCol must be
+  /// topRowOfLeftColumn(qm). The entries of right are not reduced modulo
+  /// modulus.
+  void reduceByTopRows(
+    DenseRow& left,
+    DenseRow& right,
+    const QuadMatrix& qm,
+    const std::vector<SparseMatrix::ColIndex>& rowThatReducesCol,
+    const SparseMatrix::Scalar modulus
+  ) {
+    const SparseMatrix& reduceByLeft = qm.topLeft;
+    const SparseMatrix& reduceByRight = qm.topRight;
+    const auto pivotCount = rowThatReducesCol.size();
+    MATHICGB_ASSERT(left.colCount() == pivotCount);
 
-    mgb::mtbb::enumerable_thread_specific<DenseRow> denseRowPerThread([&](){
-      return DenseRow();
-    }); 
+    for (size_t pivot = 0; pivot < pivotCount; ++pivot) {
+      if (left[pivot] == 0)
+        continue;
+      auto entry = left[pivot];
+      entry %= modulus;
+      left[pivot] = 0;
+      if (entry == 0)
+        continue;
+      entry = modulus - entry;
+      const auto reducer = rowThatReducesCol[pivot];
+      MATHICGB_ASSERT(reducer < pivotCount);
+      MATHICGB_ASSERT(!reduceByLeft.emptyRow(reducer));
+      MATHICGB_ASSERT(reduceByLeft.leadCol(reducer) == pivot);
+      MATHICGB_ASSERT(entry < std::numeric_limits<SparseMatrix::Scalar>::max());
+      const auto scalar = static_cast<SparseMatrix::Scalar>(entry);
+      left.addRowMultiple(
+        scalar,
+        ++reduceByLeft.rowBegin(reducer),
+        reduceByLeft.rowEnd(reducer)
+      );
+      right.addRowMultiple(
+        scalar,
+        reduceByRight.rowBegin(reducer),
+        reduceByRight.rowEnd(reducer)
+      );
+    }
+  }
 
-    SparseMatrix tmp(qm.topRight.memoryQuantum());
+  SparseMatrix reduce(
+    const QuadMatrix& qm,
+    SparseMatrix::Scalar modulus,
+    std::vector<char>* zeroRows
+  ) {
+    const SparseMatrix& toReduceLeft = qm.bottomLeft;
+    const SparseMatrix& toReduceRight = qm.bottomRight;
 
-    std::vector<SparseMatrix::RowIndex> rowOrder(rowCount);
+    const auto leftColCount = qm.computeLeftColCount();
+    const auto rightColCount =
+      static_cast<SparseMatrix::ColIndex>(qm.computeRightColCount());
+    const auto rowCount = toReduceLeft.rowCount();
+    if (zeroRows != nullptr)
+      zeroRows->assign(rowCount, false);
+
+    // ** pre-calculate what rows are pivots for what columns.
+    const auto rowThatReducesCol = topRowOfLeftColumn(qm);
+
+    // Each worker reduces its rows into its own dense rows and appends the
+    // result to its own output matrix, so nothing is shared between the
+    // workers except the read-only pivot rows. The buffers of a worker are
+    // allocated and first written to by that worker, so an operating system
+    // with a first-touch policy places them on the memory node of the
+    // worker. The left and right parts of a row are reduced together so that
+    // the reduced left part does not have to be stored in between.
+    struct ThreadData {
+      DenseRow left;
+      DenseRow right;
+      SparseMatrix reduced;
+    };
+    const auto quantum = qm.topRight.memoryQuantum();
+    mgb::mtbb::enumerable_thread_specific<ThreadData> threadData([&](){
+      ThreadData data = {DenseRow(), DenseRow(), SparseMatrix(quantum)};
+      return data;
+    });
 
-    mgb::mtbb::mutex lock;
     mgb::mtbb::parallel_for(mgb::mtbb::blocked_range<SparseMatrix::RowIndex>(0, rowCount, 2),
       [&](const mgb::mtbb::blocked_range<SparseMatrix::RowIndex>& range)
     {
-      auto& denseRow = denseRowPerThread.local();
+      auto& data = threadData.local();
+      auto& left = data.left;
+      auto& right = data.right;
       for (auto it = range.begin(); it != range.end(); ++it) {
         const auto row = it;
-        denseRow.clear(leftColCount);
-        denseRow.addRow(toReduceLeft, row);
-
-        MATHICGB_ASSERT(leftColCount == pivotCount);
-        for  (size_t pivot = 0; pivot < pivotCount; ++pivot) {
-          if (denseRow[pivot] != 0) {
-            auto entry = denseRow[pivot];
-            entry %= modulus;
-            if (entry == 0) {
-              denseRow[pivot] = 0;
-            } else {
-              entry = modulus - entry;
-              const auto row = rowThatReducesCol[pivot];
-              MATHICGB_ASSERT(row < pivotCount);
-              MATHICGB_ASSERT(!reduceByLeft.emptyRow(row));
-              MATHICGB_ASSERT(reduceByLeft.leadCol(row) == pivot);
-              MATHICGB_ASSERT(entry < std::numeric_limits<SparseMatrix::Scalar>::max());
-              denseRow.addRowMultiple(
-                static_cast<SparseMatrix::Scalar>(entry),
-                ++reduceByLeft.rowBegin(row),
-                reduceByLeft.rowEnd(row)
-              );
-              denseRow[pivot] = entry;
-            }
+        left.clear(leftColCount);
+        left.addRow(toReduceLeft, row);
+        right.clear(rightColCount);
+        right.addRow(toReduceRight, row);
+        reduceByTopRows(left, right, qm, rowThatReducesCol, modulus);
+
+        auto& reduced = data.reduced;
+        bool zero = true;
+        for (SparseMatrix::ColIndex col = 0; col < rightColCount; ++col) {
+          const auto entry =
+            static_cast<SparseMatrix::Scalar>(right[col] % modulus);
+          if (entry != 0) {
+            reduced.appendEntry(col, entry);
+            zero = false;
           }
         }
-        mgb::mtbb::mutex::scoped_lock lockGuard(lock);
-        for (size_t pivot = 0; pivot < pivotCount; ++pivot) {
-		  MATHICGB_ASSERT(denseRow[pivot] < std::numeric_limits<SparseMatrix::Scalar>::max());
-          if (denseRow[pivot] != 0)
-            tmp.appendEntry(rowThatReducesCol[pivot], static_cast<SparseMatrix::Scalar>(denseRow[pivot]));
-	    }
-        tmp.rowDone();
-        rowOrder[tmp.rowCount() - 1] = row;
+        if (!zero)
+          reduced.rowDone();
+        else if (zeroRows != nullptr)
+          (*zeroRows)[row] = true;
       }
     });
 
-    mgb::mtbb::parallel_for(mgb::mtbb::blocked_range<SparseMatrix::RowIndex>(0, rowCount),
+    // Taking the rows moves the blocks of memory rather than copying them,
+    // so the rows stay where the workers put them.
+    SparseMatrix reduced(quantum);
+    for (auto& data : threadData)
+      reduced.takeRowsFrom(std::move(data.reduced));
+    return std::move(reduced);
+  }
+
+  /// As reduce, except that each bottom row is also reduced by the reduced
+  /// bottom rows above it, so that no row has an entry in the leading column
+  /// of a row above it. Rows are never reduced by rows below them. The
+  /// result has a row for each bottom row, in the same order, where a row
+  /// that reduces to zero is empty. The non-empty rows are unitary.
+  SparseMatrix reduceInRowOrder(
+    const QuadMatrix& qm,
+    const SparseMatrix::Scalar modulus
+  ) {
+    const auto& toReduceLeft = qm.bottomLeft;
+    const auto& toReduceRight = qm.bottomRight;
+
+    const auto leftColCount = qm.computeLeftColCount();
+    const auto rightColCount =
+      static_cast<SparseMatrix::ColIndex>(qm.computeRightColCount());
+    const auto rowCount = toReduceLeft.rowCount();
+    const auto rowThatReducesCol = topRowOfLeftColumn(qm);
+
+    // Reducing by the top rows is done in parallel as in reduce. Each worker
+    // records which bottom rows it reduced, so that the rows can be put back
+    // in order afterwards.
+    struct ThreadData {
+      DenseRow left;
+      DenseRow right;
+      SparseMatrix reduced;
+      std::vector<SparseMatrix::RowIndex> rows;
+    };
+    const auto quantum = qm.topRight.memoryQuantum();
+    mgb::mtbb::enumerable_thread_specific<ThreadData> threadData([&](){
+      ThreadData data = {
+        DenseRow(),
+        DenseRow(),
+        SparseMatrix(quantum),
+        std::vector<SparseMatrix::RowIndex>()
+      };
+      return data;
+    });
+
+    mgb::mtbb::parallel_for(
+      mgb::mtbb::blocked_range<SparseMatrix::RowIndex>(0, rowCount, 2),
       [&](const mgb::mtbb::blocked_range<SparseMatrix::RowIndex>& range)
-      {for (auto iter = range.begin(); iter != range.end(); ++iter)
     {
-      const auto i = iter;
-      const auto row = rowOrder[i];
-      auto& denseRow = denseRowPerThread.local();
-
-      denseRow.clear(rightColCount);
-      denseRow.addRow(toReduceRight, row);
-      auto it = tmp.rowBegin(i);
-      const auto end = tmp.rowEnd(i);
-      for (; it != end; ++it) {
-        const auto begin = reduceByRight.rowBegin(it.index());
-        const auto end = reduceByRight.rowEnd(it.index());
-        denseRow.addRowMultiple(it.scalar(), begin, end);
+      auto& data = threadData.local();
+      for (auto row = range.begin(); row != range.end(); ++row) {
+        data.left.clear(leftColCount);
+        data.left.addRow(toReduceLeft, row);
+        data.right.clear(rightColCount);
+        data.right.addRow(toReduceRight, row);
+        reduceByTopRows(data.left, data.right, qm, rowThatReducesCol, modulus);
+        data.right.appendUnitaryTo(data.reduced, modulus);
+        data.rows.push_back(row);
       }
+    });
 
-      mgb::mtbb::mutex::scoped_lock lockGuard(lock);
-      bool zero = true;
-	  for (SparseMatrix::ColIndex col = 0; col < rightColCount; ++col) {
-        const auto entry =
-          static_cast<SparseMatrix::Scalar>(denseRow[col] % modulus);
-        if (entry != 0) {
-          reduced.appendEntry(col, entry);
-          zero = false;
+    std::vector<std::pair<const SparseMatrix*, SparseMatrix::RowIndex>>
+      topReduced(rowCount);
+    for (auto& data : threadData) {
+      MATHICGB_ASSERT(data.rows.size() == data.reduced.rowCount());
+      for (SparseMatrix::RowIndex i = 0; i < data.reduced.rowCount(); ++i)
+        topReduced[data.rows[i]] = std::make_pair(&data.reduced, i);
+    }
+
+    // A row can only be reduced once the rows above it are done, so this
+    // part is serial.
+    SparseMatrix reduced(quantum);
+    std::vector<SparseMatrix::RowIndex> rowThatReducesRightCol
+      (rightColCount, rowCount);
+    DenseRow right;
+    for (SparseMatrix::RowIndex row = 0; row < rowCount; ++row) {
+      right.clear(rightColCount);
+      right.addRow(*topReduced[row].first, topReduced[row].second);
+      for (SparseMatrix::ColIndex col = 0; col < rightColCount; ++col) {
+        const auto reducer = rowThatReducesRightCol[col];
+        if (right[col] != 0 && reducer != rowCount)
+          right.rowReduceByUnitary(reducer, reduced, modulus);
+      }
+      right.appendUnitaryTo(reduced, modulus);
+      if (!reduced.emptyRow(row))
+        rowThatReducesRightCol[reduced.leadCol(row)] = row;
+    }
+    return std::move(reduced);
+  }
+
+  /// Returns rows that span the same space as the rows that reduce(qm,
+  /// modulus) returns, with high probability. The rows are in row echelon
+  /// form with leading entries of 1, but they are not in reduced row echelon
+  /// form. Returns false and leaves rows alone if the result turned out to
+  /// be wrong, in which case the matrix has to be reduced the usual way.
+  ///
+  /// The bottom rows are split into blocks of about the square root of the
+  /// number of rows. A random linear combination of the rows of each block
+  /// is reduced by the top rows and then by the rows found so far. If it
+  /// reduces to zero, then the rows of the block very likely also do, so
+  /// the block is done. Otherwise the result is a new row and the block gets
+  /// another combination, until the block has had as many combinations
+  /// reduce to non-zero as it has rows. So when most rows reduce to zero,
+  /// only about the square root of the number of rows are reduced by the top
+  /// rows. Reducing by the top rows is done in parallel for the blocks,
+  /// while reducing by the rows found so far is not. A combination reduces
+  /// to zero by accident with probability at most 1/modulus.
+  ///
+  /// At the end, random linear combinations of all the bottom rows are
+  /// reduced to check the result. Each of them reduces to zero by accident
+  /// with probability at most 1/modulus, so there are as many of them as it
+  /// takes to get a wrong result past the check with probability at most
+  /// 2^-40. That is 3 checks for 32003 and 7 for 67, the smallest prime
+  /// that is not below MinProbabilisticModulus.
+  bool reduceProbabilistic(
+    const QuadMatrix& qm,
+    const SparseMatrix::Scalar modulus,
+    SparseMatrix& rows
+  ) {
+    const SparseMatrix& toReduceLeft = qm.bottomLeft;
+    const SparseMatrix& toReduceRight = qm.bottomRight;
+
+    const auto leftColCount = qm.computeLeftColCount();
+    const auto rightColCount =
+      static_cast<SparseMatrix::ColIndex>(qm.computeRightColCount());
+    const auto rowCount = toReduceLeft.rowCount();
+    const auto rowThatReducesCol = topRowOfLeftColumn(qm);
+
+    // A fixed seed makes the computation repeatable. The probabilities above
+    // are over the choice of coefficients, which does not depend on the
+    // matrix, so a fixed seed is as good as any other. The bounds need the
+    // coefficients to be uniform over all of [0, modulus), zero included.
+    std::mt19937 random(0x4f1bbcdc);
+    std::uniform_int_distribution<SparseMatrix::Scalar>
+      randomCoefficient(0, modulus - 1);
+
+    // Sets left and right to a random linear combination of the bottom rows
+    // in [begin, end) reduced by the top rows.
+    auto reducedCombination = [&](
+      const SparseMatrix::RowIndex begin,
+      const SparseMatrix::RowIndex end,
+      const std::vector<SparseMatrix::Scalar>& coefficients,
+      DenseRow& left,
+      DenseRow& right
+    ) {
+      MATHICGB_ASSERT(coefficients.size() == end - begin);
+      left.clear(leftColCount);
+      right.clear(rightColCount);
+      for (auto row = begin; row < end; ++row) {
+        const auto coefficient = coefficients[row - begin];
+        left.addRowMultiple
+          (coefficient, toReduceLeft.rowBegin(row), toReduceLeft.rowEnd(row));
+        right.addRowMultiple
+          (coefficient, toReduceRight.rowBegin(row), toReduceRight.rowEnd(row));
+      }
+      reduceByTopRows(left, right, qm, rowThatReducesCol, modulus);
+    };
+
+    // Reduces right by the rows found so far. If the result is not zero,
+    // it is made unitary and appended to found, and true is returned.
+    const SparseMatrix::RowIndex noRow =
+      std::numeric_limits<SparseMatrix::RowIndex>::max();
+    std::vector<SparseMatrix::RowIndex> foundRowOfCol(rightColCount, noRow);
+    SparseMatrix found(qm.topRight.memoryQuantum());
+    auto reduceByFound = [&](DenseRow& right) {
+      for (SparseMatrix::ColIndex col = 0; col < rightColCount; ++col) {
+        if (right[col] == 0)
+          continue;
+        const auto foundRow = foundRowOfCol[col];
+        if (foundRow != noRow) {
+          right.rowReduceByUnitary(foundRow, found, modulus);
+          continue;
         }
+        right[col] %= modulus;
+        if (right[col] == 0)
+          continue;
+        right.makeUnitary(modulus, col);
+        foundRowOfCol[col] = found.rowCount();
+        right.appendTo(found);
+        return true;
       }
-      if (!zero)
-        reduced.rowDone();
-    }});
+      return false;
+    };
+
+    struct Block {
+      SparseMatrix::RowIndex begin;
+      SparseMatrix::RowIndex end;
+      SparseMatrix::RowIndex nonZeroCount;
+      std::vector<SparseMatrix::Scalar> coefficients;
+      SparseMatrix reduced;
+    };
+    std::vector<Block> blocks;
+    const auto blockSize = std::max<SparseMatrix::RowIndex>(1,
+      static_cast<SparseMatrix::RowIndex>(std::ceil(std::sqrt(rowCount))));
+    for (SparseMatrix::RowIndex begin = 0; begin < rowCount;) {
+      const auto end = std::min(rowCount, begin + blockSize);
+      Block block = {begin, end, 0, {}, SparseMatrix()};
+      blocks.push_back(std::move(block));
+      begin = end;
+    }
+
+    struct ThreadData {
+      DenseRow left;
+      DenseRow right;
+    };
+    mgb::mtbb::enumerable_thread_specific<ThreadData> threadData([&](){
+      return ThreadData();
+    });
+    DenseRow right;
+    std::vector<size_t> active(blocks.size());
+    for (size_t i = 0; i < active.size(); ++i)
+      active[i] = i;
+    size_t combinationCount = 0;
+    while (!active.empty()) {
+      combinationCount += active.size();
+      for (const auto i : active) {
+        auto& block = blocks[i];
+        block.coefficients.clear();
+        for (auto row = block.begin; row < block.end; ++row)
+          block.coefficients.push_back(randomCoefficient(random));
+      }
+
+      const mgb::mtbb::blocked_range<size_t> activeRange(0, active.size());
+      mgb::mtbb::parallel_for(activeRange,
+        [&](const mgb::mtbb::blocked_range<size_t>& range)
+      {
+        auto& data = threadData.local();
+        for (auto it = range.begin(); it != range.end(); ++it) {
+          auto& block = blocks[active[it]];
+          reducedCombination(
+            block.begin,
+            block.end,
+            block.coefficients,
+            data.left,
+            data.right
+          );
+          data.right.takeModulus(modulus);
+          block.reduced.clear();
+          data.right.appendTo(block.reduced);
+        }
+      });
+
+      std::vector<size_t> stillActive;
+      for (const auto i : active) {
+        auto& block = blocks[i];
+        right.clear(rightColCount);
+        right.addRow(block.reduced, 0);
+        block.reduced.clear();
+        if (!reduceByFound(right))
+          continue;
+        ++block.nonZeroCount;
+        if (block.nonZeroCount < block.end - block.begin)
+          stillActive.push_back(i);
+      }
+      active.swap(stillActive);
+    }
+
+    // Check the result with combinations of all the rows until the chance
+    // of missing a row is at most 1/modulus^checkCount <= 2^-40.
+    size_t checkCount = 0;
+    for (uint64 missBound = 1; missBound < (uint64(1) << 40); ++checkCount)
+      missBound *= modulus;
+    std::vector<SparseMatrix::Scalar> coefficients(rowCount);
+    DenseRow left;
+    bool correct = true;
+    for (size_t check = 0; correct && check < checkCount; ++check) {
+      for (auto& coefficient : coefficients)
+        coefficient = randomCoefficient(random);
+      reducedCombination(0, rowCount, coefficients, left, right);
+      correct = !reduceByFound(right);
+    }
+
+    MATHICGB_LOG(F4ProbabilisticRank) << "Found " << found.rowCount() <<
+      " new pivots among " << rowCount << " bottom rows by reducing " <<
+      combinationCount << " combinations of rows and " << checkCount <<
+      " checks." << (correct ? "" : " A check failed.") << std::endl;
+    if (!correct)
+      return false;
+    rows = std::move(found);
+    return true;
+  }
+
+  /// A temporary file that rows of sparse matrices are written to and then
+  /// read back in the same order. The file comes from std::tmpfile, so it is
+  /// removed when it is closed or when the program ends normally. On POSIX
+  /// systems the file has no name, so it is gone even if the process is
+  /// killed.
+  class ScratchRows : public NonCopyable<ScratchRows> {
+  public:
+    ScratchRows(): mFile(std::tmpfile()) {
+      if (mFile == nullptr)
+        mathic::reportError("could not create a scratch file for "
+          "out-of-core matrix reduction.");
+    }
+
+    ~ScratchRows() {std::fclose(mFile);}
+
+    /// Appends row of matrix to the file.
+    void write(const SparseMatrix& matrix, const SparseMatrix::RowIndex row) {
+      const auto count = matrix.entryCountInRow(row);
+      mIndices.clear();
+      mScalars.clear();
+      const auto end = matrix.rowEnd(row);
+      for (auto it = matrix.rowBegin(row); it != end; ++it) {
+        mIndices.push_back(it.index());
+        mScalars.push_back(it.scalar());
+      }
+      writeMany(&count, 1);
+      writeMany(mIndices.data(), count);
+      writeMany(mScalars.data(), count);
+    }
+
+    /// Goes back to reading from the first row.
+    void rewind() {std::rewind(mFile);}
+
+    /// Reads the next row and appends it to matrix. Returns the number of
+    /// bytes that the entries of the row take up.
+    size_t read(SparseMatrix& matrix) {
+      SparseMatrix::ColIndex count;
+      readMany(&count, 1);
+      mIndices.resize(count);
+      mScalars.resize(count);
+      readMany(mIndices.data(), count);
+      readMany(mScalars.data(), count);
+      for (SparseMatrix::ColIndex i = 0; i < count; ++i)
+        matrix.appendEntry(mIndices[i], mScalars[i]);
+      matrix.rowDone();
+      const auto entryBytes =
+        sizeof(SparseMatrix::ColIndex) + sizeof(SparseMatrix::Scalar);
+      return count * entryBytes;
+    }
+
+  private:
+    template<class T>
+    void writeMany(const T* t, const size_t count) {
+      if (count > 0 && std::fwrite(t, sizeof(T), count, mFile) != count)
+        mathic::reportError("error while writing to scratch file.");
+    }
+
+    template<class T>
+    void readMany(T* t, const size_t count) {
+      if (count > 0 && std::fread(t, sizeof(T), count, mFile) != count)
+        mathic::reportError("error while reading scratch file.");
+    }
+
+    FILE* const mFile;
+    std::vector<SparseMatrix::ColIndex> mIndices;
+    std::vector<SparseMatrix::Scalar> mScalars;
+  };
+
+  /// Computes the same thing as reduce() with about windowBytes of memory
+  /// besides the output. The four matrices of qm are written to scratch
+  /// files and cleared. Then the bottom rows are read back a block at a
+  /// time, and for each block the top rows are read back in order of their
+  /// pivot column a chunk at a time. Each pivot row only has entries to the
+  /// right of its pivot, so applying the top rows in that order reduces the
+  /// left part of the bottom rows to zero. The right part of a top row is
+  /// added to the right part of a bottom row with the same multiple as the
+  /// left part, so there is no need to keep the multiples around.
+  SparseMatrix reduceOutOfCore(
+    QuadMatrix& qm,
+    const SparseMatrix::Scalar modulus,
+    const size_t windowBytes
+  ) {
+    const auto leftColCount = qm.computeLeftColCount();
+    const auto rightColCount = qm.computeRightColCount();
+    MATHICGB_ASSERT(leftColCount == qm.topLeft.rowCount());
+    const auto pivotCount = leftColCount;
+    const auto rowCount = qm.bottomLeft.rowCount();
+
+    ScratchRows top;
+    {
+      std::vector<SparseMatrix::RowIndex> rowThatReducesCol(pivotCount);
+      for (SparseMatrix::RowIndex row = 0; row < pivotCount; ++row) {
+        MATHICGB_ASSERT(!qm.topLeft.emptyRow(row));
+        rowThatReducesCol[qm.topLeft.leadCol(row)] = row;
+      }
+      for (SparseMatrix::ColIndex pivot = 0; pivot < pivotCount; ++pivot) {
+        top.write(qm.topLeft, rowThatReducesCol[pivot]);
+        top.write(qm.topRight, rowThatReducesCol[pivot]);
+      }
+    }
+    ScratchRows bottom;
+    for (SparseMatrix::RowIndex row = 0; row < rowCount; ++row) {
+      bottom.write(qm.bottomLeft, row);
+      bottom.write(qm.bottomRight, row);
+    }
+    const auto memoryQuantum = qm.topRight.memoryQuantum();
+    qm.topLeft.clear();
+    qm.topRight.clear();
+    qm.bottomLeft.clear();
+    qm.bottomRight.clear();
+
+    // Half of the window is for the dense bottom rows of a block and the
+    // other half is for the chunk of top rows.
+    const size_t denseRowBytes = std::max<size_t>(1,
+      sizeof(DenseRow::ScalarProductSum) * (leftColCount + rightColCount));
+    const auto blockRowCount =
+      std::max<size_t>(1, windowBytes / 2 / denseRowBytes);
+    const auto chunkBytes = std::max<size_t>(1, windowBytes / 2);
+
+    SparseMatrix reduced(memoryQuantum);
+    std::vector<DenseRow> left;
+    std::vector<DenseRow> right;
+    SparseMatrix chunkLeft;
+    SparseMatrix chunkRight;
+    bottom.rewind();
+    for (size_t blockBegin = 0; blockBegin < rowCount;) {
+      const auto blockSize =
+        std::min<size_t>(blockRowCount, rowCount - blockBegin);
+      left.resize(blockSize);
+      right.resize(blockSize);
+      {
+        SparseMatrix blockLeft;
+        SparseMatrix blockRight;
+        for (size_t i = 0; i < blockSize; ++i) {
+          bottom.read(blockLeft);
+          bottom.read(blockRight);
+          const auto row = static_cast<SparseMatrix::RowIndex>(i);
+          left[i].clear(leftColCount);
+          left[i].addRow(blockLeft, row);
+          right[i].clear(rightColCount);
+          right[i].addRow(blockRight, row);
+        }
+      }
+
+      top.rewind();
+      for (SparseMatrix::ColIndex chunkBegin = 0; chunkBegin < pivotCount;) {
+        chunkLeft.clear();
+        chunkRight.clear();
+        auto chunkEnd = chunkBegin;
+        size_t bytesRead = 0;
+        do {
+          bytesRead += top.read(chunkLeft);
+          bytesRead += top.read(chunkRight);
+          ++chunkEnd;
+        } while (chunkEnd < pivotCount && bytesRead < chunkBytes);
+
+        mgb::mtbb::parallel_for(
+          mgb::mtbb::blocked_range<size_t>(0, blockSize),
+          [&](const mgb::mtbb::blocked_range<size_t>& range) {
+            for (auto i = range.begin(); i != range.end(); ++i) {
+              for (auto pivot = chunkBegin; pivot < chunkEnd; ++pivot) {
+                auto& entry = left[i][pivot];
+                if (entry == 0)
+                  continue;
+                entry %= modulus;
+                if (entry == 0)
+                  continue;
+                const auto multiple =
+                  static_cast<SparseMatrix::Scalar>(modulus - entry);
+                entry = 0;
+                const auto row = pivot - chunkBegin;
+                left[i].addRowMultiple
+                  (multiple, ++chunkLeft.rowBegin(row), chunkLeft.rowEnd(row));
+                right[i].addRowMultiple
+                  (multiple, chunkRight.rowBegin(row), chunkRight.rowEnd(row));
+              }
+            }
+          }
+        );
+        chunkBegin = chunkEnd;
+      }
+
+      for (size_t i = 0; i < blockSize; ++i) {
+        bool zero = true;
+        for (SparseMatrix::ColIndex col = 0; col < rightColCount; ++col) {
+          const auto entry =
+            static_cast<SparseMatrix::Scalar>(right[i][col] % modulus);
+          if (entry != 0) {
+            reduced.appendEntry(col, entry);
+            zero = false;
+          }
+        }
+        if (!zero)
+          reduced.rowDone();
+      }
+      blockBegin += blockSize;
+    }
     return std::move(reduced);
   }
 
@@ -726,7 +1240,10 @@ SparseMatrix reduceToEchelonFormShrawanDelayedModulus(
   return std::move(reduced);
 }
 
-SparseMatrix F4MatrixReducer::reduceToBottomRight(const QuadMatrix& matrix) {
+SparseMatrix F4MatrixReducer::reduceToBottomRight(
+  const QuadMatrix& matrix,
+  std::vector<char>* zeroRows
+) {
   MATHICGB_ASSERT(matrix.debugAssertValid());
   MATHICGB_LOG_TIME(F4MatReduceTop);
   MATHICGB_LOG_TIME(F4MatrixReduce) <<
@@ -734,7 +1251,34 @@ SparseMatrix F4MatrixReducer::reduceToBottomRight(const QuadMatrix& matrix) {
   MATHICGB_IF_STREAM_LOG(F4MatrixReduce)
     {matrix.printStatistics(log.stream());};
 
-  return reduce(matrix, mModulus);
+  return reduce(matrix, mModulus, zeroRows);
+}
+
+SparseMatrix F4MatrixReducer::reduceToBottomRightInRowOrder(
+  const QuadMatrix& matrix
+) {
+  MATHICGB_ASSERT(matrix.debugAssertValid());
+  MATHICGB_LOG_TIME(F4MatReduceTop);
+  MATHICGB_LOG_TIME(F4MatrixReduce) <<
+    "\n***** Reducing QuadMatrix to bottom right matrix in row order *****\n";
+  MATHICGB_IF_STREAM_LOG(F4MatrixReduce)
+    {matrix.printStatistics(log.stream());};
+
+  return reduceInRowOrder(matrix, mModulus);
+}
+
+SparseMatrix F4MatrixReducer::reduceToBottomRightOutOfCore(
+  QuadMatrix& matrix,
+  const size_t windowBytes
+) {
+  MATHICGB_ASSERT(matrix.debugAssertValid());
+  MATHICGB_LOG_TIME(F4MatReduceTop);
+  MATHICGB_LOG_TIME(F4MatrixReduce) <<
+    "\n***** Reducing QuadMatrix to bottom right matrix out of core *****\n";
+  MATHICGB_IF_STREAM_LOG(F4MatrixReduce)
+    {matrix.printStatistics(log.stream());};
+
+  return reduceOutOfCore(matrix, mModulus, windowBytes);
 }
 
 SparseMatrix F4MatrixReducer::reducedRowEchelonForm(
@@ -765,9 +1309,40 @@ SparseMatrix F4MatrixReducer::reducedRowEchelonForm(
 }
 
 SparseMatrix F4MatrixReducer::reducedRowEchelonFormBottomRight(
+  const QuadMatrix& matrix,
+  std::vector<char>* zeroRows
+) {
+  return reducedRowEchelonForm(reduceToBottomRight(matrix, zeroRows));
+}
+
+SparseMatrix F4MatrixReducer::reducedRowEchelonFormBottomRightProbabilistic(
   const QuadMatrix& matrix
 ) {
-  return reducedRowEchelonForm(reduceToBottomRight(matrix));
+  MATHICGB_ASSERT(matrix.debugAssertValid());
+  if (mModulus < MinProbabilisticModulus)
+    return reducedRowEchelonFormBottomRight(matrix);
+  SparseMatrix rows;
+  bool correct;
+  {
+    MATHICGB_LOG_TIME(F4MatReduceTop);
+    MATHICGB_LOG_TIME(F4MatrixReduce) << "\n***** Reducing QuadMatrix to "
+      "bottom right matrix probabilistically *****\n";
+    MATHICGB_IF_STREAM_LOG(F4MatrixReduce)
+      {matrix.printStatistics(log.stream());};
+
+    correct = reduceProbabilistic(matrix, mModulus, rows);
+  }
+  if (!correct)
+    return reducedRowEchelonFormBottomRight(matrix);
+  return reducedRowEchelonForm(rows);
+}
+
+SparseMatrix F4MatrixReducer::reducedRowEchelonFormBottomRightOutOfCore(
+  QuadMatrix& matrix,
+  const size_t windowBytes
+) {
+  return reducedRowEchelonForm
+    (reduceToBottomRightOutOfCore(matrix, windowBytes));
 }
 
 namespace {
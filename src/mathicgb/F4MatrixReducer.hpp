@@ -4,6 +4,7 @@
 #define MATHICGB_F4_MATRIX_REDUCER_GUARD
 
 #include "SparseMatrix.hpp"
+#include <vector>
 
 MATHICGB_NAMESPACE_BEGIN
 
@@ -22,18 +23,75 @@ public:
   /// The ring used is Z/pZ where modulus is the prime p.
   F4MatrixReducer(coefficient modulus);
 
+  /// The smallest modulus for which
+  /// reducedRowEchelonFormBottomRightProbabilistic reduces probabilistically.
+  static const SparseMatrix::Scalar MinProbabilisticModulus = 64;
+
   /// Reduces the bottom rows by the top rows and returns the bottom right
   /// submatrix of the resulting quad matrix. The lower left submatrix
-  /// is not returned because it is always zero after row reduction.
-  SparseMatrix reduceToBottomRight(const QuadMatrix& matrix);
+  /// is not returned because it is always zero after row reduction. If
+  /// zeroRows is not null, then (*zeroRows)[row] is set to whether bottom
+  /// row row reduced to zero.
+  SparseMatrix reduceToBottomRight(
+    const QuadMatrix& matrix,
+    std::vector<char>* zeroRows = nullptr
+  );
+
+  /// As reduceToBottomRight, except that each bottom row is also reduced by
+  /// the bottom rows above it, but never by the rows below it. Afterwards no
+  /// row has an entry in the leading column of a row above it. The returned
+  /// matrix has a row for each bottom row, in the same order, and a row that
+  /// reduces to zero is empty. The non-empty rows have leading entry 1. If
+  /// the bottom rows are in increasing order of signature, then this only
+  /// performs regular reduction steps between the bottom rows.
+  SparseMatrix reduceToBottomRightInRowOrder(const QuadMatrix& matrix);
 
   /// Returns the reduced row echelon form of matrix.
   SparseMatrix reducedRowEchelonForm(const SparseMatrix& matrix);
 
   /// Returns the lower right submatrix of the reduced row echelon
   /// form of matrix. The lower left part is not returned because it is
-  /// always zero after row reduction.
-  SparseMatrix reducedRowEchelonFormBottomRight(const QuadMatrix& matrix);
+  /// always zero after row reduction. zeroRows is as for
+  /// reduceToBottomRight, so it is about the reduction by the top rows.
+  SparseMatrix reducedRowEchelonFormBottomRight(
+    const QuadMatrix& matrix,
+    std::vector<char>* zeroRows = nullptr
+  );
+
+  /// Returns the same matrix as reducedRowEchelonFormBottomRight(matrix),
+  /// except that with a small probability some rows are missing. Random
+  /// linear combinations of the bottom rows are reduced instead of the rows
+  /// themselves, which is much faster when most of the bottom rows reduce
+  /// to zero. The result is checked with more combinations and the matrix
+  /// is reduced the usual way if a check fails. A wrong result gets past
+  /// the checks with probability at most 2^-40.
+  ///
+  /// For a modulus below MinProbabilisticModulus, too many combinations
+  /// reduce to zero by accident, so the matrix is reduced the usual way.
+  SparseMatrix reducedRowEchelonFormBottomRightProbabilistic(
+    const QuadMatrix& matrix
+  );
+
+  /// Returns the same matrix as reduceToBottomRight(matrix) using about
+  /// windowBytes of memory besides the returned matrix. The four
+  /// submatrices of matrix are moved to scratch files, which leaves them
+  /// empty. The bottom rows are then reduced a block at a time, and for
+  /// each block the top rows are read back a chunk at a time. This reads
+  /// the top rows once per block, so it is much slower than
+  /// reduceToBottomRight, but matrix no longer has to fit in memory while
+  /// it is being reduced. The scratch files are deleted automatically.
+  SparseMatrix reduceToBottomRightOutOfCore(
+    QuadMatrix& matrix,
+    size_t windowBytes
+  );
+
+  /// As reducedRowEchelonFormBottomRight, but uses
+  /// reduceToBottomRightOutOfCore. The bottom right submatrix is brought to
+  /// reduced row echelon form in memory.
+  SparseMatrix reducedRowEchelonFormBottomRightOutOfCore(
+    QuadMatrix& matrix,
+    size_t windowBytes
+  );
 
 private:
   const SparseMatrix::Scalar mModulus;
@@ -6,11 +6,17 @@
 #include "F4MatrixBuilder.hpp"
 #include "F4MatrixBuilder2.hpp"
 #include "F4MatrixReducer.hpp"
+#include "ClassicReducerCache.hpp"
+#include "ClassicGBTrace.hpp"
+#include "MemoryAccount.hpp"
 #include "QuadMatrix.hpp"
+#include "SigPolyBasis.hpp"
 #include "LogDomain.hpp"
 #include "CFile.hpp"
 #include <iostream>
 #include <limits>
+#include <deque>
+#include <algorithm>
 
 MATHICGB_DEFINE_LOG_DOMAIN(
   F4MatrixRows,
@@ -32,6 +38,12 @@ MATHICGB_DEFINE_LOG_DOMAIN(
   "Count number of non-zero entries in F4 matrices."
 );
 
+MATHICGB_DEFINE_LOG_DOMAIN(
+  F4OutOfCore,
+  "Displays the F4 matrices that are reduced out of core due to the "
+  "memory budget."
+);
+
 MATHICGB_DEFINE_LOG_ALIAS(
   "F4Detail",
   "F4MatrixEntries,F4MatrixBottomRows,F4MatrixTopRows,F4MatrixRows,"
@@ -69,6 +81,15 @@ public:
   /// is never called then no matrices are stored.
   void writeMatricesTo(std::string file, size_t minEntries);
 
+  /// Bring future matrices to reduced row echelon form with
+  /// F4MatrixReducer::reducedRowEchelonFormBottomRightProbabilistic if
+  /// probabilistic is true. Matrices that are reduced out of core and the
+  /// matrices of regularReduce and regularReduceAhead are always reduced
+  /// the usual way.
+  void setProbabilisticRank(bool probabilistic) {
+    mProbabilisticRank = probabilistic;
+  }
+
   virtual std::unique_ptr<Poly> classicReduce
     (const Poly& poly, const PolyBasis& basis);
 
@@ -90,6 +111,14 @@ public:
     std::vector<std::unique_ptr<Poly> >& reducedOut
   );
 
+  /// Puts all the basis elements into a single matrix, unless there are
+  /// only a few of them, in which case the fall-back reducer is used.
+  virtual void classicTailReduceBasis(
+    const PolyBasis& basis,
+    std::vector<std::unique_ptr<Poly>>& reducedOut
+  );
+
+  /// Uses the result of regularReduceAhead for sig if there is one.
   virtual std::unique_ptr<Poly> regularReduce(
     ConstMonoRef sig,
     ConstMonoRef multiple,
@@ -97,8 +126,25 @@ public:
     const SigPolyBasis& basis
   );
 
+  /// Reduces all of the polynomials in a single matrix whose bottom rows
+  /// are in order of signature.
+  virtual void regularReduceAhead(
+    const std::vector<ConstMonoPtr>& sigs,
+    const std::vector<ConstMonoPtr>& multiples,
+    const std::vector<size_t>& basisElements,
+    const SigPolyBasis& basis
+  );
+
   virtual void setMemoryQuantum(size_t quantum);
 
+  /// Only the new type of matrix builder supports plans.
+  virtual void setMatrixPlans(
+    F4MatrixPlan* record,
+    const F4MatrixPlan* replay
+  );
+
+  virtual void setMemoryAccount(MemoryAccount* account);
+
   virtual std::string description() const;
   virtual size_t getMemoryUse() const;
 
@@ -108,6 +154,26 @@ public:
 private:
   void saveMatrix(const QuadMatrix& matrix);
 
+  /// Forgets the cached reducers if the memory budget has been used up.
+  void checkMemoryBudget();
+
+  /// Returns the bottom right part of qm after reducing the bottom rows by
+  /// the top rows, brought to reduced row echelon form if echelonForm is
+  /// true. The reduction is done out of core if the memory budget does not
+  /// leave room for it in memory, which leaves the submatrices of qm empty.
+  /// Reports the memory used to the memory account. If zeroRows is not
+  /// null, then it is set to which bottom rows reduced to zero, or to empty
+  /// if the reduction used does not tell.
+  SparseMatrix reduceMatrix(
+    QuadMatrix& qm,
+    bool echelonForm,
+    std::vector<char>* zeroRows = nullptr
+  );
+
+  /// Returns the number of bytes of memory to use for reducing a matrix
+  /// that takes up matrixBytes, or 0 to reduce it in memory.
+  size_t outOfCoreWindow(size_t matrixBytes) const;
+
   Type mType;
   std::unique_ptr<Reducer> mFallback;
   const PolyRing& mRing;
@@ -115,6 +181,18 @@ private:
   std::string mStoreToFile; /// stem of file names to save matrices to
   size_t mMinEntryCountForStore; /// don't save matrices with fewer entries
   size_t mMatrixSaveCount; // how many matrices have been saved
+  bool mProbabilisticRank;
+  F4MatrixPlan* mRecordPlan;
+  const F4MatrixPlan* mReplayPlan;
+  MemoryAccount* mMemoryAccount;
+
+  /// The classic reducers of the columns of earlier matrices. Only the new
+  /// type of matrix builder uses this.
+  ClassicReducerCache mReducerCache;
+
+  /// The results of the calls to regularReduceAhead that regularReduce has
+  /// not used yet, in increasing order of signature.
+  std::deque<std::pair<Mono, std::unique_ptr<Poly>>> mRegularAhead;
 };
 
 F4Reducer::F4Reducer(const PolyRing& ring, Type type):
@@ -124,7 +202,12 @@ F4Reducer::F4Reducer(const PolyRing& ring, Type type):
   mMemoryQuantum(0),
   mStoreToFile(""),
   mMinEntryCountForStore(0),
-  mMatrixSaveCount(0) {
+  mMatrixSaveCount(0),
+  mProbabilisticRank(false),
+  mRecordPlan(nullptr),
+  mReplayPlan(nullptr),
+  mMemoryAccount(nullptr),
+  mReducerCache(ring) {
 }
 
 unsigned int F4Reducer::preferredSetSize() const {
@@ -188,6 +271,8 @@ void F4Reducer::classicReduceSPolySet(
 
   SparseMatrix reduced;
   QuadMatrix::Monomials monomials;
+  QuadMatrix::MonomialStorage monomialStorage;
+  checkMemoryBudget();
   {
     QuadMatrix qm(basis.ring());
     {
@@ -199,6 +284,8 @@ void F4Reducer::classicReduceSPolySet(
         builder.buildMatrixAndClear(qm);
       } else {
         F4MatrixBuilder2 builder(basis, mMemoryQuantum);
+        builder.setPlans(mRecordPlan, mReplayPlan);
+        builder.setReducerCache(&mReducerCache);
         for (const auto& spair : spairs)
           builder.addSPolynomialToMatrix
             (basis.poly(spair.first), basis.poly(spair.second));
@@ -210,11 +297,12 @@ void F4Reducer::classicReduceSPolySet(
     MATHICGB_LOG_INCREMENT_BY(F4MatrixBottomRows, qm.bottomLeft.rowCount());
     MATHICGB_LOG_INCREMENT_BY(F4MatrixEntries, qm.entryCount());
     saveMatrix(qm);
-    reduced = F4MatrixReducer(basis.ring().charac()).
-      reducedRowEchelonFormBottomRight(qm);
+    std::vector<char> zeroRows;
+    reduced = reduceMatrix(qm, true, &zeroRows);
+    if (mRecordPlan != nullptr)
+      mRecordPlan->keepZeroRows(zeroRows);
     monomials = std::move(qm.rightColumnMonomials);
-    for (auto& mono : qm.leftColumnMonomials)
-      monoid().freeRaw(mono.castAwayConst());
+    monomialStorage = std::move(qm.monomialStorage);
   }
 
   for (SparseMatrix::RowIndex row = 0; row < reduced.rowCount(); ++row) {
@@ -222,8 +310,6 @@ void F4Reducer::classicReduceSPolySet(
     reduced.rowToPolynomial(row, monomials, *p);
     reducedOut.push_back(std::move(p));
   }
-  for (auto& mono : monomials)
-    monoid().freeRaw(mono.castAwayConst());
 }
 
 void F4Reducer::classicReducePolySet(
@@ -247,6 +333,8 @@ void F4Reducer::classicReducePolySet(
 
   SparseMatrix reduced;
   QuadMatrix::Monomials monomials;
+  QuadMatrix::MonomialStorage monomialStorage;
+  checkMemoryBudget();
   {
     QuadMatrix qm(ring());
     {
@@ -257,6 +345,7 @@ void F4Reducer::classicReducePolySet(
         builder.buildMatrixAndClear(qm);
       } else {
         F4MatrixBuilder2 builder(basis, mMemoryQuantum);
+        builder.setReducerCache(&mReducerCache);
         for (const auto& poly : polys)
           builder.addPolynomialToMatrix(*poly);
         builder.buildMatrixAndClear(qm);
@@ -267,11 +356,9 @@ void F4Reducer::classicReducePolySet(
     MATHICGB_LOG_INCREMENT_BY(F4MatrixBottomRows, qm.bottomLeft.rowCount());
     MATHICGB_LOG_INCREMENT_BY(F4MatrixEntries, qm.entryCount());
     saveMatrix(qm);
-    reduced = F4MatrixReducer(basis.ring().charac()).
-      reducedRowEchelonFormBottomRight(qm);
+    reduced = reduceMatrix(qm, true);
     monomials = std::move(qm.rightColumnMonomials);
-    for (auto& mono : qm.leftColumnMonomials)
-      monoid().freeRaw(mono.castAwayConst());
+    monomialStorage = std::move(qm.monomialStorage);
   }
 
   if (tracingLevel >= 2 && false)
@@ -283,8 +370,74 @@ void F4Reducer::classicReducePolySet(
     reduced.rowToPolynomial(row, monomials, *p);
     reducedOut.push_back(std::move(p));
   }
-  for (auto& mono : monomials)
-    monoid().freeRaw(mono.castAwayConst());
+}
+
+void F4Reducer::classicTailReduceBasis(
+  const PolyBasis& basis,
+  std::vector<std::unique_ptr<Poly>>& reducedOut
+) {
+  // A matrix is not worth the overhead for a handful of polynomials.
+  const size_t minMatrixElementCount = 16;
+  size_t elementCount = 0;
+  for (size_t i = 0; i < basis.size(); ++i)
+    if (!basis.retired(i))
+      ++elementCount;
+  if (elementCount < minMatrixElementCount) {
+    if (tracingLevel >= 2)
+      std::cerr << "F4Reducer: Using fall-back reducer for tail reducing "
+        << elementCount << " basis elements.\n";
+    mFallback->classicTailReduceBasis(basis, reducedOut);
+    return;
+  }
+
+  if (tracingLevel >= 2)
+    std::cerr << "F4Reducer: Tail reducing " << elementCount
+      << " basis elements.\n";
+
+  // Each basis element is a bottom row whose lead column has no reducer,
+  // so the reduced row echelon form has one row for each basis element,
+  // with the same lead monomial and a fully reduced tail.
+  SparseMatrix reduced;
+  QuadMatrix::Monomials monomials;
+  QuadMatrix::MonomialStorage monomialStorage;
+  checkMemoryBudget();
+  {
+    QuadMatrix qm(ring());
+    {
+      F4MatrixBuilder2 builder(basis, mMemoryQuantum);
+      builder.setReducerCache(&mReducerCache);
+      for (size_t i = 0; i < basis.size(); ++i) {
+        if (!basis.retired(i)) {
+          MATHICGB_ASSERT(basis.leadMinimal(i));
+          builder.addBasisElementToInterreduce(basis.poly(i));
+        }
+      }
+      builder.buildMatrixAndClear(qm);
+    }
+    MATHICGB_LOG_INCREMENT_BY(F4MatrixRows, qm.rowCount());
+    MATHICGB_LOG_INCREMENT_BY(F4MatrixTopRows, qm.topLeft.rowCount());
+    MATHICGB_LOG_INCREMENT_BY(F4MatrixBottomRows, qm.bottomLeft.rowCount());
+    MATHICGB_LOG_INCREMENT_BY(F4MatrixEntries, qm.entryCount());
+    saveMatrix(qm);
+    reduced = reduceMatrix(qm, true);
+    monomials = std::move(qm.rightColumnMonomials);
+    monomialStorage = std::move(qm.monomialStorage);
+  }
+
+  reducedOut.clear();
+  reducedOut.resize(basis.size());
+  MATHICGB_ASSERT(reduced.rowCount() == elementCount);
+  for (SparseMatrix::RowIndex row = 0; row < reduced.rowCount(); ++row) {
+    auto p = make_unique<Poly>(ring());
+    reduced.rowToPolynomial(row, monomials, *p);
+    MATHICGB_ASSERT(!p->isZero());
+    p->makeMonic();
+    const auto index = basis.divisor(p->leadMono());
+    MATHICGB_ASSERT(index != static_cast<size_t>(-1));
+    MATHICGB_ASSERT(monoid().equal(basis.leadMono(index), p->leadMono()));
+    MATHICGB_ASSERT(reducedOut[index] == nullptr);
+    reducedOut[index] = std::move(p);
+  }
 }
 
 std::unique_ptr<Poly> F4Reducer::regularReduce(
@@ -293,23 +446,235 @@ std::unique_ptr<Poly> F4Reducer::regularReduce(
   size_t basisElement,
   const SigPolyBasis& basis
 ) {
+  // The matrix has multiple * basisElement as its single bottom row, and
+  // its top rows are the regular reducers in signature sig of the column
+  // monomials. So all top rows have signature less than sig and reducing
+  // the bottom row by the top rows is a regular reduction. Anything left
+  // over on the right cannot be regular reduced.
+  {
+    auto product = monoid().alloc();
+    monoid().multiply(multiple, basis.leadMono(basisElement), *product);
+    if (basis.regularReducer(sig, *product) == static_cast<size_t>(-1))
+      return nullptr; // singular reduction: no regular top reduction possible
+  }
+
+  // A result of regularReduceAhead is multiple * basisElement minus
+  // multiples of polynomials of smaller signature, though it may have been
+  // computed from another basis element of signature sig and with fewer
+  // basis elements. So that result is reduced instead. The basis is a
+  // signature Groebner basis below sig, so the regular reduced polynomial
+  // in signature sig is unique up to a scalar and this gives the same
+  // result.
+  while (
+    !mRegularAhead.empty() &&
+    monoid().lessThan(*mRegularAhead.front().first, sig)
+  )
+    mRegularAhead.pop_front();
+  std::unique_ptr<Poly> ahead;
+  if (
+    !mRegularAhead.empty() &&
+    monoid().equal(*mRegularAhead.front().first, sig)
+  ) {
+    ahead = std::move(mRegularAhead.front().second);
+    mRegularAhead.pop_front();
+    if (ahead->isZero())
+      return ahead;
+  }
+
   if (tracingLevel >= 2)
-    std::cerr <<
-      "F4Reducer: Using fall-back reducer for single regular reduction\n";
-  auto p = mFallback->regularReduce(sig, multiple, basisElement, basis);
-  return p;
+    std::cerr << "F4Reducer: Regular reducing in signature matrix.\n";
+
+  SparseMatrix reduced;
+  QuadMatrix::Monomials monomials;
+  QuadMatrix::MonomialStorage monomialStorage;
+  checkMemoryBudget();
+  {
+    QuadMatrix qm(ring());
+    {
+      F4MatrixBuilder2 builder(basis, sig, mMemoryQuantum);
+      if (ahead == nullptr)
+        builder.addPolynomialToMatrix(multiple, basis.poly(basisElement));
+      else
+        builder.addPolynomialToMatrix(*ahead);
+      builder.buildMatrixAndClear(qm);
+    }
+    MATHICGB_LOG_INCREMENT_BY(F4MatrixRows, qm.rowCount());
+    MATHICGB_LOG_INCREMENT_BY(F4MatrixTopRows, qm.topLeft.rowCount());
+    MATHICGB_LOG_INCREMENT_BY(F4MatrixBottomRows, qm.bottomLeft.rowCount());
+    MATHICGB_LOG_INCREMENT_BY(F4MatrixEntries, qm.entryCount());
+    saveMatrix(qm);
+    reduced = reduceMatrix(qm, false);
+    monomials = std::move(qm.rightColumnMonomials);
+    monomialStorage = std::move(qm.monomialStorage);
+  }
+
+  MATHICGB_ASSERT(reduced.rowCount() <= 1);
+  auto result = make_unique<Poly>(ring());
+  if (reduced.rowCount() == 1) {
+    reduced.rowToPolynomial(0, monomials, *result);
+    result->makeMonic();
+  }
+  return result;
+}
+
+void F4Reducer::regularReduceAhead(
+  const std::vector<ConstMonoPtr>& sigs,
+  const std::vector<ConstMonoPtr>& multiples,
+  const std::vector<size_t>& basisElements,
+  const SigPolyBasis& basis
+) {
+  MATHICGB_ASSERT(sigs.size() == multiples.size());
+  MATHICGB_ASSERT(sigs.size() == basisElements.size());
+  if (sigs.size() <= 1)
+    return; // regularReduce does just as well on its own
+
+  if (tracingLevel >= 2)
+    std::cerr << "F4Reducer: Regular reducing " << sigs.size()
+              << " polynomials in signature matrix.\n";
+
+  // The bottom rows are the polynomials in increasing order of signature
+  // and the top rows are regular reducers in the smallest signature. So
+  // every top row has smaller signature than every bottom row, and a bottom
+  // row is only reduced by the bottom rows above it, which have smaller
+  // signature. A bottom row can still have terms that are regular reducible
+  // in its own signature, since a larger signature allows more reducers.
+  // regularReduce takes care of those.
+  SparseMatrix reduced;
+  QuadMatrix::Monomials monomials;
+  QuadMatrix::MonomialStorage monomialStorage;
+  checkMemoryBudget();
+  {
+    QuadMatrix qm(ring());
+    {
+      F4MatrixBuilder2 builder(basis, *sigs.front(), mMemoryQuantum);
+      for (size_t i = 0; i < sigs.size(); ++i) {
+        MATHICGB_ASSERT(i == 0 || monoid().lessThan(*sigs[i - 1], *sigs[i]));
+        builder.addPolynomialToMatrix
+          (*multiples[i], basis.poly(basisElements[i]));
+      }
+      builder.buildMatrixAndClear(qm);
+    }
+    MATHICGB_LOG_INCREMENT_BY(F4MatrixRows, qm.rowCount());
+    MATHICGB_LOG_INCREMENT_BY(F4MatrixTopRows, qm.topLeft.rowCount());
+    MATHICGB_LOG_INCREMENT_BY(F4MatrixBottomRows, qm.bottomLeft.rowCount());
+    MATHICGB_LOG_INCREMENT_BY(F4MatrixEntries, qm.entryCount());
+    saveMatrix(qm);
+    reduced = F4MatrixReducer(ring().charac()).
+      reduceToBottomRightInRowOrder(qm);
+    monomials = std::move(qm.rightColumnMonomials);
+    monomialStorage = std::move(qm.monomialStorage);
+  }
+
+  MATHICGB_ASSERT(reduced.rowCount() == sigs.size());
+  for (SparseMatrix::RowIndex row = 0; row < reduced.rowCount(); ++row) {
+    auto sig = monoid().alloc();
+    monoid().copy(*sigs[row], *sig);
+    auto p = make_unique<Poly>(ring());
+    reduced.rowToPolynomial(row, monomials, *p);
+    mRegularAhead.emplace_back(std::move(sig), std::move(p));
+  }
+
+  // The results of earlier calls that are not used yet can have larger
+  // signature than these.
+  const auto oldEnd = mRegularAhead.end() - reduced.rowCount();
+  std::inplace_merge(mRegularAhead.begin(), oldEnd, mRegularAhead.end(),
+    [&](
+      const std::pair<Mono, std::unique_ptr<Poly>>& a,
+      const std::pair<Mono, std::unique_ptr<Poly>>& b
+    ) {
+      return monoid().lessThan(*a.first, *b.first);
+    }
+  );
 }
 
 void F4Reducer::setMemoryQuantum(size_t quantum) {
   mMemoryQuantum = quantum;
 }
 
+void F4Reducer::setMatrixPlans(
+  F4MatrixPlan* record,
+  const F4MatrixPlan* replay
+) {
+  mRecordPlan = record;
+  mReplayPlan = replay;
+}
+
+void F4Reducer::setMemoryAccount(MemoryAccount* account) {
+  mMemoryAccount = account;
+}
+
 std::string F4Reducer::description() const {
   return "F4 reducer";
 }
 
 size_t F4Reducer::getMemoryUse() const {
-  return 0; // @todo: implement
+  return mReducerCache.getMemoryUse();
+}
+
+void F4Reducer::checkMemoryBudget() {
+  if (mMemoryAccount == nullptr || mMemoryAccount->budget() == 0)
+    return;
+  if (mMemoryAccount->totalUse() > mMemoryAccount->budget())
+    mReducerCache.clear();
+}
+
+size_t F4Reducer::outOfCoreWindow(const size_t matrixBytes) const {
+  if (mMemoryAccount == nullptr || mMemoryAccount->budget() == 0)
+    return 0;
+  const auto budget = mMemoryAccount->budget();
+  const auto used = mMemoryAccount->totalUse();
+  const auto available = budget > used ? budget - used : 0;
+
+  // Reducing in memory needs about as much memory again as the matrix for
+  // the intermediate rows and the result. A window that is too small makes
+  // the reduction read the top rows over and over, so the window can go
+  // over the budget.
+  if (2 * matrixBytes <= available)
+    return 0;
+  const size_t minWindow = 16 << 20;
+  return std::max(available, minWindow);
+}
+
+SparseMatrix F4Reducer::reduceMatrix(
+  QuadMatrix& qm,
+  const bool echelonForm,
+  std::vector<char>* zeroRows
+) {
+  F4MatrixReducer reducer(ring().charac());
+  const auto matrixBytes = mMemoryAccount == nullptr ? 0 : qm.memoryUse();
+  const auto window = outOfCoreWindow(matrixBytes);
+  if (zeroRows != nullptr)
+    zeroRows->clear();
+  SparseMatrix reduced;
+  if (window == 0) {
+    if (!echelonForm)
+      reduced = reducer.reduceToBottomRight(qm, zeroRows);
+    else if (mProbabilisticRank)
+      reduced = reducer.reducedRowEchelonFormBottomRightProbabilistic(qm);
+    else
+      reduced = reducer.reducedRowEchelonFormBottomRight(qm, zeroRows);
+  } else {
+    MATHICGB_LOG(F4OutOfCore) << "Reducing a matrix of " << matrixBytes <<
+      " bytes out of core with a window of " << window << " bytes." <<
+      std::endl;
+    reduced = echelonForm ?
+      reducer.reducedRowEchelonFormBottomRightOutOfCore(qm, window) :
+      reducer.reduceToBottomRightOutOfCore(qm, window);
+  }
+
+  if (mMemoryAccount != nullptr) {
+    mMemoryAccount->noteTransientUse
+      (MemoryAccount::F4MatrixBuildMemory, matrixBytes);
+    const auto reducedBytes = reduced.memoryUse();
+    if (window == 0) {
+      mMemoryAccount->noteTransientUse
+        (MemoryAccount::F4ReductionMemory, reducedBytes, matrixBytes);
+    } else {
+      mMemoryAccount->noteTransientUse
+        (MemoryAccount::F4ReductionMemory, reducedBytes + window);
+    }
+  }
+  return reduced;
 }
 
 void F4Reducer::saveMatrix(const QuadMatrix& matrix) {
@@ -333,12 +698,14 @@ std::unique_ptr<Reducer> makeF4Reducer(
  const PolyRing& ring,
  bool oldType,
  std::string file,
- size_t minEntries
+ size_t minEntries,
+ bool probabilisticRank
 ) {
   auto reducer = oldType ?
     make_unique<F4Reducer>(ring, F4Reducer::OldType) :
     make_unique<F4Reducer>(ring, F4Reducer::NewType);
   reducer->writeMatricesTo(file, minEntries);
+  reducer->setProbabilisticRank(probabilisticRank);
   return std::move(reducer);
 }
 
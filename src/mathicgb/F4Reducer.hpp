@@ -11,12 +11,16 @@ class Reducer;
 class PolyRing;
 
 /// Create an F4 reducer with extra parameters for writing out the matrix.
-/// Set file to "" to disable writing of matrices.
+/// Set file to "" to disable writing of matrices. If probabilisticRank is
+/// true, then the matrices are reduced with a probabilistic method that is
+/// faster when most rows reduce to zero, but that can miss new basis
+/// elements with a small probability.
 std::unique_ptr<Reducer> makeF4Reducer(
  const PolyRing& ring,
  bool oldType,
  std::string file,
- size_t minEntries
+ size_t minEntries,
+ bool probabilisticRank
 );
 
 // This translation unit has to expose something that is needed elsewhere.
@@ -0,0 +1,182 @@
+// MathicGB copyright 2012 all rights reserved. MathicGB comes with ABSOLUTELY
+// NO WARRANTY and is licensed as GPL v2.0 or later - see LICENSE.txt.
+#include "stdinc.h"
+#include "FrozenMonoLookup.hpp"
+
+#include "PolyBasis.hpp"
+#include <algorithm>
+#include <limits>
+
+MATHICGB_NAMESPACE_BEGIN
+
+FrozenMonoLookup::FrozenMonoLookup(const PolyBasis& basis):
+  mMonoid(basis.monoid()),
+  mPreferSparseReducers(basis.monoLookup().preferSparseReducers())
+{
+  const auto varCount = monoid().varCount();
+  std::vector<Monoid::Exponent> maxExponents(varCount);
+  for (size_t index = 0; index < basis.size(); ++index) {
+    if (basis.retired(index))
+      continue;
+    const auto lead = basis.leadMono(index);
+    for (size_t var = 0; var < varCount; ++var) {
+      maxExponents[var] =
+        std::max(maxExponents[var], monoid().exponent(lead, var));
+    }
+    Entry entry = {
+      0,
+      degree(lead),
+      lead.ptr(),
+      index,
+      basis.poly(index).termCount()
+    };
+    mEntries.push_back(entry);
+  }
+
+  // Spread the bits of the mask evenly over the variables and spread the
+  // thresholds of each variable evenly up to its largest exponent.
+  const size_t maskBits = std::numeric_limits<Mask>::digits;
+  const auto bitsPerVar =
+    varCount == 0 ? 0 : std::max<size_t>(1, maskBits / varCount);
+  for (size_t var = 0; var < varCount; ++var) {
+    const auto max = maxExponents[var];
+    for (size_t bit = 0; bit < bitsPerVar; ++bit) {
+      if (mMaskVars.size() == maskBits)
+        break;
+      const auto threshold =
+        static_cast<Monoid::Exponent>(1 + bit * max / bitsPerVar);
+      if (threshold > max)
+        break;
+      if (bit > 0 && mMaskThresholds.back() == threshold)
+        continue;
+      mMaskVars.push_back(var);
+      mMaskThresholds.push_back(threshold);
+    }
+  }
+
+  for (auto& entry : mEntries)
+    entry.mask = mask(*entry.mono);
+  const auto lessThan = [](const Entry& a, const Entry& b) {
+    return a.degree < b.degree || (a.degree == b.degree && a.index < b.index);
+  };
+  std::sort(mEntries.begin(), mEntries.end(), lessThan);
+}
+
+auto FrozenMonoLookup::mask(ConstMonoRef mono) const -> Mask {
+  Mask mask = 0;
+  for (size_t bit = 0; bit < mMaskVars.size(); ++bit)
+    if (monoid().exponent(mono, mMaskVars[bit]) >= mMaskThresholds[bit])
+      mask |= Mask(1) << bit;
+  return mask;
+}
+
+size_t FrozenMonoLookup::degree(ConstMonoRef mono) const {
+  size_t degree = 0;
+  for (size_t var = 0; var < monoid().varCount(); ++var)
+    degree += monoid().exponent(mono, var);
+  return degree;
+}
+
+bool FrozenMonoLookup::betterReducer(const Entry& a, const Entry& b) const {
+  if (mPreferSparseReducers && a.termCount != b.termCount)
+    return a.termCount < b.termCount;
+  return a.index < b.index; // prefer older
+}
+
+template<class F>
+void FrozenMonoLookup::forDivisors(ConstMonoRef mono, F&& f) const {
+  const auto monoMask = mask(mono);
+  const auto monoDegree = degree(mono);
+  for (const auto& entry : mEntries) {
+    if (entry.degree > monoDegree)
+      break;
+    if ((entry.mask & ~monoMask) != 0)
+      continue;
+    if (!monoid().dividesWithComponent(*entry.mono, mono))
+      continue;
+    if (!f(entry))
+      break;
+  }
+}
+
+size_t FrozenMonoLookup::divisor(ConstMonoRef mono) const {
+  auto divisor = static_cast<size_t>(-1);
+  forDivisors(mono, [&](const Entry& entry) {
+    divisor = entry.index;
+    return false;
+  });
+  return divisor;
+}
+
+size_t FrozenMonoLookup::classicReducer(ConstMonoRef mono) const {
+  const Entry* reducer = nullptr;
+  forDivisors(mono, [&](const Entry& entry) {
+    if (reducer == nullptr || betterReducer(entry, *reducer))
+      reducer = &entry;
+    return true;
+  });
+  return reducer == nullptr ? static_cast<size_t>(-1) : reducer->index;
+}
+
+void FrozenMonoLookup::classicReducers(
+  const ConstMonoPtr* monos,
+  const size_t count,
+  size_t* reducers
+) const {
+  std::vector<Mask> masks(count);
+  std::vector<size_t> degrees(count);
+  std::vector<const Entry*> best(count);
+  std::vector<size_t> candidates(count);
+  size_t maxDegree = 0;
+  for (size_t i = 0; i < count; ++i) {
+    masks[i] = mask(*monos[i]);
+    degrees[i] = degree(*monos[i]);
+    maxDegree = std::max(maxDegree, degrees[i]);
+  }
+
+  for (const auto& entry : mEntries) {
+    if (entry.degree > maxDegree)
+      break;
+    size_t candidateCount = 0;
+    for (size_t i = 0; i < count; ++i) {
+      candidates[candidateCount] = i;
+      candidateCount += (entry.mask & ~masks[i]) == 0;
+    }
+    for (size_t c = 0; c < candidateCount; ++c) {
+      const auto i = candidates[c];
+      if (entry.degree > degrees[i])
+        continue;
+      if (best[i] != nullptr && !betterReducer(entry, *best[i]))
+        continue;
+      if (monoid().dividesWithComponent(*entry.mono, *monos[i]))
+        best[i] = &entry;
+    }
+  }
+
+  for (size_t i = 0; i < count; ++i)
+    reducers[i] = best[i] == nullptr ? static_cast<size_t>(-1) : best[i]->index;
+}
+
+void FrozenMonoLookup::multiples(
+  ConstMonoRef mono,
+  EntryOutput& consumer
+) const {
+  const auto monoMask = mask(mono);
+  const auto monoDegree = degree(mono);
+  const auto begin = std::lower_bound(
+    mEntries.begin(),
+    mEntries.end(),
+    monoDegree,
+    [](const Entry& entry, size_t degree) {return entry.degree < degree;}
+  );
+  for (auto it = begin; it != mEntries.end(); ++it) {
+    if ((monoMask & ~it->mask) != 0)
+      continue;
+    if (!monoid().dividesWithComponent(mono, *it->mono))
+      continue;
+    if (!consumer.proceed(it->index))
+      break;
+  }
+}
+
+MATHICGB_NAMESPACE_END
@@ -0,0 +1,109 @@
+// MathicGB copyright 2012 all rights reserved. MathicGB comes with ABSOLUTELY
+// NO WARRANTY and is licensed as GPL v2.0 or later - see LICENSE.txt.
+#ifndef MATHICGB_FROZEN_MONO_LOOKUP_GUARD
+#define MATHICGB_FROZEN_MONO_LOOKUP_GUARD
+
+#include "MonoLookup.hpp"
+#include "NonCopyable.hpp"
+#include <vector>
+
+MATHICGB_NAMESPACE_BEGIN
+
+class PolyBasis;
+
+/// A snapshot of the lead monomials of the non-retired elements of a
+/// PolyBasis that supports the read-only queries of MonoLookup.
+///
+/// The data structures of MonoLookup update caches while they are being
+/// queried, so they cannot be queried from several threads at once. The
+/// queries here change nothing and cache nothing, so any number of threads
+/// can query a FrozenMonoLookup at the same time without locking.
+///
+/// The snapshot refers to the lead monomials of the basis, so it must not be
+/// used after the basis has changed. Building a snapshot takes time linear in
+/// the size of the basis.
+///
+/// The elements are stored by total degree, so a query only looks at the
+/// elements whose degree allows divisibility. Each element also has a
+/// bit mask where bit i is set if the exponent of some variable is at least
+/// a threshold for bit i. The element a can only divide b if the mask of a
+/// is a subset of the mask of b, which rules out most elements with a single
+/// instruction.
+class FrozenMonoLookup : public NonCopyable<FrozenMonoLookup> {
+public:
+  typedef PolyRing::Monoid Monoid;
+  typedef Monoid::ConstMonoRef ConstMonoRef;
+  typedef Monoid::ConstMonoPtr ConstMonoPtr;
+  typedef MonoLookup::EntryOutput EntryOutput;
+
+  /// Takes a snapshot of the lead monomials of basis. Reducers are chosen
+  /// in the same way as basis.monoLookup() chooses them.
+  FrozenMonoLookup(const PolyBasis& basis);
+
+  /// Returns the index of a basis element whose lead monomial divides mono,
+  /// or -1 if there is no such basis element.
+  size_t divisor(ConstMonoRef mono) const;
+
+  /// Returns the same index as basis.classicReducer(mono) for the basis
+  /// that the snapshot was taken of.
+  size_t classicReducer(ConstMonoRef mono) const;
+
+  /// Sets reducers[i] to classicReducer(*monos[i]) for each i < count.
+  ///
+  /// This goes through the snapshot once for the whole batch instead of
+  /// once per monomial. Each element of the snapshot is first tested against
+  /// the masks of all of the monomials in a branch-free loop that compilers
+  /// can vectorize, and only the monomials that pass that test are checked
+  /// for divisibility. That is much faster than separate queries when the
+  /// monomials are the terms of a row of an F4 matrix.
+  void classicReducers(
+    const ConstMonoPtr* monos,
+    size_t count,
+    size_t* reducers
+  ) const;
+
+  /// Calls consumer.proceed(index) for each basis element whose lead
+  /// monomial is divisible by mono. Stops if proceed returns false.
+  void multiples(ConstMonoRef mono, EntryOutput& consumer) const;
+
+  /// Returns the number of non-retired basis elements in the snapshot.
+  size_t size() const {return mEntries.size();}
+
+  const Monoid& monoid() const {return mMonoid;}
+
+private:
+  typedef unsigned long long Mask;
+
+  struct Entry {
+    Mask mask;
+    size_t degree;
+    ConstMonoPtr mono;
+    size_t index;
+    size_t termCount;
+  };
+
+  Mask mask(ConstMonoRef mono) const;
+  size_t degree(ConstMonoRef mono) const;
+
+  /// Returns true if a should be preferred to b as a reducer.
+  bool betterReducer(const Entry& a, const Entry& b) const;
+
+  /// Calls f(entry) for each entry whose lead monomial divides mono, until
+  /// f returns false.
+  template<class F>
+  void forDivisors(ConstMonoRef mono, F&& f) const;
+
+  const Monoid& mMonoid;
+  const bool mPreferSparseReducers;
+
+  /// The entries in ascending order of degree and then index.
+  std::vector<Entry> mEntries;
+
+  /// Bit i of a mask is set if the exponent of variable mMaskVars[i] is at
+  /// least mMaskThresholds[i].
+  std::vector<size_t> mMaskVars;
+  std::vector<Monoid::Exponent> mMaskThresholds;
+};
+
+MATHICGB_NAMESPACE_END
+#endif
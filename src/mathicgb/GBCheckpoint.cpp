@@ -0,0 +1,398 @@
+// MathicGB copyright 2012 all rights reserved. MathicGB comes with ABSOLUTELY
+// NO WARRANTY and is licensed as GPL v2.0 or later - see LICENSE.txt.
+#include "stdinc.h"
+#include "GBCheckpoint.hpp"
+
+#include "PolyBasis.hpp"
+#include "Basis.hpp"
+#include <mathic.h>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <sstream>
+
+MATHICGB_NAMESPACE_BEGIN
+
+namespace {
+  const char Magic[] = "MGBCKPT4"; // the last character is the version
+  const size_t MagicSize = sizeof(Magic) - 1;
+
+  // Record tags.
+  const unsigned char ElementTag = 'E';
+  const unsigned char RetireTag = 'R';
+  const unsigned char PairTag = 'P';
+  const unsigned char CommitTag = 'C';
+
+  // The number of calls to GBCheckpoint::request(). Each GBCheckpoint
+  // compares it to the count it saw last, so that a request reaches every
+  // computation that is running. This is lock-free, so request() can be
+  // called from a signal handler.
+  std::atomic<unsigned int> requestCount(0);
+
+  template<class T>
+  void writeOne(const T& t, FILE* file) {
+    if (fwrite(&t, sizeof(T), 1, file) != 1)
+      mathic::reportError("error while writing checkpoint file.");
+  }
+
+  /// Returns false if the end of the file has been reached.
+  template<class T>
+  bool readOne(FILE* file, T& t) {
+    return fread(&t, sizeof(T), 1, file) == 1;
+  }
+
+  /// Returns numbers that determine the monomial order of ring: the base
+  /// order, the position of the component, whether the variables are
+  /// reversed and then the gradings. A resumed computation has to use the
+  /// same order, since the lead terms and the S-pairs depend on it.
+  std::vector<int32> orderDescription(const PolyRing& ring) {
+    const auto& monoid = ring.monoid();
+    const auto order = monoid.makeOrder(false, false);
+    std::vector<int32> description;
+    description.push_back(static_cast<int32>(order.baseOrder()));
+    description.push_back(static_cast<int32>(order.componentBefore()));
+    description.push_back(monoid.varsReversed());
+    description.push_back(static_cast<int32>(order.gradingCount()));
+    for (const auto grading : order.gradings())
+      description.push_back(static_cast<int32>(grading));
+    return description;
+  }
+
+  /// Mixes value into hash in the manner of the FNV-1a hash function, only
+  /// a whole value at a time instead of a byte at a time.
+  void hashIn(uint64& hash, const uint64 value) {
+    hash = (hash ^ value) * 1099511628211ull;
+  }
+
+  void hashIn(uint64& hash, const Basis& basis) {
+    hashIn(hash, basis.size());
+    for (size_t i = 0; i < basis.size(); ++i) {
+      const auto& poly = *basis.getPoly(i);
+      const auto& monoid = poly.ring().monoid();
+      hashIn(hash, poly.termCount());
+      const auto end = poly.end();
+      for (auto it = poly.begin(); it != end; ++it) {
+        hashIn(hash, it.coef().value());
+        hashIn(hash, monoid.component(it.mono()));
+        for (size_t var = 0; var < monoid.varCount(); ++var)
+          hashIn(hash, monoid.externalExponent(it.mono(), var));
+      }
+    }
+  }
+
+  void reportCorrupt(const std::string& fileName) {
+    mathic::reportError
+      ("The checkpoint file " + fileName + " is corrupt.");
+  }
+
+  void writePoly(const Poly& poly, FILE* file) {
+    const auto& monoid = poly.ring().monoid();
+    writeOne(static_cast<uint64>(poly.termCount()), file);
+    const auto end = poly.end();
+    for (auto it = poly.begin(); it != end; ++it) {
+      writeOne(static_cast<uint32>(it.coef().value()), file);
+      writeOne(static_cast<uint32>(monoid.component(it.mono())), file);
+      for (size_t var = 0; var < monoid.varCount(); ++var) {
+        const auto e = monoid.externalExponent(it.mono(), var);
+        writeOne(static_cast<uint32>(e), file);
+      }
+    }
+  }
+
+  /// Returns null if the end of the file has been reached.
+  std::unique_ptr<Poly> readPoly(
+    const PolyRing& ring,
+    const std::string& fileName,
+    FILE* file
+  ) {
+    const auto& monoid = ring.monoid();
+    uint64 termCount;
+    if (!readOne(file, termCount))
+      return nullptr;
+    if (termCount == 0)
+      reportCorrupt(fileName);
+
+    auto poly = make_unique<Poly>(ring);
+    auto mono = monoid.alloc();
+    for (uint64 term = 0; term < termCount; ++term) {
+      uint32 coef;
+      uint32 component;
+      if (!readOne(file, coef) || !readOne(file, component))
+        return nullptr;
+      if (coef == 0 || coef >= ring.charac())
+        reportCorrupt(fileName);
+
+      monoid.setIdentity(*mono);
+      for (size_t var = 0; var < monoid.varCount(); ++var) {
+        uint32 e;
+        if (!readOne(file, e))
+          return nullptr;
+        monoid.setExternalExponent
+          (var, static_cast<PolyRing::Monoid::Exponent>(e), *mono);
+      }
+      monoid.setComponent(component, *mono);
+      poly->append(ring.field().toElementInRange(coef), *mono);
+    }
+    if (!poly->termsAreInDescendingOrder())
+      reportCorrupt(fileName);
+    return poly;
+  }
+}
+
+uint64 GBCheckpoint::inputHash(
+  const Basis& groebnerBasis,
+  const Basis& generators
+) {
+  uint64 hash = 14695981039346656037ull;
+  hashIn(hash, groebnerBasis);
+  hashIn(hash, generators);
+  return hash;
+}
+
+bool GBCheckpoint::read(
+  const std::string& fileName,
+  const PolyRing& ring,
+  const uint64 inputHash,
+  State& state
+) {
+  CFile cfile(fileName, "rb", CFile::NoThrowTag());
+  if (!cfile.hasFile())
+    return false;
+  FILE* file = cfile.handle();
+
+  char magic[MagicSize];
+  if (fread(magic, 1, MagicSize, file) != MagicSize)
+    return false;
+  if (std::memcmp(magic, Magic, MagicSize) != 0)
+    reportCorrupt(fileName);
+
+  uint32 charac;
+  uint32 varCount;
+  if (!readOne(file, charac) || !readOne(file, varCount))
+    return false;
+  if (charac != ring.charac() || varCount != ring.varCount()) {
+    std::ostringstream err;
+    err << "The checkpoint file " << fileName
+      << " is for a computation modulo " << charac << " in "
+      << varCount << " variables, but this computation is modulo "
+      << ring.charac() << " in " << ring.varCount() << " variables.";
+    mathic::reportError(err.str());
+  }
+
+  uint64 orderSize;
+  if (!readOne(file, orderSize))
+    return false;
+  const auto order = orderDescription(ring);
+  std::vector<int32> fileOrder;
+  for (uint64 i = 0; i < orderSize && i <= order.size(); ++i) {
+    int32 entry;
+    if (!readOne(file, entry))
+      return false;
+    fileOrder.push_back(entry);
+  }
+  if (fileOrder != order) {
+    mathic::reportError("The checkpoint file " + fileName +
+      " is for a computation with a different monomial order or different "
+      "gradings than this computation.");
+  }
+
+  uint64 fileInputHash;
+  if (!readOne(file, fileInputHash))
+    return false;
+  if (fileInputHash != inputHash) {
+    mathic::reportError("The checkpoint file " + fileName +
+      " is for a computation with a different input than this computation.");
+  }
+
+  // The records of a checkpoint are applied to state only once its commit
+  // record has been read, so a checkpoint that was cut short is ignored.
+  std::vector<std::unique_ptr<Poly>> basis;
+  std::vector<exponent> sugar;
+  std::vector<Pair> handledPairs;
+  std::vector<size_t> retired;
+  bool sawCommit = false;
+  while (true) {
+    unsigned char tag;
+    if (!readOne(file, tag))
+      break;
+
+    if (tag == ElementTag) {
+      uint64 index;
+      unsigned char isRetired;
+      if (!readOne(file, index) || !readOne(file, isRetired))
+        break;
+      if (index != state.basis.size() + basis.size())
+        reportCorrupt(fileName);
+      if (isRetired != 0) {
+        basis.emplace_back(nullptr);
+        sugar.push_back(0);
+      } else {
+        int32 polySugar;
+        if (!readOne(file, polySugar))
+          break;
+        auto poly = readPoly(ring, fileName, file);
+        if (poly == nullptr)
+          break;
+        basis.emplace_back(std::move(poly));
+        sugar.push_back(polySugar);
+      }
+    } else if (tag == RetireTag) {
+      uint64 index;
+      if (!readOne(file, index))
+        break;
+      retired.push_back(static_cast<size_t>(index));
+    } else if (tag == PairTag) {
+      uint64 a;
+      uint64 b;
+      if (!readOne(file, a) || !readOne(file, b))
+        break;
+      handledPairs.emplace_back(static_cast<size_t>(a), static_cast<size_t>(b));
+    } else if (tag == CommitTag) {
+      uint64 basisSize;
+      uint64 sPolyReductionCount;
+      if (!readOne(file, basisSize) || !readOne(file, sPolyReductionCount))
+        break;
+      if (basisSize != state.basis.size() + basis.size())
+        reportCorrupt(fileName);
+
+      for (auto& poly : basis)
+        state.basis.emplace_back(std::move(poly));
+      basis.clear();
+      state.sugar.insert(state.sugar.end(), sugar.begin(), sugar.end());
+      sugar.clear();
+      for (const auto index : retired) {
+        if (index >= state.basis.size())
+          reportCorrupt(fileName);
+        state.basis[index].reset();
+      }
+      retired.clear();
+      for (const auto& pair : handledPairs) {
+        if (pair.first >= state.basis.size() ||
+          pair.second >= state.basis.size()) {
+          reportCorrupt(fileName);
+        }
+        state.handledPairs.push_back(pair);
+      }
+      handledPairs.clear();
+      state.sPolyReductionCount = sPolyReductionCount;
+      sawCommit = true;
+    } else
+      reportCorrupt(fileName);
+  }
+  return sawCommit;
+}
+
+GBCheckpoint::GBCheckpoint(
+  const std::string& fileName,
+  const PolyRing& ring,
+  const uint64 inputHash
+):
+  mFileName(fileName),
+  mRing(ring),
+  mInputHash(inputHash),
+  mWrittenCount(0),
+  mWriteCount(0),
+  mSeenRequestCount(requestCount.load(std::memory_order_relaxed))
+{}
+
+void GBCheckpoint::write(
+  const PolyBasis& basis,
+  std::vector<Pair>& handledPairs,
+  const unsigned long long sPolyReductionCount
+) {
+  if (mFile == nullptr) {
+    // Write the complete state to a temporary file first so that an
+    // existing checkpoint file is never left incomplete.
+    const auto tmpName = mFileName + ".tmp";
+    {
+      CFile tmp(tmpName, "wb");
+      writeHeader(tmp.handle());
+      writeChanges(basis, handledPairs, sPolyReductionCount, tmp.handle());
+      if (fflush(tmp.handle()) != 0)
+        mathic::reportError("error while writing checkpoint file.");
+    }
+    // rename replaces an existing file atomically except on Windows, where
+    // it fails instead, so only there is there a moment with no checkpoint.
+#ifdef _WIN32
+    std::remove(mFileName.c_str());
+#endif
+    if (std::rename(tmpName.c_str(), mFileName.c_str()) != 0)
+      mathic::reportError("Could not rename " + tmpName + " to " + mFileName);
+    mFile = make_unique<CFile>(mFileName, "ab");
+  } else {
+    writeChanges(basis, handledPairs, sPolyReductionCount, mFile->handle());
+    if (fflush(mFile->handle()) != 0)
+      mathic::reportError("error while writing checkpoint file.");
+  }
+  handledPairs.clear();
+  ++mWriteCount;
+}
+
+void GBCheckpoint::writeHeader(FILE* file) {
+  if (fwrite(Magic, 1, MagicSize, file) != MagicSize)
+    mathic::reportError("error while writing checkpoint file.");
+  writeOne(static_cast<uint32>(mRing.charac()), file);
+  writeOne(static_cast<uint32>(mRing.varCount()), file);
+  const auto order = orderDescription(mRing);
+  writeOne(static_cast<uint64>(order.size()), file);
+  for (const auto entry : order)
+    writeOne(entry, file);
+  writeOne(mInputHash, file);
+}
+
+void GBCheckpoint::writeChanges(
+  const PolyBasis& basis,
+  const std::vector<Pair>& handledPairs,
+  const unsigned long long sPolyReductionCount,
+  FILE* file
+) {
+  MATHICGB_ASSERT(mWrittenCount <= basis.size());
+  MATHICGB_ASSERT(mWrittenRetired.size() == mWrittenCount);
+
+  for (size_t i = 0; i < mWrittenCount; ++i) {
+    if (basis.retired(i) && !mWrittenRetired[i]) {
+      writeOne(RetireTag, file);
+      writeOne(static_cast<uint64>(i), file);
+      mWrittenRetired[i] = true;
+    }
+  }
+
+  for (; mWrittenCount < basis.size(); ++mWrittenCount) {
+    const bool retired = basis.retired(mWrittenCount);
+    writeOne(ElementTag, file);
+    writeOne(static_cast<uint64>(mWrittenCount), file);
+    writeOne(static_cast<unsigned char>(retired), file);
+    if (!retired) {
+      writeOne(static_cast<int32>(basis.sugar(mWrittenCount)), file);
+      writePoly(basis.poly(mWrittenCount), file);
+    }
+    mWrittenRetired.push_back(retired);
+  }
+
+  // Pairs that involve a retired element are never looked at again.
+  for (const auto& pair : handledPairs) {
+    if (basis.retired(pair.first) || basis.retired(pair.second))
+      continue;
+    writeOne(PairTag, file);
+    writeOne(static_cast<uint64>(pair.first), file);
+    writeOne(static_cast<uint64>(pair.second), file);
+  }
+
+  writeOne(CommitTag, file);
+  writeOne(static_cast<uint64>(basis.size()), file);
+  writeOne(static_cast<uint64>(sPolyReductionCount), file);
+}
+
+void GBCheckpoint::request() {
+  requestCount.fetch_add(1, std::memory_order_relaxed);
+}
+
+bool GBCheckpoint::takeRequest() {
+  const auto count = requestCount.load(std::memory_order_relaxed);
+  if (count == mSeenRequestCount)
+    return false;
+  mSeenRequestCount = count;
+  return true;
+}
+
+MATHICGB_NAMESPACE_END
@@ -0,0 +1,132 @@
+// MathicGB copyright 2012 all rights reserved. MathicGB comes with ABSOLUTELY
+// NO WARRANTY and is licensed as GPL v2.0 or later - see LICENSE.txt.
+#ifndef MATHICGB_G_B_CHECKPOINT_GUARD
+#define MATHICGB_G_B_CHECKPOINT_GUARD
+
+#include "Poly.hpp"
+#include "CFile.hpp"
+#include "NonCopyable.hpp"
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+MATHICGB_NAMESPACE_BEGIN
+
+class PolyBasis;
+class Basis;
+
+/// Records the state of a classic Buchberger computation in a binary file
+/// so that the computation can be resumed after it has been interrupted.
+///
+/// The file is a header followed by a sequence of checkpoints. The header
+/// records the characteristic, the number of variables, the monomial order
+/// including the gradings and a hash of the input of the computation.
+/// Reading a file for a different ring or a different input is an error.
+/// Each checkpoint only contains what has changed since the
+/// previous one: the basis elements inserted since then along with their
+/// sugar, the indices of basis elements that have been retired since then
+/// and the S-pairs whose S-polynomials have been reduced since then. A
+/// checkpoint ends with a commit record, so a checkpoint that was cut short
+/// by a crash is ignored when reading the file. The file is only ever
+/// appended to except for the first write, which writes the complete state
+/// to a temporary file that then replaces any previous file.
+///
+/// Replacing the tail of a basis element by a tail reduced version is not
+/// recorded. A resumed computation uses the version of the polynomial that
+/// was first written, which has the same lead term and generates the same
+/// ideal together with the rest of the basis.
+class GBCheckpoint : public NonCopyable<GBCheckpoint> {
+public:
+  typedef std::pair<size_t, size_t> Pair;
+
+  /// The state of a computation as read from a checkpoint file.
+  struct State {
+    /// The basis elements by index. Retired basis elements are null.
+    std::vector<std::unique_ptr<Poly>> basis;
+
+    /// The sugar of each basis element as for PolyBasis::sugar(). It is 0
+    /// for retired basis elements.
+    std::vector<exponent> sugar;
+
+    /// S-pairs whose S-polynomial has already been reduced.
+    std::vector<Pair> handledPairs;
+
+    unsigned long long sPolyReductionCount;
+  };
+
+  /// Returns a hash of the input of a computation, which is the Groebner
+  /// basis that it starts from and the generators that are added to it.
+  static uint64 inputHash(const Basis& groebnerBasis, const Basis& generators);
+
+  /// Reads the last complete checkpoint in the file fileName into state.
+  /// Returns false if the file does not exist or does not contain a
+  /// complete checkpoint. Reports an error if the file is not a checkpoint
+  /// file for a computation over ring with the input that has the hash
+  /// inputHash.
+  static bool read(
+    const std::string& fileName,
+    const PolyRing& ring,
+    uint64 inputHash,
+    State& state
+  );
+
+  /// Checkpoints will be written to the file fileName for a computation
+  /// whose input has the hash inputHash. Nothing is written until the first
+  /// call to write().
+  GBCheckpoint(
+    const std::string& fileName,
+    const PolyRing& ring,
+    uint64 inputHash
+  );
+
+  /// Appends a checkpoint of the current state of the computation.
+  /// handledPairs are the S-pairs whose S-polynomials have been reduced
+  /// since the last call. handledPairs is cleared.
+  void write(
+    const PolyBasis& basis,
+    std::vector<Pair>& handledPairs,
+    unsigned long long sPolyReductionCount
+  );
+
+  /// Returns how many checkpoints have been written.
+  size_t writeCount() const {return mWriteCount;}
+
+  /// Asks every running computation that writes checkpoints to write one
+  /// as soon as possible. This only increments a lock-free counter, so it
+  /// is safe to call from a signal handler.
+  static void request();
+
+  /// Returns true if request() has been called since the last call to
+  /// takeRequest() on this object or, for the first call, since this object
+  /// was constructed.
+  bool takeRequest();
+
+private:
+  void writeHeader(FILE* file);
+  void writeChanges(
+    const PolyBasis& basis,
+    const std::vector<Pair>& handledPairs,
+    unsigned long long sPolyReductionCount,
+    FILE* file
+  );
+
+  const std::string mFileName;
+  const PolyRing& mRing;
+  const uint64 mInputHash;
+  std::unique_ptr<CFile> mFile;
+
+  /// The number of basis elements written so far.
+  size_t mWrittenCount;
+
+  /// Element i is true if the file records basis element i as retired.
+  std::vector<bool> mWrittenRetired;
+
+  size_t mWriteCount;
+
+  /// The number of calls to request() as of the last call to takeRequest().
+  unsigned int mSeenRequestCount;
+};
+
+MATHICGB_NAMESPACE_END
+#endif
@@ -80,7 +80,9 @@ void LogDomain<true>::recordTime(TimeInterval interval) {
 LogDomain<true>::Timer::Timer(LogDomain<true>& logger):
   mLogger(logger),
   mTimerRunning(false),
-  mRealTicks()
+  mRealTicks(),
+  mTracing(false),
+  mTraceBegin(0)
 {
   start();
 }
@@ -93,6 +95,8 @@ void LogDomain<true>::Timer::stop() {
   if (!running())
     return;
   mTimerRunning = false;
+  if (mTracing && TimeTrace::enabled())
+    TimeTrace::record(mLogger.name(), mTraceBegin, TimeTrace::now());
   if (!mLogger.enabled())
     return;
   TimeInterval interval;
@@ -102,9 +106,12 @@ void LogDomain<true>::Timer::stop() {
 }
 
 void LogDomain<true>::Timer::start() {
-  if (!mLogger.enabled() || mTimerRunning)
+  if (mTimerRunning || (!mLogger.enabled() && !TimeTrace::enabled()))
     return;
   mTimerRunning = true;
+  mTracing = TimeTrace::enabled();
+  if (mTracing)
+    mTraceBegin = TimeTrace::now();
   mRealTicks = mgb::mtbb::tick_count::now();
 }
 
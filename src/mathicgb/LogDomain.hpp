@@ -4,6 +4,7 @@
 #define MATHICGB_LOG_DOMAIN_GUARD
 
 #include "mtbb.hpp"
+#include "TimeTrace.hpp"
 #include <ostream>
 #include <ctime>
 #include <sstream>
@@ -126,16 +127,20 @@ public:
   /// is disabled then no time is logged.
   void stop();
 
-  /// Start recording time on a stopped timer.
+  /// Start recording time on a stopped timer. If tracing is on, the time
+  /// until the timer stops is also recorded as a region of the TimeTrace
+  /// named after the logger, even if the logger is disabled.
   ///
   /// This is a no-op if the timer is already running or if the logger is
-  /// disabled.
+  /// disabled and tracing is off.
   void start();
 
 private:
   LogDomain<true>& mLogger;
   bool mTimerRunning;
   mtbb::tick_count mRealTicks; // high precision
+  bool mTracing; /// Whether the running timer records a TimeTrace region.
+  TimeTrace::Time mTraceBegin;
 };
 
 /// This is a compile-time disabled logger. You are not supposed to dynamically
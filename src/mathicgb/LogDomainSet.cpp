@@ -3,6 +3,7 @@
 #include "stdinc.h"
 #include "LogDomainSet.hpp"
 
+#include "TimeTrace.hpp"
 #include <mathic.h>
 
 MATHICGB_NAMESPACE_BEGIN
@@ -25,6 +26,13 @@ LogDomain<true>* LogDomainSet::logDomain(const char* const name) {
   return it == mLogDomains.end() ? static_cast<LogDomain<true>*>(0) : *it;
 }
 
+bool LogDomainSet::anyEnabled() const {
+  const auto enabled = [](const LogDomain<true>* const ld) {
+    return ld->enabled();
+  };
+  return std::any_of(mLogDomains.begin(), mLogDomains.end(), enabled);
+}
+
 const char* LogDomainSet::alias(const char* name) {
   const auto func = [&](const std::pair<const char*, const char*> p){
     return std::strcmp(p.first, name) == 0;
@@ -69,6 +77,17 @@ void LogDomainSet::performLogCommandInternal(
   if (cmd.empty())
     return;
 
+  // This has to come before the signs are removed since the file name can
+  // end in a sign.
+  const std::string traceCommand = "trace=";
+  if (cmd.compare(0, traceCommand.size(), traceCommand) == 0) {
+    const auto fileName = cmd.substr(traceCommand.size());
+    if (fileName.empty())
+      mathic::reportError("The log command trace= needs a file name.\n");
+    TimeTrace::start(fileName);
+    return;
+  }
+
   // This could be more efficient, but this is not supposed to be a
   // method that is called very often.
 
@@ -201,6 +220,7 @@ void LogDomainSet::printTimeReport(std::ostream& out) const {
 
 void LogDomainSet::reset() {
   mStartTime = mgb::mtbb::tick_count::now();
+  TimeTrace::stop();
   const auto end = logDomains().cend();
   for (auto it = logDomains().cbegin(); it != end; ++it) {
     MATHICGB_ASSERT(*it != 0);
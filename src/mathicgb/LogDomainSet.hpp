@@ -47,6 +47,10 @@ public:
   ///   "+MyLog" will enabled MyLog. Since the streaming state was enabled
   ///     before, we now get streaming.
   ///
+  /// The command trace=F is an exception to the format above. It turns on
+  /// the TimeTrace, which is written to the file F in the Chrome trace
+  /// event format at the end of the computation. F cannot contain a comma.
+  ///
   void performLogCommand(std::string cmd)
     {performLogCommandInternal(' ', std::move(cmd), ' ');}
 
@@ -56,6 +60,12 @@ public:
 
   LogDomain<true>* logDomain(const char* const name);
 
+  /// Returns true if any log domain is enabled. The log domains are not
+  /// synchronized, so work that would otherwise run concurrently has to
+  /// run one piece at a time while this is true. The TimeTrace does not
+  /// count, since it is synchronized.
+  bool anyEnabled() const;
+
   const char* alias(const char* name);
 
   const std::vector<LogDomain<true>*>& logDomains() const {return mLogDomains;}
@@ -68,6 +78,7 @@ public:
 
   /// Resets the logging system as though the program had just started up.
   /// This resets all counts, all recorded time and the enabledness of all logs.
+  /// It also turns off the TimeTrace.
   /// You should not have a timer running for a log when you call this method.
   void reset();
 
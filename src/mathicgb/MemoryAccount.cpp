@@ -0,0 +1,119 @@
+// MathicGB copyright 2012 all rights reserved. MathicGB comes with ABSOLUTELY
+// NO WARRANTY and is licensed as GPL v2.0 or later - see LICENSE.txt.
+#include "stdinc.h"
+#include "MemoryAccount.hpp"
+
+#include <mathic.h>
+#include <algorithm>
+
+MATHICGB_NAMESPACE_BEGIN
+
+MemoryAccount::MemoryAccount(const size_t budget):
+  mBudget(budget),
+  mPeakTotal(0),
+  mBudgetExceeded(false)
+{
+  std::fill_n(mUse, static_cast<size_t>(SubsystemCount), 0);
+  std::fill_n(mPeakUse, static_cast<size_t>(SubsystemCount), 0);
+}
+
+void MemoryAccount::setUse(const Subsystem subsystem, const size_t bytes) {
+  MATHICGB_ASSERT(subsystem < SubsystemCount);
+  mUse[subsystem] = bytes;
+  mPeakUse[subsystem] = std::max(mPeakUse[subsystem], bytes);
+  const auto total = totalUse();
+  mPeakTotal = std::max(mPeakTotal, total);
+  checkBudget(total);
+}
+
+void MemoryAccount::noteTransientUse(
+  const Subsystem subsystem,
+  const size_t bytes,
+  const size_t otherTransientBytes
+) {
+  MATHICGB_ASSERT(subsystem < SubsystemCount);
+  const auto subsystemUse = mUse[subsystem] + bytes;
+  mPeakUse[subsystem] = std::max(mPeakUse[subsystem], subsystemUse);
+  const auto total = totalUse() + bytes + otherTransientBytes;
+  mPeakTotal = std::max(mPeakTotal, total);
+  checkBudget(total);
+}
+
+size_t MemoryAccount::use(const Subsystem subsystem) const {
+  MATHICGB_ASSERT(subsystem < SubsystemCount);
+  return mUse[subsystem];
+}
+
+size_t MemoryAccount::peakUse(const Subsystem subsystem) const {
+  MATHICGB_ASSERT(subsystem < SubsystemCount);
+  return mPeakUse[subsystem];
+}
+
+size_t MemoryAccount::totalUse() const {
+  size_t total = 0;
+  for (size_t i = 0; i < SubsystemCount; ++i)
+    total += mUse[i];
+  return total;
+}
+
+bool MemoryAccount::takeBudgetExceeded() {
+  const bool exceeded = mBudgetExceeded;
+  mBudgetExceeded = false;
+  return exceeded;
+}
+
+void MemoryAccount::checkBudget(const size_t total) {
+  if (mBudget != 0 && total > mBudget)
+    mBudgetExceeded = true;
+}
+
+const char* MemoryAccount::name(const Subsystem subsystem) {
+  switch (subsystem) {
+  case BasisMemory: return "Grobner basis";
+  case SPairMemory: return "S-pairs";
+  case ReducerMemory: return "Reducer";
+  case F4MatrixBuildMemory: return "F4 matrix build";
+  case F4ReductionMemory: return "F4 reduction";
+  case MonomialMemory: return "Monomials";
+  default:
+    MATHICGB_ASSERT(false);
+    return "";
+  }
+}
+
+void MemoryAccount::print(std::ostream& out) const {
+  mic::ColumnPrinter pr;
+  pr.addColumn();
+  pr.addColumn(false);
+  pr.addColumn(false);
+
+  std::ostream& name = pr[0];
+  std::ostream& current = pr[1];
+  std::ostream& peak = pr[2];
+
+  name << '\n';
+  current << "now\n";
+  peak << "peak\n";
+  for (size_t i = 0; i < SubsystemCount; ++i) {
+    const auto subsystem = static_cast<Subsystem>(i);
+    name << this->name(subsystem) << ":\n";
+    current << mic::ColumnPrinter::bytesInUnit(use(subsystem)) << '\n';
+    peak << mic::ColumnPrinter::bytesInUnit(peakUse(subsystem)) << '\n';
+  }
+  name << "-------------\n";
+  current << '\n';
+  peak << '\n';
+
+  name << "Memory used in total:\n";
+  current << mic::ColumnPrinter::bytesInUnit(totalUse()) << '\n';
+  peak << mic::ColumnPrinter::bytesInUnit(peakTotalUse()) << '\n';
+  if (budget() != 0) {
+    name << "Memory budget:\n";
+    current << mic::ColumnPrinter::bytesInUnit(budget()) << '\n';
+    peak << '\n';
+  }
+
+  out << "*** Memory use by component ***\n" << pr << std::flush;
+}
+
+MATHICGB_NAMESPACE_END
@@ -0,0 +1,78 @@
+// MathicGB copyright 2012 all rights reserved. MathicGB comes with ABSOLUTELY
+// NO WARRANTY and is licensed as GPL v2.0 or later - see LICENSE.txt.
+#ifndef MATHICGB_MEMORY_ACCOUNT_GUARD
+#define MATHICGB_MEMORY_ACCOUNT_GUARD
+
+#include <ostream>
+
+MATHICGB_NAMESPACE_BEGIN
+
+/// Keeps track of how much memory each part of a Groebner basis
+/// computation uses, both now and at the peak, and of whether the total
+/// has gone over a budget.
+///
+/// The parts report their memory use at convenient points, such as after
+/// each step of the algorithm, rather than on each allocation. Memory that
+/// is only used for a while in between, like the matrices of an F4
+/// reduction, is reported through noteTransientUse() so that it shows up
+/// in the peaks.
+///
+/// The budget is only checked when memory use is reported, so the
+/// computation can go over it for a while before it reacts.
+class MemoryAccount {
+public:
+  enum Subsystem {
+    BasisMemory,
+    SPairMemory,
+    ReducerMemory,
+    F4MatrixBuildMemory,
+    F4ReductionMemory,
+    MonomialMemory,
+    SubsystemCount
+  };
+
+  /// A budget of 0 means that there is no budget.
+  MemoryAccount(size_t budget = 0);
+
+  size_t budget() const {return mBudget;}
+  void setBudget(size_t budget) {mBudget = budget;}
+
+  /// Records that subsystem now uses bytes of memory.
+  void setUse(Subsystem subsystem, size_t bytes);
+
+  /// Records that subsystem used bytes of memory for a while on top of the
+  /// current use, along with otherTransientBytes of memory used by other
+  /// subsystems for a while at the same time. This memory has since been
+  /// freed, so only the peaks change.
+  void noteTransientUse(
+    Subsystem subsystem,
+    size_t bytes,
+    size_t otherTransientBytes = 0
+  );
+
+  size_t use(Subsystem subsystem) const;
+  size_t peakUse(Subsystem subsystem) const;
+  size_t totalUse() const;
+  size_t peakTotalUse() const {return mPeakTotal;}
+
+  /// Returns true if the budget has been exceeded since the last call to
+  /// this method.
+  bool takeBudgetExceeded();
+
+  static const char* name(Subsystem subsystem);
+
+  /// Prints the current and peak memory use of each subsystem.
+  void print(std::ostream& out) const;
+
+private:
+  void checkBudget(size_t total);
+
+  size_t mBudget;
+  size_t mUse[SubsystemCount];
+  size_t mPeakUse[SubsystemCount];
+  size_t mPeakTotal;
+  bool mBudgetExceeded;
+};
+
+MATHICGB_NAMESPACE_END
+#endif
@@ -127,6 +127,210 @@ private:
   Lookup* const mLookups;
 };
 
+/// Keeps the module monomials of each component in a list sorted by
+/// increasing degree. Each entry has a divisor mask bitmap, so most
+/// non-divisors are rejected without looking at the exponents, and a scan
+/// for divisors stops at the first entry of too high degree. Divisors found
+/// by recent successful member queries are kept in a small cache that is
+/// checked first, since syzygy signatures tend to be hit by the same few
+/// module monomials many times in a row.
+class DegreeModuleMonoSet : public ModuleMonoSet {
+public:
+  typedef PolyRing::Monoid Monoid;
+  typedef Monoid::Exponent Exponent;
+  typedef Monoid::VarIndex VarIndex;
+  typedef unsigned long long DivMask;
+
+  DegreeModuleMonoSet(
+    const Monoid& monoid,
+    const size_t componentCount,
+    const bool allowRemovals
+  ):
+    mMonoid(monoid),
+    mAllowRemovals(allowRemovals),
+    mBitsPerVar(bitsPerVar(monoid.varCount())),
+    mComponents(componentCount)
+  {}
+
+  virtual bool insert(ConstMonoRef m) {
+    const auto c = monoid().component(m);
+    MATHICGB_ASSERT(c < componentCount());
+    const auto mask = divMask(m);
+    const auto degree = this->degree(m);
+    if (isMember(m, mask, degree))
+      return false;
+
+    auto& entries = mComponents[c];
+    const auto byDegree = [](const Entry& a, const Entry& b) {
+      return a.degree < b.degree;
+    };
+    const Entry entry = {degree, mask, m.ptr()};
+    auto pos = std::upper_bound
+      (entries.begin(), entries.end(), entry, byDegree);
+    if (mAllowRemovals) {
+      // Only entries of degree at least that of m can be multiples of m.
+      const auto isMultiple = [&](const Entry& e) {
+        return (mask & ~e.mask) == 0 && monoid().divides(m, *e.mono);
+      };
+      const auto lowDegreeEnd = std::lower_bound
+        (entries.begin(), pos, entry, byDegree);
+      const auto newEnd =
+        std::remove_if(lowDegreeEnd, entries.end(), isMultiple);
+      if (newEnd != entries.end()) {
+        entries.erase(newEnd, entries.end());
+        mCache.clear(); // the cache may refer to removed entries
+        pos = std::upper_bound
+          (entries.begin(), entries.end(), entry, byDegree);
+      }
+    }
+    entries.insert(pos, entry);
+    return true;
+  }
+
+  virtual bool member(ConstMonoRef m) {
+    return isMember(m, divMask(m), degree(m));
+  }
+
+  virtual std::string name() const {
+    return "DegreeList";
+  }
+
+  virtual void display(std::ostream& out) const {
+    std::vector<ConstMonoPtr> monomials;
+    for (size_t c = 0; c < componentCount(); ++c) {
+      const auto& entries = mComponents[c];
+      if (entries.empty())
+        continue;
+      out << "  " << c << ": ";
+      monomials.clear();
+      for (const auto& entry : entries)
+        monomials.emplace_back(entry.mono);
+      const auto& monoid = this->monoid();
+      const auto cmp = [&](ConstMonoPtr a, ConstMonoPtr b) {
+        return monoid.lessThan(*a, *b);
+      };
+      std::sort(monomials.begin(), monomials.end(), cmp);
+      for (auto mono = monomials.cbegin(); mono != monomials.cend(); ++mono) {
+        MathicIO<>().writeMonomial(monoid, false, **mono, out);
+        out << "  ";
+      }
+      out << '\n';
+    }
+  }
+
+  virtual void forAllVirtual(EntryOutput& consumer) {
+    for (const auto& entries : mComponents)
+      for (const auto& entry : entries)
+        consumer.proceed(*entry.mono);
+  }
+
+  virtual size_t elementCount() const {
+    size_t count = 0;
+    for (const auto& entries : mComponents)
+      count += entries.size();
+    return count;
+  }
+
+  virtual size_t getMemoryUse() const {
+    size_t count = mComponents.capacity() * sizeof(mComponents.front()) +
+      mCache.capacity() * sizeof(Entry);
+    for (const auto& entries : mComponents)
+      count += entries.capacity() * sizeof(Entry);
+    return count;
+  }
+
+  const Monoid& monoid() const {return mMonoid;}
+  size_t componentCount() const {return mComponents.size();}
+
+private:
+  struct Entry {
+    Exponent degree;
+    DivMask mask;
+    ConstMonoPtr mono;
+  };
+
+  /// The maximal number of recent hits to keep in the cache.
+  static const size_t MaxCacheSize = 8;
+
+  bool isMember(ConstMonoRef m, const DivMask mask, const Exponent degree) {
+    for (size_t i = 0; i < mCache.size(); ++i) {
+      const auto& hit = mCache[i];
+      if (
+        (hit.mask & ~mask) == 0 &&
+        monoid().dividesWithComponent(*hit.mono, m)
+      ) {
+        // move to front so that the least recently used hit is at the back
+        std::rotate(mCache.begin(), mCache.begin() + i, mCache.begin() + i + 1);
+        return true;
+      }
+    }
+
+    const auto c = monoid().component(m);
+    MATHICGB_ASSERT(c < componentCount());
+    for (const auto& entry : mComponents[c]) {
+      if (entry.degree > degree)
+        break;
+      if ((entry.mask & ~mask) == 0 && monoid().divides(*entry.mono, m)) {
+        if (mCache.size() == MaxCacheSize)
+          mCache.pop_back();
+        mCache.insert(mCache.begin(), entry);
+        return true;
+      }
+    }
+    return false;
+  }
+
+  /// Returns the total degree of m, ignoring any grading. Unlike a
+  /// weighted degree this is always compatible with divisibility.
+  Exponent degree(ConstMonoRef m) const {
+    Exponent degree = 0;
+    const auto varCount = monoid().varCount();
+    for (VarIndex var = 0; var < varCount; ++var)
+      degree += monoid().exponent(m, var);
+    return degree;
+  }
+
+  /// Bit i of the part of the mask for a variable is set if the exponent
+  /// of that variable is greater than i. So if a divides b then the mask of
+  /// a is a subset of the mask of b. With 64 or more variables each
+  /// variable gets a single bit that might be shared with other variables.
+  DivMask divMask(ConstMonoRef m) const {
+    DivMask mask = 0;
+    const auto varCount = monoid().varCount();
+    const auto maskBits = static_cast<VarIndex>(sizeof(DivMask) * 8);
+    for (VarIndex var = 0; var < varCount; ++var) {
+      const auto exponent = monoid().exponent(m, var);
+      if (exponent <= 0)
+        continue;
+      if (mBitsPerVar == 0) {
+        mask |= DivMask(1) << (var % maskBits);
+        continue;
+      }
+      const auto bits = std::min(static_cast<VarIndex>(exponent), mBitsPerVar);
+      mask |= ((DivMask(1) << bits) - 1) << (var * mBitsPerVar);
+    }
+    return mask;
+  }
+
+  /// Returns 0 if the variables have to share bits.
+  static VarIndex bitsPerVar(const VarIndex varCount) {
+    const auto maskBits = static_cast<VarIndex>(sizeof(DivMask) * 8);
+    if (varCount == 0 || varCount > maskBits / 2)
+      return 0;
+    return std::min<VarIndex>(maskBits / varCount, 16);
+  }
+
+  const Monoid& mMonoid;
+  const bool mAllowRemovals;
+  const VarIndex mBitsPerVar;
+
+  /// The entries of each component in order of increasing degree.
+  std::vector<std::vector<Entry>> mComponents;
+
+  /// Recent successful divisors, most recently used first.
+  std::vector<Entry> mCache;
+};
+
 ModuleMonoSet::~ModuleMonoSet() {}
 
 void ModuleMonoSet::displayCodes(std::ostream& out) {
@@ -134,7 +338,8 @@ void ModuleMonoSet::displayCodes(std::ostream& out) {
    "  1   list, using divmasks\n"
    "  2   KD-tree, using divmasks\n"
    "  3   list\n"
-   "  4   KD-tree\n";
+   "  4   KD-tree\n"
+   "  5   list sorted by degree, using divmasks and a cache of hits\n";
 }
 
 namespace {
@@ -178,6 +383,8 @@ std::unique_ptr<ModuleMonoSet> ModuleMonoSet::make(
   const size_t components,
   const bool allowRemovals
 ) {
+  if (type == 5)
+    return make_unique<DegreeModuleMonoSet>(monoid, components, allowRemovals);
   return ModuleMonoSetFactory().make(monoid, type, components, allowRemovals);
 }
 
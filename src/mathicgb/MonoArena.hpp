@@ -5,6 +5,7 @@
 
 #include "Range.hpp"
 #include <algorithm>
+#include <limits>
 #include <vector>
 
 MATHICGB_NAMESPACE_BEGIN
@@ -37,7 +38,9 @@ public:
   }
 
   MonoArena(const MonoArena& a): mVectors(a.mVectors) {}
-  MonoArena(MonoArena&& a): mVectors(std::move(a.mVectors)) {}
+  /// Moving keeps references into the arena valid. The move is noexcept
+  /// so that containers of arenas keep that property when they grow.
+  MonoArena(MonoArena&& a) noexcept: mVectors(std::move(a.mVectors)) {}
 
   MonoArena& operator=(const MonoArena& a) {
     MATHICGB_ASSERT(monoid() == a.monoid());
@@ -109,7 +112,6 @@ public:
     MATHICGB_ASSERT(debugAssertValid());
 
     ensureSpace();
-    return;
     backVector().push_back();
 
     MATHICGB_ASSERT(debugAssertValid());
@@ -179,10 +181,10 @@ public:
   bool debugAssertValid() const {
 #ifdef MATHICGB_DEBUG
     MATHICGB_ASSERT(!mVectors.empty());
-    for (const auto& p : adjPairRange(mVectors)) {
+    // Capacities need not increase from one vector to the next since
+    // copying a vector only keeps its size.
+    for (const auto& p : adjPairRange(mVectors))
       MATHICGB_ASSERT(p.first.monoid() == p.second.monoid());
-      MATHICGB_ASSERT(p.first.capacity() <= p.second.capacity());
-    }
 #endif
     return true;
   }
@@ -204,6 +206,11 @@ private:
       return;
 
     const auto oldSize = backVector().size();
+    if (oldSize == 0) {
+      // Nothing can refer into an empty vector, so it may grow in place.
+      backVector().reserve(MinimumCapacity);
+      return;
+    }
     if (oldSize > std::numeric_limits<decltype(oldSize)>::max() / 2)
       throw std::bad_alloc();
     const auto newSize = 2 * oldSize;
@@ -224,6 +231,9 @@ private:
     return mVectors.back();
   }
 
+  /// The number of monomials that the first vector has room for.
+  static const size_t MinimumCapacity = 64;
+
   std::vector<MonoVector> mVectors;
 };
 
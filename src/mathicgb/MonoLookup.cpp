@@ -30,7 +30,6 @@ namespace {
     {}
 
     const Monoid& monoid() const {return mLookup.monoid();}
-    bool preferSparseReducers() const {return mPreferSparseReducers;}
 
     // *** Virtual interface follows
 
@@ -75,6 +74,19 @@ namespace {
       return mLookup.classicReducer(mono, basis(), preferSparseReducers());
     }
 
+    virtual void classicReducers(
+      const ConstMonoPtr* monos,
+      size_t count,
+      size_t* reducers
+    ) const {
+      // The mathic data structures have no way to share work between
+      // queries, so this is one query per monomial.
+      for (size_t i = 0; i < count; ++i)
+        reducers[i] = classicReducer(*monos[i]);
+    }
+
+    virtual bool preferSparseReducers() const {return mPreferSparseReducers;}
+
     virtual std::string getName() const {return mLookup.getName();}
 
     virtual size_t getMemoryUse() const {return mLookup.getMemoryUse();}
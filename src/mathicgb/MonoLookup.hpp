@@ -43,6 +43,17 @@ public:
   // but the outcome must be deterministic.
   virtual size_t classicReducer(ConstMonoRef mono) const = 0;
 
+  // Sets reducers[i] to classicReducer(*monos[i]) for each i < count. This
+  // can be faster than asking for one reducer at a time.
+  virtual void classicReducers(
+    const ConstMonoPtr* monos,
+    size_t count,
+    size_t* reducers
+  ) const = 0;
+
+  // Returns true if classicReducer prefers reducers with fewer terms.
+  virtual bool preferSparseReducers() const = 0;
+
   virtual std::string getName() const = 0;
 
   virtual size_t getMemoryUse() const = 0;
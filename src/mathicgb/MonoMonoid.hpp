@@ -5,6 +5,7 @@
 
 #include "MonoOrder.hpp"
 #include "NonCopyable.hpp"
+#include "ConcurrentBufferPool.hpp"
 #include <cstddef>
 #include <vector>
 #include <algorithm>
@@ -922,6 +923,11 @@ public:
     return degree(mono, gradingCount() - 1);
   }
 
+  /// Returns true if a < b whenever degree(a) < degree(b). The degree is
+  /// the most significant part of the monomial order, so if this returns
+  /// false then a > b whenever degree(a) < degree(b).
+  bool degreesAscending() const {return isLexBaseOrder();}
+
   /// Returns the degree of mono according to the grading with the
   /// given index.
   Exponent degree(ConstMonoRef mono, VarIndex grading) const {
@@ -1234,6 +1240,9 @@ public:
 
   bool fromPool(ConstMonoRef mono) const {return mPool.fromPool(mono);}
 
+  /// Returns the memory used for the monomials handed out by alloc().
+  size_t getMemoryUse() const {return mPool.getMemoryUse();}
+
   // *** Classes for holding and referring to monomials
 
   class ConstMonoPtr {
@@ -1447,6 +1456,8 @@ public:
 
   // *** Classes that provide memory resources for monomials
 
+  /// Hands out monomials of this monoid. alloc and free may be called
+  /// concurrently from any thread.
   class MonoPool : public NonCopyable<MonoPool> {
   public:
     MonoPool(const MonoMonoid& monoid):
@@ -1454,11 +1465,6 @@ public:
       mPool(sizeof(Exponent) * mMonoid.entryCount())
     {}
 
-    MonoPool(MonoPool&& pool):
-      mMonoid(pool.mMonoid),
-      mPool(std::move(pool.mPool))
-    {}
-
     Mono alloc() {
       const auto ptr = static_cast<Exponent*>(mPool.alloc());
       Mono mono(*MonoPtr(ptr), *this);
@@ -1481,9 +1487,11 @@ public:
       return mPool.fromPool(rawPtr(mono));
     }
 
+    size_t getMemoryUse() const {return mPool.getMemoryUse();}
+
   private:
     const MonoMonoid& mMonoid;
-    memt::BufferPool mPool;
+    ConcurrentBufferPool mPool;
   };
 
   class MonoVector {
@@ -1547,7 +1555,9 @@ public:
 
     MonoVector(const MonoMonoid& monoid): mMonoid(monoid) {}
     MonoVector(const MonoVector& v): mMonos(v.mMonos), mMonoid(v.monoid()) {}
-    MonoVector(MonoVector&& v):
+    /// noexcept so that a std::vector of MonoVectors moves rather than
+    /// copies them when it grows, keeping references into them valid.
+    MonoVector(MonoVector&& v) noexcept:
       mMonos(std::move(v.mMonos)), mMonoid(v.monoid()) {}
 
     MonoVector& operator=(const MonoVector& v) {
@@ -0,0 +1,423 @@
+// MathicGB copyright 2012 all rights reserved. MathicGB comes with ABSOLUTELY
+// NO WARRANTY and is licensed as GPL v2.0 or later - see LICENSE.txt.
+#include "stdinc.h"
+#include "MultiModularGB.hpp"
+
+#include "Basis.hpp"
+#include "ClassicGBAlg.hpp"
+#include "ClassicGBTrace.hpp"
+#include "LogDomainSet.hpp"
+#include "mtbb.hpp"
+#include <mathic.h>
+#include <algorithm>
+#include <map>
+
+MATHICGB_NAMESPACE_BEGIN
+
+namespace {
+  /// All primes used are below this bound. The F4 reducers only support
+  /// 16 bit moduli.
+  const coefficient PrimeBound = 1 << 16;
+
+  bool isPrime(const coefficient n) {
+    if (n < 2)
+      return false;
+    for (coefficient d = 2; d * d <= n; ++d)
+      if (n % d == 0)
+        return false;
+    return true;
+  }
+
+  /// Returns the inverse of a modulo the prime p. a must not be zero.
+  uint64 inverse(const uint64 a, const uint64 p) {
+    MATHICGB_ASSERT(a % p != 0);
+    int64 r0 = static_cast<int64>(p);
+    int64 r1 = static_cast<int64>(a % p);
+    int64 t0 = 0;
+    int64 t1 = 1;
+    while (r1 != 0) {
+      const auto q = r0 / r1;
+      std::swap(r0, r1);
+      r1 -= q * r0;
+      std::swap(t0, t1);
+      t1 -= q * t0;
+    }
+    MATHICGB_ASSERT(r0 == 1);
+    if (t0 < 0)
+      t0 += static_cast<int64>(p);
+    return static_cast<uint64>(t0);
+  }
+
+  BigInteger gcd(BigInteger a, BigInteger b) {
+    BigInteger quotient;
+    while (!b.isZero()) {
+      BigInteger::divide(a, b, quotient, a);
+      std::swap(a, b);
+    }
+    return a.isNegative() ? -a : a;
+  }
+
+  /// Finds n/d with |n| and d at most sqrt(m/2) such that n/d is congruent
+  /// to x modulo m. There is at most one such fraction in lowest terms.
+  /// Returns false if there is none.
+  bool rationalReconstruction(
+    const BigInteger& x,
+    const BigInteger& m,
+    BigInteger& numerator,
+    BigInteger& denominator
+  ) {
+    MATHICGB_ASSERT(!x.isNegative());
+    MATHICGB_ASSERT(x < m);
+
+    // For an integer a, |a| <= sqrt(m/2) if and only if 2a^2 <= m.
+    const auto withinBound = [&](const BigInteger& a) {
+      return BigInteger(2) * a * a <= m;
+    };
+    auto r0 = m;
+    auto r1 = x;
+    BigInteger t0;
+    BigInteger t1(1);
+    BigInteger q;
+    while (!withinBound(r1)) {
+      BigInteger::divide(r0, r1, q, r0);
+      std::swap(r0, r1);
+      t0 -= q * t1;
+      std::swap(t0, t1);
+    }
+    if (t1.isZero() || !withinBound(t1) || gcd(r1, t1) != BigInteger(1))
+      return false;
+    numerator = t1.isNegative() ? -r1 : r1;
+    denominator = t1.isNegative() ? -t1 : t1;
+    return true;
+  }
+}
+
+MultiModularGB::MultiModularGB(const Order& order):
+  mOrder(order),
+  mMonoid(order),
+  mReducerType(Reducer::Reducer_F4_New),
+  mPrimeBatchSize(4),
+  mUseTrace(true),
+  mNextPrime(PrimeBound)
+{
+  MATHICGB_ASSERT(mOrder.isMonomialOrder());
+}
+
+void MultiModularGB::setPrimeBatchSize(const size_t size) {
+  MATHICGB_ASSERT(size > 0);
+  mPrimeBatchSize = std::max<size_t>(size, 1);
+}
+
+auto MultiModularGB::computeGroebnerBasis(
+  const std::vector<RationalPoly>& ideal
+) -> std::vector<RationalPoly> {
+  for (const auto& poly : ideal) {
+    for (const auto& term : poly) {
+      if (term.denominator.isNegative() || term.denominator.isZero())
+        mathic::reportError("Denominators must be positive.");
+      if (term.exponents.size() != mMonoid.varCount())
+        mathic::reportError("A term has the wrong number of exponents.");
+    }
+  }
+
+  mStats = Stats();
+  mStats.primeCount = 0;
+  mStats.rejectedPrimeCount = 0;
+  mStats.failedVerificationCount = 0;
+  mNextPrime = PrimeBound;
+
+  // The first prime records the trace that the other primes replay.
+  ClassicGBTrace trace;
+  std::vector<Image> images;
+  while (images.empty()) {
+    auto image = computeImage
+      (takePrime(), ideal, mUseTrace ? &trace : nullptr, nullptr);
+    ++mStats.primeCount;
+    if (image.ok)
+      images.push_back(std::move(image));
+    else {
+      ++mStats.rejectedPrimeCount;
+      trace = ClassicGBTrace();
+    }
+  }
+
+  while (true) {
+    removeUnluckyImages(images);
+    std::vector<RationalPoly> lifted;
+    if (lift(images, lifted)) {
+      // Verify without the trace so that an error in following the trace
+      // is caught too. If the verification fails, then there were too few
+      // primes for the coefficients, so the check image is kept as one more
+      // prime. Every round uses at least one new prime, so this ends when
+      // the primes run out if it does not end before.
+      auto check = computeImage(takePrime(), ideal, nullptr, nullptr);
+      ++mStats.primeCount;
+      if (check.ok && matches(lifted, check))
+        return lifted;
+      ++mStats.failedVerificationCount;
+      if (check.ok)
+        images.push_back(std::move(check));
+      else
+        ++mStats.rejectedPrimeCount;
+      continue;
+    }
+
+    std::vector<coefficient> primes(mPrimeBatchSize);
+    for (auto& prime : primes)
+      prime = takePrime();
+    std::vector<Image> batch(primes.size());
+    const auto replay = mUseTrace ? &trace : nullptr;
+    const auto computeBatchImage = [&](const size_t i) {
+      batch[i] = computeImage(primes[i], ideal, nullptr, replay);
+    };
+    if (LogDomainSet::singleton().anyEnabled()) {
+      // The computations of the primes would log to the same log domains
+      // at the same time.
+      for (size_t i = 0; i < primes.size(); ++i)
+        computeBatchImage(i);
+    } else {
+      mgb::mtbb::parallel_for(
+        mgb::mtbb::blocked_range<size_t>(0, primes.size(), 1),
+        [&](const mgb::mtbb::blocked_range<size_t>& range) {
+          for (auto i = range.begin(); i != range.end(); ++i)
+            computeBatchImage(i);
+        }
+      );
+    }
+    mStats.primeCount += batch.size();
+    for (auto& image : batch) {
+      if (image.ok)
+        images.push_back(std::move(image));
+      else
+        ++mStats.rejectedPrimeCount;
+    }
+  }
+}
+
+coefficient MultiModularGB::takePrime() {
+  do {
+    --mNextPrime;
+    if (mNextPrime < 2)
+      mathic::reportError("Ran out of primes for multi-modular computation.");
+  } while (!isPrime(mNextPrime));
+  return mNextPrime;
+}
+
+auto MultiModularGB::computeImage(
+  const coefficient prime,
+  const std::vector<RationalPoly>& ideal,
+  ClassicGBTrace* recordTrace,
+  const ClassicGBTrace* replayTrace
+) const -> Image {
+  Image image;
+  image.prime = prime;
+  image.ok = false;
+
+  PolyRing ring(Field(prime), Monoid{mOrder});
+  const auto& monoid = ring.monoid();
+  const auto& field = ring.field();
+
+  Basis basis(ring);
+  auto mono = monoid.alloc();
+  for (const auto& rationalPoly : ideal) {
+    auto poly = make_unique<Poly>(ring);
+    for (const auto& term : rationalPoly) {
+      const auto pLimb = static_cast<uint32>(prime);
+      const auto denominator = term.denominator.residue(pLimb);
+      if (denominator == 0)
+        return image;
+      const auto numerator = term.numerator.residue(pLimb);
+      if (numerator == 0)
+        continue;
+      monoid.setIdentity(*mono);
+      for (size_t var = 0; var < monoid.varCount(); ++var)
+        monoid.setExternalExponent(var, term.exponents[var], *mono);
+      const auto coef = field.quotient(
+        Element(static_cast<coefficient>(numerator)),
+        Element(static_cast<coefficient>(denominator))
+      );
+      poly->append(coef, *mono);
+    }
+    if (!poly->isZero()) {
+      *poly = poly->polyWithTermsDescending();
+      basis.insert(std::move(poly));
+    }
+  }
+
+  const auto reducer = Reducer::makeReducer(mReducerType, ring);
+  ClassicGBAlgParams params;
+  params.reducer = reducer.get();
+  params.monoLookupType = 2;
+  params.preferSparseReducers = true;
+  params.sPairQueueType = 0;
+  params.breakAfter = 0;
+  params.printInterval = 0;
+  params.sPairGroupSize = 0;
+  params.reducerMemoryQuantum = 100 * 1024;
+  params.memoryBudget = 0;
+  params.useAutoTopReduction = true;
+  params.useAutoTailReduction = false;
+  params.useSugar = false;
+  params.useFinalInterreduction = true;
+  params.checkpointInterval = 0;
+  params.resumeFromCheckpoint = false;
+  params.recordTrace = recordTrace;
+  params.replayTrace = replayTrace;
+  params.callback = nullptr;
+  auto gb = computeGBClassicAlg(std::move(basis), params);
+  gb.sort();
+
+  for (size_t i = 0; i < gb.size(); ++i) {
+    const auto& poly = *gb.getPoly(i);
+    ModularPoly modularPoly;
+    for (auto it = poly.begin(); it != poly.end(); ++it) {
+      ModularTerm term;
+      term.coef = it.coef().value();
+      for (size_t var = 0; var < monoid.varCount(); ++var)
+        term.exponents.push_back(monoid.externalExponent(it.mono(), var));
+      modularPoly.push_back(std::move(term));
+    }
+    image.basis.push_back(std::move(modularPoly));
+  }
+  image.ok = true;
+  return image;
+}
+
+void MultiModularGB::removeUnluckyImages(std::vector<Image>& images) {
+  typedef std::vector<std::vector<Exponent>> Leads;
+  auto leads = [](const Image& image) {
+    Leads leads;
+    for (const auto& poly : image.basis)
+      leads.push_back(poly.front().exponents);
+    return leads;
+  };
+
+  // Find the lead monomials of the majority. Ties go to the lead monomials
+  // that were seen first.
+  std::map<Leads, size_t> counts;
+  size_t bestIndex = 0;
+  size_t bestCount = 0;
+  for (size_t i = 0; i < images.size(); ++i) {
+    const auto count = ++counts[leads(images[i])];
+    if (count > bestCount) {
+      bestCount = count;
+      bestIndex = i;
+    }
+  }
+  if (bestCount == images.size())
+    return;
+
+  const auto majority = leads(images[bestIndex]);
+  const auto unlucky = [&](const Image& image) {
+    return leads(image) != majority;
+  };
+  const auto newEnd = std::remove_if(images.begin(), images.end(), unlucky);
+  mStats.rejectedPrimeCount += images.end() - newEnd;
+  images.erase(newEnd, images.end());
+}
+
+bool MultiModularGB::lift(
+  const std::vector<Image>& images,
+  std::vector<RationalPoly>& lifted
+) const {
+  MATHICGB_ASSERT(!images.empty());
+  lifted.clear();
+  const auto& first = images.front();
+  for (size_t i = 0; i < first.basis.size(); ++i) {
+    // Gather the coefficient of each monomial modulo each prime. A monomial
+    // that is missing modulo some prime has coefficient zero there.
+    typedef std::map<std::vector<Exponent>, std::vector<coefficient>> Coefs;
+    Coefs coefs;
+    for (size_t img = 0; img < images.size(); ++img) {
+      MATHICGB_ASSERT(images[img].basis.size() == first.basis.size());
+      for (const auto& term : images[img].basis[i]) {
+        auto& residues = coefs[term.exponents];
+        residues.resize(images.size());
+        residues[img] = term.coef;
+      }
+    }
+
+    RationalPoly poly;
+    for (auto& entry : coefs) {
+      auto& residues = entry.second;
+      residues.resize(images.size());
+
+      // Chinese remaindering: x is the residue modulo the product m of the
+      // primes considered so far.
+      BigInteger x(residues.front());
+      BigInteger m(first.prime);
+      for (size_t img = 1; img < images.size(); ++img) {
+        const uint64 p = images[img].prime;
+        const auto pLimb = static_cast<uint32>(p);
+        const auto diff = (residues[img] + p - x.residue(pLimb)) % p;
+        const auto t = diff * inverse(m.residue(pLimb), p) % p;
+        x += m * BigInteger(static_cast<int64>(t));
+        m *= BigInteger(static_cast<int64>(p));
+      }
+
+      Term term;
+      if (!rationalReconstruction(x, m, term.numerator, term.denominator))
+        return false;
+      if (term.numerator == 0)
+        continue;
+      term.exponents = entry.first;
+      poly.push_back(std::move(term));
+    }
+
+    std::sort(poly.begin(), poly.end(), [&](const Term& a, const Term& b) {
+      return lessThan(b.exponents, a.exponents);
+    });
+    lifted.push_back(std::move(poly));
+  }
+  return true;
+}
+
+bool MultiModularGB::matches(
+  const std::vector<RationalPoly>& lifted,
+  const Image& image
+) const {
+  if (lifted.size() != image.basis.size())
+    return false;
+  const uint64 p = image.prime;
+  const auto pLimb = static_cast<uint32>(p);
+  for (size_t i = 0; i < lifted.size(); ++i) {
+    const auto& modular = image.basis[i];
+    auto it = modular.begin();
+    for (const auto& term : lifted[i]) {
+      const uint64 denominator = term.denominator.residue(pLimb);
+      if (denominator == 0)
+        return false;
+      const auto coef =
+        term.numerator.residue(pLimb) * inverse(denominator, p) % p;
+      if (coef == 0)
+        continue;
+      if (
+        it == modular.end() ||
+        it->exponents != term.exponents ||
+        static_cast<uint64>(it->coef) != coef
+      )
+        return false;
+      ++it;
+    }
+    if (it != modular.end())
+      return false;
+  }
+  return true;
+}
+
+bool MultiModularGB::lessThan(
+  const std::vector<Exponent>& a,
+  const std::vector<Exponent>& b
+) const {
+  auto monoA = mMonoid.alloc();
+  auto monoB = mMonoid.alloc();
+  mMonoid.setIdentity(*monoA);
+  mMonoid.setIdentity(*monoB);
+  for (size_t var = 0; var < mMonoid.varCount(); ++var) {
+    mMonoid.setExternalExponent(var, a[var], *monoA);
+    mMonoid.setExternalExponent(var, b[var], *monoB);
+  }
+  return mMonoid.lessThan(*monoA, *monoB);
+}
+
+MATHICGB_NAMESPACE_END
@@ -0,0 +1,150 @@
+// MathicGB copyright 2012 all rights reserved. MathicGB comes with ABSOLUTELY
+// NO WARRANTY and is licensed as GPL v2.0 or later - see LICENSE.txt.
+#ifndef MATHICGB_MULTI_MODULAR_G_B_GUARD
+#define MATHICGB_MULTI_MODULAR_G_B_GUARD
+
+#include "PolyRing.hpp"
+#include "Reducer.hpp"
+#include "BigInteger.hpp"
+#include <vector>
+
+MATHICGB_NAMESPACE_BEGIN
+
+struct ClassicGBTrace;
+
+/// Computes the reduced Groebner basis of an ideal over the rational numbers
+/// by computing reduced Groebner bases modulo several primes and lifting
+/// the coefficients by Chinese remaindering and rational reconstruction.
+///
+/// The first prime records a trace of the computation. The later primes
+/// skip the groups of S-pairs that reduced to zero for the first prime and
+/// build their F4 matrices from the recorded plans - see ClassicGBTrace.
+/// Batches of later primes are computed concurrently and share the thread
+/// pool with the parallel parts of the reducers. While a log domain is
+/// enabled, the primes of a batch are computed one after the other since
+/// the log domains are not synchronized. Primes whose basis has
+/// different lead monomials than the majority of primes are taken to be
+/// unlucky and are discarded. Once the coefficients can be lifted, the
+/// lifted basis is verified against a basis computed modulo one more prime
+/// without replaying the trace. That makes a wrong answer unlikely, but it
+/// is not a proof that the answer is correct. If the verification fails,
+/// the image of the verification prime is kept and more primes are used.
+///
+/// The primes are the primes below 2^16, since the F4 reducers do not
+/// support larger ones, taken in descending order. The lifting uses
+/// BigInteger, so there is no limit on the size of the coefficients other
+/// than that an error is reported if those primes run out.
+class MultiModularGB {
+public:
+  typedef PolyRing::Monoid Monoid;
+  typedef Monoid::Order Order;
+  typedef Monoid::Exponent Exponent;
+
+  /// The term (numerator / denominator) * x^exponents.
+  struct Term {
+    BigInteger numerator;
+    BigInteger denominator;
+    std::vector<Exponent> exponents;
+  };
+
+  /// The terms of a polynomial. Two terms must not have the same exponents.
+  typedef std::vector<Term> RationalPoly;
+
+  /// Computes Groebner bases of ideals with respect to order. Only ideals
+  /// are supported, not modules.
+  MultiModularGB(const Order& order);
+
+  /// The reducer to use for each prime. The default is the F4 reducer.
+  void setReducerType(Reducer::ReducerType type) {mReducerType = type;}
+
+  /// Sets how many primes to compute at the same time. The default is 4.
+  void setPrimeBatchSize(size_t size);
+
+  /// If value is true, the later primes replay the trace of the first
+  /// prime. The default is true.
+  void setUseTrace(bool value) {mUseTrace = value;}
+
+  /// Returns the reduced Groebner basis of the ideal generated by ideal
+  /// over the rational numbers. Every basis element is monic with terms in
+  /// descending order and the basis elements are sorted in ascending
+  /// order of their lead monomials. Every denominator of the input and of
+  /// the output is positive.
+  std::vector<RationalPoly> computeGroebnerBasis
+    (const std::vector<RationalPoly>& ideal);
+
+  struct Stats {
+    /// The number of primes that a Groebner basis was computed for.
+    size_t primeCount;
+
+    /// The number of primes that were discarded as unlucky or because they
+    /// divide a denominator of the input.
+    size_t rejectedPrimeCount;
+
+    /// The number of times a lifted basis failed verification.
+    size_t failedVerificationCount;
+  };
+
+  /// Returns statistics about the last call to computeGroebnerBasis.
+  const Stats& stats() const {return mStats;}
+
+private:
+  typedef PolyRing::Field Field;
+  typedef Field::Element Element;
+
+  struct ModularTerm {
+    std::vector<Exponent> exponents;
+    coefficient coef;
+  };
+  typedef std::vector<ModularTerm> ModularPoly;
+
+  /// A reduced Groebner basis modulo prime. The basis elements are sorted
+  /// in ascending order of their lead monomials.
+  struct Image {
+    coefficient prime;
+    bool ok; // false if prime divides a denominator of the input
+    std::vector<ModularPoly> basis;
+  };
+
+  coefficient takePrime();
+
+  Image computeImage(
+    coefficient prime,
+    const std::vector<RationalPoly>& ideal,
+    ClassicGBTrace* recordTrace,
+    const ClassicGBTrace* replayTrace
+  ) const;
+
+  /// Removes the images whose lead monomials are not those of the majority
+  /// of the images.
+  void removeUnluckyImages(std::vector<Image>& images);
+
+  /// Lifts the coefficients of images to rational numbers. Returns false
+  /// if that is not possible with the current images.
+  bool lift(
+    const std::vector<Image>& images,
+    std::vector<RationalPoly>& lifted
+  ) const;
+
+  /// Returns true if lifted reduces to image modulo the prime of image.
+  bool matches(
+    const std::vector<RationalPoly>& lifted,
+    const Image& image
+  ) const;
+
+  /// Returns true if a is less than b in the monomial order.
+  bool lessThan(
+    const std::vector<Exponent>& a,
+    const std::vector<Exponent>& b
+  ) const;
+
+  const Order mOrder;
+  const Monoid mMonoid;
+  Reducer::ReducerType mReducerType;
+  size_t mPrimeBatchSize;
+  bool mUseTrace;
+  coefficient mNextPrime;
+  Stats mStats;
+};
+
+MATHICGB_NAMESPACE_END
+#endif
@@ -4,6 +4,7 @@
 #include "PolyBasis.hpp"
 
 #include "Basis.hpp"
+#include <algorithm>
 
 MATHICGB_NAMESPACE_BEGIN
 
@@ -42,7 +43,7 @@ std::unique_ptr<Basis> PolyBasis::initialIdeal() const {
   return basis;
 }
 
-void PolyBasis::insert(std::unique_ptr<Poly> poly) {
+void PolyBasis::insert(std::unique_ptr<Poly> poly, exponent minSugar) {
   MATHICGB_ASSERT(poly.get() != 0);
   MATHICGB_ASSERT(!poly->isZero());
   poly->makeMonic();
@@ -82,10 +83,25 @@ void PolyBasis::insert(std::unique_ptr<Poly> poly) {
   Entry& entry = mEntries.back();
   entry.poly = poly.release();
   entry.leadMinimal = leadMinimal;
+  entry.sugar = minSugar;
+  const auto end = entry.poly->end();
+  for (auto it = entry.poly->begin(); it != end; ++it) {
+    exponent degree = 0;
+    for (size_t var = 0; var < monoid().varCount(); ++var)
+      degree += monoid().exponent(it.mono(), var);
+    entry.sugar = std::max(entry.sugar, degree);
+  }
 
   MATHICGB_ASSERT(mEntries.back().poly != 0);
 }
 
+void PolyBasis::insertRetired() {
+  mEntries.push_back(Entry());
+  Entry& entry = mEntries.back();
+  entry.retired = true;
+  entry.leadMinimal = false;
+}
+
 std::unique_ptr<Poly> PolyBasis::retire(size_t index) {
   MATHICGB_ASSERT(index < size());
   MATHICGB_ASSERT(!retired(index));
@@ -187,6 +203,7 @@ PolyBasis::Entry::Entry():
   poly(0),
   leadMinimal(0),
   retired(false),
+  sugar(0),
   usedAsStartCount(0),
   usedAsReducerCount(0),
   possibleReducerCount(0),
@@ -37,7 +37,16 @@ public:
   /// Inserts a polynomial into the basis at index size() - or index size() - 1
   /// after calling, since size() will increase by one.
   /// Lead monomials must be unique among basis elements.
-  void insert(std::unique_ptr<Poly> poly);
+  void insert(std::unique_ptr<Poly> poly) {insert(std::move(poly), 0);}
+
+  /// As insert(poly), but the sugar of the new basis element is the larger
+  /// of minSugar and the total degree of poly. See sugar().
+  void insert(std::unique_ptr<Poly> poly, exponent minSugar);
+
+  /// Appends a basis element that is already retired. This keeps the
+  /// indices of later basis elements the same as in a previous computation
+  /// that is being resumed.
+  void insertRetired();
 
   /// Returns the index of a basis element whose lead term divides mon.
   /// Returns -1 if there is no such basis element.
@@ -111,6 +120,16 @@ public:
     return poly(index).leadMono();
   }
 
+  /// Returns the sugar degree of the basis element at index. This is an
+  /// upper bound on the total degree of the polynomials that the element
+  /// was computed from, had they been homogenized. For homogeneous input
+  /// it is the total degree of the element. Retired elements keep their
+  /// sugar.
+  exponent sugar(size_t index) const {
+    MATHICGB_ASSERT(index < size());
+    return mEntries[index].sugar;
+  }
+
   /// Returns the lead coefficient of poly(index).
   coefficient leadCoef(size_t index) const {
     MATHICGB_ASSERT(index < size());
@@ -212,6 +231,7 @@ private:
     Poly* poly;
     bool leadMinimal;
     bool retired;
+    exponent sugar;
 
     // Statistics on reducer choice in reduction
     mutable unsigned long long usedAsStartCount;
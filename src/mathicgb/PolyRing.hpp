@@ -249,10 +249,8 @@ public:
   );
   PolyRing(const Field& field, Monoid&& monoid);
 
-  size_t getMemoryUse() const {
-    // todo: Make this more accurate.
-    return 0;
-  }
+  /// Returns the memory used for monomials allocated from the monoid.
+  size_t getMemoryUse() const {return monoid().getMemoryUse();}
 
   coefficient charac() const { return mField.charac(); }
   size_t getNumVars() const { return varCount();}
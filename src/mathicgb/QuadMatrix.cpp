@@ -244,8 +244,19 @@ QuadMatrix QuadMatrix::toCanonical() const {
     }
   }
 
-  matrix.leftColumnMonomials = leftColumnMonomials;
-  matrix.rightColumnMonomials = rightColumnMonomials;
+  // Copy the column monomials so that the new matrix does not depend on
+  // the storage of this one.
+  matrix.monomialStorage.emplace_back(monoid());
+  auto& arena = matrix.monomialStorage.back();
+  const auto copyMonos = [&](const Monomials& from, Monomials& to) {
+    to.reserve(from.size());
+    for (const auto& mono : from) {
+      arena.push_back(*mono);
+      to.push_back(arena.back().ptr());
+    }
+  };
+  copyMonos(leftColumnMonomials, matrix.leftColumnMonomials);
+  copyMonos(rightColumnMonomials, matrix.rightColumnMonomials);
   
   return std::move(matrix);
 }
@@ -5,6 +5,7 @@
 
 #include "PolyRing.hpp"
 #include "SparseMatrix.hpp"
+#include "MonoArena.hpp"
 #include <vector>
 #include <string>
 #include <ostream>
@@ -34,6 +35,7 @@ public:
     bottomRight(std::move(matrix.bottomRight)),
     leftColumnMonomials(std::move(matrix.leftColumnMonomials)),
     rightColumnMonomials(std::move(matrix.rightColumnMonomials)),
+    monomialStorage(std::move(matrix.monomialStorage)),
     mRing(&matrix.ring())
   {}
 
@@ -49,6 +51,7 @@ public:
   }
 
   typedef std::vector<ConstMonoPtr> Monomials;
+  typedef std::vector<MonoArena<Monoid>> MonomialStorage;
 
   SparseMatrix topLeft; 
   SparseMatrix topRight;
@@ -57,6 +60,12 @@ public:
   Monomials leftColumnMonomials;
   Monomials rightColumnMonomials;
 
+  /// Backing memory for the column monomials. The monomials are released
+  /// all at once when the storage goes away, so nobody has to free them
+  /// one at a time. A matrix builder may leave this empty if the column
+  /// monomials live elsewhere, as long as they outlive the matrix.
+  MonomialStorage monomialStorage;
+
   /// Prints whole matrix to out in human-readable format. Useful for
   /// debugging.
   void print(std::ostream& out) const;
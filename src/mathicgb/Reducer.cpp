@@ -110,6 +110,13 @@ Reducer::ReducerType Reducer::reducerType(int type)
   case 25: return Reducer_F4_Old;
   case 26: return Reducer_F4_New;
 
+  case 27: return Reducer_Degree_NoDedup;
+  case 28: return Reducer_Degree_Dedup;
+  case 29: return Reducer_Degree_Hashed;
+  case 30: return Reducer_Degree_NoDedup_Packed;
+  case 31: return Reducer_Degree_Dedup_Packed;
+  case 32: return Reducer_Degree_Hashed_Packed;
+
   default: return Reducer_Geobucket_Hashed;
   }
 }
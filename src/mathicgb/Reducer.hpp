@@ -6,12 +6,15 @@
 #include "PolyRing.hpp"
 #include <memtailor.h>
 #include <memory>
+#include <vector>
 
 MATHICGB_NAMESPACE_BEGIN
 
 class Poly;
 class SigPolyBasis;
 class PolyBasis;
+struct F4MatrixPlan;
+class MemoryAccount;
 
 /// Abstract base class for classes that allow reduction of polynomials.
 ///
@@ -74,6 +77,16 @@ public:
     std::vector<std::unique_ptr<Poly> >& reducedOut
   ) = 0;
 
+  /// Tail reduces each non-retired element of basis by basis. basis must
+  /// be a minimal Groebner basis, and then the result is the reduced
+  /// Groebner basis. reducedOut gets size basis.size() and reducedOut[i]
+  /// is the monic tail reduced form of basis element i, or null if that
+  /// element is retired.
+  virtual void classicTailReduceBasis(
+    const PolyBasis& basis,
+    std::vector<std::unique_ptr<Poly>>& reducedOut
+  ) = 0;
+
   /// Regular reduce multiple*basisElement in signature sig by the
   /// basis elements in basis. Returns null (0) if multiple*basisElement
   /// is not regular top reducible -- this indicates a singular
@@ -85,10 +98,40 @@ public:
     const SigPolyBasis& basis
   ) = 0;
 
+  /// Announces that regularReduce is about to be called for
+  /// multiples[i]*basisElements[i] in signature sigs[i] for each i, in
+  /// that order. The signatures must be strictly increasing and must not
+  /// have been announced before, while earlier announcements still hold.
+  /// Some of these calls may be skipped and calls for other signatures may
+  /// come in between. A reducer can use this to do these reductions together, but
+  /// the results of regularReduce must be the same as without this call.
+  /// Reducers that reduce one polynomial at a time ignore this.
+  virtual void regularReduceAhead(
+    const std::vector<ConstMonoPtr>& sigs,
+    const std::vector<ConstMonoPtr>& multiples,
+    const std::vector<size_t>& basisElements,
+    const SigPolyBasis& basis
+  ) {}
+
   /// Sets how many bytes of memory to increase the memory use by
   /// at a time - if such a thing is appropriate for the reducer.
   virtual void setMemoryQuantum(size_t quantum) = 0;
 
+  /// The matrices built by the following calls to classicReduceSPolySet
+  /// record their plan into record and are built from the plan replay. Each
+  /// parameter can be null to turn that off. Reducers that do not build
+  /// F4 matrices ignore this.
+  virtual void setMatrixPlans(
+    F4MatrixPlan* record,
+    const F4MatrixPlan* replay
+  ) {}
+
+  /// Reports the memory used by the following reductions to account, or to
+  /// nothing if account is null. Reducers can also use the budget of account
+  /// to decide how much to keep in caches. Reducers that have nothing to
+  /// report ignore this.
+  virtual void setMemoryAccount(MemoryAccount* account) {}
+
 
   // ***** Kinds of reducers and creating a Reducer 
 
@@ -115,7 +158,14 @@ public:
     Reducer_Geobucket_Hashed_Packed,
 
     Reducer_F4_Old,
-    Reducer_F4_New
+    Reducer_F4_New,
+
+    Reducer_Degree_NoDedup,
+    Reducer_Degree_Dedup,
+    Reducer_Degree_Hashed,
+    Reducer_Degree_NoDedup_Packed,
+    Reducer_Degree_Dedup_Packed,
+    Reducer_Degree_Hashed_Packed
   };
 
   static std::unique_ptr<Reducer> makeReducer
@@ -8,6 +8,7 @@
 
 #include "TypicalReducer.hpp"
 #include "ReducerHelper.hpp"
+#include "DegreeQueue.hpp"
 #include <memtailor.h>
 #include <mathic.h>
 
@@ -47,6 +48,7 @@ public:
     CompareResult compare(const Entry& a, const Entry& b) const {
       return ring().monoid().compare(*a.mono, *b.mono);
     }
+    ConstMonoRef mono(const Entry& e) const {return *e.mono;}
     Entry deduplicate(Entry a, Entry b) const {
       // change a.coeff, and free b.monom
       ring().coefficientAddTo(a.coef, b.coef);
@@ -185,4 +187,10 @@ MATHICGB_REGISTER_REDUCER(
   make_unique<ReducerDedup<mic::Geobucket>>(ring)
 );
 
+MATHICGB_REGISTER_REDUCER(
+  "DegDedup",
+  Reducer_Degree_Dedup,
+  make_unique<ReducerDedup<DegreeQueue>>(ring)
+);
+
 MATHICGB_NAMESPACE_END
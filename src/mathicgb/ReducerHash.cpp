@@ -5,6 +5,7 @@
 
 #include "TypicalReducer.hpp"
 #include "ReducerHelper.hpp"
+#include "DegreeQueue.hpp"
 #include "PolyHashTable.hpp"
 #include <memtailor.h>
 #include <mathic.h>
@@ -46,6 +47,7 @@ public:
     CompareResult compare(const Entry& a, const Entry& b) const {
       return ring().monoid().lessThan(a->mono(), b->mono());
     }
+    ConstMonoRef mono(const Entry& e) const {return e->mono();}
   };
   
 private:
@@ -150,4 +152,10 @@ MATHICGB_REGISTER_REDUCER(
   make_unique<ReducerHash<mic::Geobucket>>(ring)
 );
 
+MATHICGB_REGISTER_REDUCER(
+  "DegHash",
+  Reducer_Degree_Hashed,
+  make_unique<ReducerHash<DegreeQueue>>(ring)
+);
+
 MATHICGB_NAMESPACE_END
@@ -5,6 +5,7 @@
 
 #include "TypicalReducer.hpp"
 #include "ReducerHelper.hpp"
+#include "DegreeQueue.hpp"
 #include "PolyHashTable.hpp"
 #include <mathic.h>
 #include <memtailor.h>
@@ -69,6 +70,7 @@ private:
     CompareResult compare(const Entry& a, const Entry& b) const {
       return ring().monoid().lessThan(a->node->mono(), b->node->mono());
     }
+    ConstMonoRef mono(const Entry& e) const {return e->node->mono();}
   };
 
   void insertEntry(MultipleWithPos* entry);
@@ -244,4 +246,10 @@ MATHICGB_REGISTER_REDUCER(
   make_unique<ReducerHashPack<mic::Geobucket>>(ring)
 );
 
+MATHICGB_REGISTER_REDUCER(
+  "DegHashPack",
+  Reducer_Degree_Hashed_Packed,
+  make_unique<ReducerHashPack<DegreeQueue>>(ring)
+);
+
 MATHICGB_NAMESPACE_END
@@ -5,6 +5,7 @@
 
 #include "TypicalReducer.hpp"
 #include "ReducerHelper.hpp"
+#include "DegreeQueue.hpp"
 #include <memtailor.h>
 #include <mathic.h>
 
@@ -47,6 +48,7 @@ private:
     CompareResult compare(const Entry& a, const Entry& b) const {
       return ring().monoid().lessThan(*a.mono, *b.mono);
     }
+    ConstMonoRef mono(const Entry& e) const {return *e.mono;}
   };
 
   const PolyRing& mRing;
@@ -181,4 +183,10 @@ MATHICGB_REGISTER_REDUCER(
   make_unique<ReducerNoDedup<mic::Geobucket>>(ring)
 );
 
+MATHICGB_REGISTER_REDUCER(
+  "DegNoDedup",
+  Reducer_Degree_NoDedup,
+  make_unique<ReducerNoDedup<DegreeQueue>>(ring)
+);
+
 MATHICGB_NAMESPACE_END
@@ -5,6 +5,7 @@
 
 #include "TypicalReducer.hpp"
 #include "ReducerHelper.hpp"
+#include "DegreeQueue.hpp"
 #include <memtailor.h>
 #include <mathic.h>
 
@@ -77,6 +78,7 @@ private:
     CompareResult compare(const Entry& a, const Entry& b) const {
       return ring().monoid().lessThan(*a->current, *b->current);
     }
+    ConstMonoRef mono(const Entry& e) const {return *e->current;}
   };
 
 private:
@@ -250,4 +252,10 @@ MATHICGB_REGISTER_REDUCER(
   make_unique<ReducerPack<mic::Geobucket>>(ring)
 );
 
+MATHICGB_REGISTER_REDUCER(
+  "DegNoDedupPack",
+  Reducer_Degree_NoDedup_Packed,
+  make_unique<ReducerPack<DegreeQueue>>(ring)
+);
+
 MATHICGB_NAMESPACE_END
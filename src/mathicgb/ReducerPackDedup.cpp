@@ -5,6 +5,7 @@
 
 #include "TypicalReducer.hpp"
 #include "ReducerHelper.hpp"
+#include "DegreeQueue.hpp"
 #include <memtailor.h>
 #include <mathic.h>
 
@@ -84,6 +85,7 @@ private:
     CompareResult compare(const Entry& a, const Entry& b) const {
       return ring().monoid().compare(*a->current, *b->current);
     }
+    ConstMonoRef mono(const Entry& e) const {return *e->current;}
     Entry deduplicate(Entry a, Entry b) const {
       a->mergeChains(*b);
       return a;
@@ -322,4 +324,10 @@ MATHICGB_REGISTER_REDUCER(
   make_unique<ReducerPackDedup<mic::Geobucket>>(ring)
 );
 
+MATHICGB_REGISTER_REDUCER(
+  "DegDedupPack",
+  Reducer_Degree_Dedup_Packed,
+  make_unique<ReducerPackDedup<DegreeQueue>>(ring)
+);
+
 MATHICGB_NAMESPACE_END
@@ -38,6 +38,19 @@ SPairs::SPairs(const PolyBasis& basis, bool preferSparseSPairs):
   mBasis(basis)
  {}
 
+void SPairs::setUseSugar(bool value) {
+  MATHICGB_ASSERT(mQueue.columnCount() == 0);
+  mQueue.configuration().setUseSugar(value);
+}
+
+exponent SPairs::sugar(size_t a, size_t b) const {
+  MATHICGB_ASSERT(a != b);
+  auto lcm = orderMonoid().alloc();
+  orderMonoid().lcm
+    (monoid(), mBasis.leadMono(a), monoid(), mBasis.leadMono(b), *lcm);
+  return mQueue.configuration().sugar(std::max(a, b), std::min(a, b), *lcm);
+}
+
 std::pair<size_t, size_t> SPairs::pop() {
   MATHICGB_LOG_TIME(SPairLate);
 
@@ -51,7 +64,7 @@ std::pair<size_t, size_t> SPairs::pop() {
       continue;
     }
     auto lcm = bareMonoid().alloc(); // todo: just keep one around instead
-    bareMonoid().copy(orderMonoid(), *mQueue.topPairData(), *lcm);
+    bareMonoid().copy(orderMonoid(), *mQueue.topPairData().lcm, *lcm);
     mQueue.pop();
 
     MATHICGB_ASSERT(bareMonoid().isLcm(
@@ -68,6 +81,14 @@ std::pair<size_t, size_t> SPairs::pop() {
 }
 
 std::pair<size_t, size_t> SPairs::pop(exponent& w) {
+  const auto invalid = static_cast<size_t>(-1);
+  return pop(w, std::make_pair(invalid, invalid));
+}
+
+std::pair<size_t, size_t> SPairs::pop(
+  exponent& w,
+  const std::pair<size_t, size_t> known
+) {
   MATHICGB_LOG_TIME(SPairLate);
 
   // Must call addPairs for new elements before popping.
@@ -78,18 +99,21 @@ std::pair<size_t, size_t> SPairs::pop(exponent& w) {
     if (mBasis.retired(p.first) || mBasis.retired(p.second))
       continue;
     auto lcm = bareMonoid().alloc(); // todo: just keep one around instead
-    bareMonoid().copy(orderMonoid(), *mQueue.topPairData(), *lcm);
+    bareMonoid().copy(orderMonoid(), *mQueue.topPairData().lcm, *lcm);
 
     MATHICGB_ASSERT(bareMonoid().isLcm(
       monoid(), mBasis.leadMono(p.first),
       monoid(), mBasis.leadMono(p.second),
       *lcm
     ));
-    if (advancedBuchbergerLcmCriterion(p.first, p.second, *lcm))
+    if (p != known && advancedBuchbergerLcmCriterion(p.first, p.second, *lcm))
       continue;
+    const auto degree = mQueue.configuration().useSugar() ?
+      mQueue.topPairData().sugar :
+      bareMonoid().degree(*lcm);
     if (w == 0)
-      w = bareMonoid().degree(*lcm);
-    else if (w != bareMonoid().degree(*lcm))
+      w = degree;
+    else if (w != degree)
       break;
     mQueue.pop();
     mEliminated.setBit(p.first, p.second, true);
@@ -226,11 +250,14 @@ void SPairs::addPairs(size_t newGen) {
   std::vector<PrePair> prePairs;
   prePairMonos.reserve(newGen);
   prePairs.reserve(newGen);
+  // prePairSugars[oldGen] is the sugar of (newGen,oldGen) if sugar is used.
+  const auto useSugar = mQueue.configuration().useSugar();
+  std::vector<exponent> prePairSugars(useSugar ? newGen : 0);
 
   auto newLead = mBasis.leadMono(newGen);
   auto lcm = mBareMonoid.alloc();
   for (size_t oldGen = 0; oldGen < newGen; ++oldGen) {
-    if (mBasis.retired(oldGen))
+    if (mBasis.retired(oldGen) || mEliminated.bit(newGen, oldGen))
       continue;
     auto oldLead = mBasis.leadMono(oldGen);
     if (monoid().component(newLead) != monoid().component(oldLead)) {
@@ -251,18 +278,68 @@ void SPairs::addPairs(size_t newGen) {
     prePairMonos.push_back(bareMonoid(), *lcm);
     prePairs.emplace_back
       (prePairMonos.back().ptr(), static_cast<Queue::Index>(oldGen));
+    if (useSugar) {
+      prePairSugars[oldGen] =
+        mQueue.configuration().sugar(newGen, oldGen, prePairMonos.back());
+    }
   }
 
   std::sort(prePairs.begin(), prePairs.end(),
     [&](const PrePair& a, const PrePair& b)
   {
-    return mQueue.configuration().compare
-      (b.second, newGen, b.first, a.second, newGen, a.first);
+    const auto sugarA = useSugar ? prePairSugars[a.second] : 0;
+    const auto sugarB = useSugar ? prePairSugars[b.second] : 0;
+    return mQueue.configuration().compare(
+      b.second, newGen, sugarB, *b.first,
+      a.second, newGen, sugarA, *a.first
+    );
   });
   mQueue.addColumnDescending
 	(makeSecondIterator(prePairs.begin()), makeSecondIterator(prePairs.end()));
 }
 
+void SPairs::restorePairs(
+  const std::vector<std::pair<size_t, size_t>>& handledPairs
+) {
+  MATHICGB_ASSERT(mQueue.columnCount() == 0);
+  MATHICGB_ASSERT(mEliminated.columnCount() == 0);
+
+  while (mEliminated.columnCount() < mBasis.size()) {
+    if (mUseBuchbergerLcmHitCache)
+      mBuchbergerLcmHitCache.push_back(0);
+    mEliminated.addColumn();
+  }
+  for (auto it = handledPairs.begin(); it != handledPairs.end(); ++it) {
+    MATHICGB_ASSERT(it->first < mBasis.size());
+    MATHICGB_ASSERT(it->second < mBasis.size());
+    MATHICGB_ASSERT(it->first != it->second);
+    mEliminated.setBitUnordered(it->first, it->second, true);
+  }
+
+  const std::vector<Queue::Index> noPairs;
+  for (size_t gen = 0; gen < mBasis.size(); ++gen) {
+    if (mBasis.retired(gen))
+      mQueue.addColumnDescending(noPairs.begin(), noPairs.end());
+    else
+      addPairs(gen);
+  }
+}
+
+void SPairs::addGroebnerBasis() {
+  MATHICGB_ASSERT(mQueue.columnCount() == 0);
+  MATHICGB_ASSERT(mEliminated.columnCount() == 0);
+
+  const std::vector<Queue::Index> noPairs;
+  for (size_t gen = 0; gen < mBasis.size(); ++gen) {
+    if (mUseBuchbergerLcmHitCache)
+      mBuchbergerLcmHitCache.push_back(0);
+    mEliminated.addColumn();
+    for (size_t old = 0; old < gen; ++old)
+      mEliminated.setBit(gen, old, true);
+    mQueue.addColumnDescending(noPairs.begin(), noPairs.end());
+  }
+}
+
 size_t SPairs::getMemoryUse() const {
   return mQueue.getMemoryUse();
 }
@@ -687,10 +764,35 @@ std::string SPairs::name() const {
   return mQueue.name();
 }
 
+exponent SPairs::QueueConfiguration::sugar(
+  size_t col,
+  size_t row,
+  OrderMonoid::ConstMonoRef lcm
+) const {
+  if (mBasis.retired(col) || mBasis.retired(row))
+    return 0;
+  const auto lcmDegree = [&]() {
+    exponent degree = 0;
+    for (size_t var = 0; var < orderMonoid().varCount(); ++var)
+      degree += orderMonoid().exponent(lcm, var);
+    return degree;
+  }();
+  // Returns how much the sugar of basis element index exceeds the total
+  // degree of its lead monomial.
+  const auto excess = [&](size_t index) {
+    const auto lead = mBasis.leadMono(index);
+    exponent degree = 0;
+    for (size_t var = 0; var < monoid().varCount(); ++var)
+      degree += monoid().exponent(lead, var);
+    return mBasis.sugar(index) - degree;
+  };
+  return lcmDegree + std::max(excess(col), excess(row));
+}
+
 void SPairs::QueueConfiguration::computePairData(
   size_t a,
   size_t b,
-  OrderMonoid::MonoRef orderBy
+  PairData& pd
 ) const {
   MATHICGB_ASSERT(a != b);
   MATHICGB_ASSERT(a < mBasis.size());
@@ -701,7 +803,9 @@ void SPairs::QueueConfiguration::computePairData(
   }
   Monoid::ConstMonoRef leadA = mBasis.leadMono(a);
   Monoid::ConstMonoRef leadB = mBasis.leadMono(b);
-  orderMonoid().lcm(monoid(), leadA, monoid(), leadB, orderBy);
+  orderMonoid().lcm(monoid(), leadA, monoid(), leadB, *pd.lcm);
+  if (mUseSugar)
+    pd.sugar = sugar(a, b, *pd.lcm);
   return; //todo: return true;
 }
 
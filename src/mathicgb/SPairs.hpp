@@ -38,6 +38,18 @@ public:
 
   SPairs(const PolyBasis& basis, bool preferSparseSPairs);
 
+  // If value is true, S-pairs are ordered by their sugar degree first and
+  // then by their lcm, and pop(w) groups S-pairs by sugar degree instead of
+  // by the degree of the lcm. The sugar degree of the S-pair (a,b) is
+  //   deg(l(a,b)) + max(sugar(a) - deg(lead(a)), sugar(b) - deg(lead(b)))
+  // where deg is the total degree and sugar is PolyBasis::sugar. Then the
+  // S-pairs come in the order that they would for the homogenized input.
+  // Must be called before any pairs are added.
+  void setUseSugar(bool value);
+
+  // Returns the sugar degree of the S-pair (a,b) as defined for setUseSugar.
+  exponent sugar(size_t a, size_t b) const;
+
   // Returns the number of S-pairs in the data structure.
   size_t pairCount() const {return mQueue.pairCount();}
 
@@ -58,9 +70,16 @@ public:
 
   // As pop(), but only pops S-pairs whose lcm have the passed-in
   // weight. If deg is already 0, then instead set deg to the weight
-  // of the returned S-pair, if any.
+  // of the returned S-pair, if any. If sugar is being used, then the
+  // weight is the sugar degree of the S-pair instead.
   std::pair<size_t, size_t> pop(exponent& w);
 
+  // As pop(w), but if the next S-pair is known, then it is returned
+  // without checking the late criterion for it, which saves that work when
+  // the S-pairs of an earlier run are known to be useful. Skipping the
+  // criterion is always correct. Pass (invalid,invalid) for no known pair.
+  std::pair<size_t, size_t> pop(exponent& w, std::pair<size_t, size_t> known);
+
   // Add the pairs (index,a) to the data structure for those a such that
   // a < index. Some of those pairs may be eliminated if they can be proven
   // to be useless. index must be a valid index of a basis element
@@ -75,6 +94,24 @@ public:
   // will contain those indices x.
   void addPairsAssumeAutoReduce(size_t index, std::vector<size_t>& toRetireAndReduce);
 
+  // Adds the pairs of every basis element as though addPairs had been called
+  // for each of them in order, except that the pairs in handledPairs are
+  // taken to have already been reduced. This is for resuming a computation
+  // from a checkpoint, so no pairs may have been added before.
+  //
+  // The pairs that were eliminated in the previous computation by a
+  // criterion are found again by applying the criteria to the current
+  // basis. The late criterion in pop() does not record which pairs it
+  // eliminated, so those pairs are queued again and then eliminated again
+  // when they are popped.
+  void restorePairs(const std::vector<std::pair<size_t, size_t>>& handledPairs);
+
+  // Takes the current basis elements to be a Groebner basis, so that every
+  // S-pair between them is taken to have already been reduced and none of
+  // them are queued. Pairs with basis elements that are added later are
+  // queued as usual. No pairs may have been added before.
+  void addGroebnerBasis();
+
   // Returns true if the S-pair (a,b) is known to be useless. Even if the
   // S-pair is not useless now, it will become so later. At the latest, an
   // S-pair becomes useless when its S-polynomial has been reduced to zero.
@@ -172,18 +209,52 @@ private:
       mBasis(basis),
       mMonoid(basis.ring().monoid()),
       mOrderMonoid(orderMonoid),
-      mPreferSparseSPairs(preferSparseSPairs) {}
+      mPreferSparseSPairs(preferSparseSPairs),
+      mUseSugar(false) {}
+
+    void setUseSugar(bool value) {mUseSugar = value;}
+    bool useSugar() const {return mUseSugar;}
+
+    // Returns the sugar degree of the S-pair (col,row) whose lcm is lcm.
+    // Returns 0 if col or row has been retired.
+    exponent sugar(size_t col, size_t row, OrderMonoid::ConstMonoRef lcm) const;
 
-    typedef OrderMonoid::Mono PairData;
-    void computePairData
-    (size_t col, size_t row, OrderMonoid::MonoRef m) const;
+    // The lcm of an S-pair and, if sugar is used, its sugar degree. The
+    // sugar is computed when the S-pair is added, since the queue compares
+    // S-pairs many times and the sugar of a basis element can change once
+    // it is retired.
+    struct PairData {
+      PairData(OrderMonoid::Mono&& lcm): lcm(std::move(lcm)), sugar(0) {}
+
+      OrderMonoid::Mono lcm;
+      exponent sugar;
+    };
+    void computePairData(size_t col, size_t row, PairData& pd) const;
 
     typedef bool CompareResult;
     bool compare(
-      size_t colA, size_t rowA, OrderMonoid::ConstMonoPtr a,
-      size_t colB, size_t rowB, OrderMonoid::ConstMonoPtr b
+      size_t colA, size_t rowA, const PairData& a,
+      size_t colB, size_t rowB, const PairData& b
+    ) const {
+      return compare
+        (colA, rowA, a.sugar, *a.lcm, colB, rowB, b.sugar, *b.lcm);
+    }
+
+    // As compare above for the S-pairs with the given sugar and lcm.
+    bool compare(
+      size_t colA,
+      size_t rowA,
+      exponent sugarA,
+      OrderMonoid::ConstMonoRef lcmA,
+      size_t colB,
+      size_t rowB,
+      exponent sugarB,
+      OrderMonoid::ConstMonoRef lcmB
     ) const {
-      const auto cmp = orderMonoid().compare(*a, *b);
+      if (mUseSugar && sugarA != sugarB)
+        return sugarA > sugarB;
+
+      const auto cmp = orderMonoid().compare(lcmA, lcmB);
       if (cmp == GT)
         return true;
       if (cmp == LT)
@@ -224,6 +295,7 @@ private:
     const Monoid& mMonoid;
     const OrderMonoid& mOrderMonoid;
     const bool mPreferSparseSPairs;
+    bool mUseSugar;
   };
   typedef mathic::PairQueue<QueueConfiguration> Queue;
   Queue mQueue;
@@ -251,7 +323,7 @@ private:
   friend void mathic::PairQueueNamespace::constructPairData<QueueConfiguration>
   (void*, mathic::PairQueueNamespace::Index, mathic::PairQueueNamespace::Index, QueueConfiguration&);
   friend void mathic::PairQueueNamespace::destructPairData<QueueConfiguration>
-  (OrderMonoid::Mono*, mathic::PairQueueNamespace::Index, mathic::PairQueueNamespace::Index, QueueConfiguration&);
+  (QueueConfiguration::PairData*, mathic::PairQueueNamespace::Index, mathic::PairQueueNamespace::Index, QueueConfiguration&);
 };
 
 MATHICGB_NAMESPACE_END
@@ -268,20 +340,20 @@ namespace mathic {
       MATHICGB_ASSERT(memory != 0);
       MATHICGB_ASSERT(col > row);
       auto pd = new (memory)
-        mgb::SPairs::OrderMonoid::Mono(conf.allocPairData());
+        mgb::SPairs::QueueConfiguration::PairData(conf.allocPairData());
       conf.computePairData(col, row, *pd);
     }
     
     template<>
     inline void destructPairData(
-      mgb::SPairs::OrderMonoid::Mono* pd,
+      mgb::SPairs::QueueConfiguration::PairData* pd,
       const Index col,
       const Index row,
       mgb::SPairs::QueueConfiguration& conf
     ) {
       MATHICGB_ASSERT(pd != 0);
       MATHICGB_ASSERT(col > row);
-      conf.freePairData(std::move(*pd));
+      conf.freePairData(std::move(pd->lcm));
     }	
   }
 }
@@ -10,6 +10,7 @@
 #include "LogDomain.hpp"
 #include <mathic.h>
 #include <limits>
+#include <algorithm>
 
 MATHICGB_DEFINE_LOG_DOMAIN(
   SigBasisChanged,
@@ -189,8 +190,113 @@ bool SignatureGB::processSPair
   return true;
 }
 
+auto SignatureGB::popSignature(SigSPairs::PairContainer& pairs) -> Mono {
+  bool announced;
+  auto sig = popNext(pairs, announced);
+  if (!sig.isNull() && !announced)
+    reduceAhead(*sig);
+  return sig;
+}
+
+auto SignatureGB::popNext(
+  SigSPairs::PairContainer& pairs,
+  bool& announced
+) -> Mono {
+  auto sig = SP->popSignature(pairs);
+  announced = false;
+
+  // New S-pairs can have smaller signature than the signatures that were
+  // popped ahead of time, so take the smallest of both.
+  if (
+    !mAhead.empty() &&
+    (sig.isNull() || !monoid().lessThan(*sig, *mAhead.front().sig))
+  ) {
+    if (!sig.isNull())
+      pushAhead(std::move(sig), pairs, false);
+    auto& next = mAhead.front();
+    sig = std::move(next.sig);
+    pairs = std::move(next.pairs);
+    announced = next.announced;
+    mAhead.pop_front();
+  }
+  return sig;
+}
+
+void SignatureGB::reduceAhead(ConstMonoRef sig) {
+  const auto setSize = reducer->preferredSetSize();
+  if (setSize <= 1)
+    return;
+
+  // The signature that ends the loop is put back without being announced.
+  const auto degree = monoid().degree(sig);
+  std::vector<AheadSignature> popped;
+  for (size_t count = 1; count < setSize; ++count) {
+    AheadSignature ahead;
+    ahead.sig = popNext(ahead.pairs, ahead.announced);
+    if (ahead.sig.isNull())
+      break;
+    const bool take =
+      !ahead.announced && monoid().degree(*ahead.sig) == degree;
+    ahead.announced = ahead.announced || take;
+    popped.push_back(std::move(ahead));
+    if (!take)
+      break;
+  }
+
+  // Signatures that are already known to be syzygies will be eliminated by
+  // the signature criterion, so there is no reason to reduce them.
+  std::vector<ConstMonoPtr> sigs;
+  std::vector<Mono> multiples;
+  std::vector<ConstMonoPtr> multiplePtrs;
+  std::vector<size_t> gens;
+  const auto add = [&](ConstMonoRef aheadSig) {
+    if (Hsyz->member(aheadSig))
+      return;
+    const auto gen = GB->minimalLeadInSig(aheadSig);
+    if (gen == static_cast<size_t>(-1))
+      return;
+    auto multiple = monoid().alloc();
+    monoid().divide(GB->signature(gen), aheadSig, *multiple);
+    sigs.push_back(aheadSig.ptr());
+    multiplePtrs.push_back(multiple.ptr());
+    multiples.push_back(std::move(multiple));
+    gens.push_back(gen);
+  };
+  add(sig);
+  for (size_t i = 0; i < popped.size(); ++i)
+    if (i + 1 < popped.size() || popped.back().announced)
+      add(*popped[i].sig);
+  if (sigs.size() > 1)
+    reducer->regularReduceAhead(sigs, multiplePtrs, gens, *GB);
+
+  for (auto& ahead : popped)
+    pushAhead(std::move(ahead.sig), ahead.pairs, ahead.announced);
+}
+
+void SignatureGB::pushAhead(
+  Mono sig,
+  const SigSPairs::PairContainer& pairs,
+  const bool announced
+) {
+  const auto pos = std::lower_bound(mAhead.begin(), mAhead.end(), sig,
+    [&](const AheadSignature& a, const Mono& b) {
+      return monoid().lessThan(*a.sig, *b);
+    }
+  );
+  if (pos != mAhead.end() && monoid().equal(*pos->sig, *sig)) {
+    // SP would have given the pairs of this signature together.
+    pos->pairs.insert(pos->pairs.end(), pairs.begin(), pairs.end());
+    return;
+  }
+  AheadSignature ahead;
+  ahead.sig = std::move(sig);
+  ahead.pairs = pairs;
+  ahead.announced = announced;
+  mAhead.insert(pos, std::move(ahead));
+}
+
 bool SignatureGB::step() {
-  auto sig = SP->popSignature(mSpairTmp);
+  auto sig = popSignature(mSpairTmp);
   if (sig.isNull())
     return false;
   ++stats_sPairSignaturesDone;
@@ -12,6 +12,7 @@
 #include "SPairs.hpp"
 #include "MonoProcessor.hpp"
 #include <map>
+#include <deque>
 
 MATHICGB_NAMESPACE_BEGIN
 
@@ -71,6 +72,39 @@ private:
   bool processSPair(Mono sig, const SigSPairs::PairContainer& pairs);
   bool step();
 
+  /// Pops the minimal signature that has not been processed yet and sets
+  /// pairs to its S-pairs. Returns null if there are none. Calls reduceAhead
+  /// for the popped signature if its reduction has not been announced yet.
+  Mono popSignature(SigSPairs::PairContainer& pairs);
+
+  /// As popSignature, but never calls reduceAhead. Sets announced to true if
+  /// reduceAhead has announced the reduction of the popped signature.
+  Mono popNext(SigSPairs::PairContainer& pairs, bool& announced);
+
+  /// Pops the following signatures of the same degree as sig that have not
+  /// been announced yet into mAhead and announces the reductions for all of
+  /// them, including sig, to the reducer, so that it can do those reductions
+  /// together.
+  void reduceAhead(ConstMonoRef sig);
+
+  /// Puts sig and its S-pairs pairs into mAhead. If sig is already there,
+  /// pairs are added to its S-pairs.
+  void pushAhead(
+    Mono sig,
+    const SigSPairs::PairContainer& pairs,
+    bool announced
+  );
+
+  struct AheadSignature {
+    Mono sig;
+    SigSPairs::PairContainer pairs;
+    bool announced; // true if reduceAhead announced its reduction
+  };
+
+  /// Signatures that were popped from SP ahead of time, sorted by
+  /// increasing signature.
+  std::deque<AheadSignature> mAhead;
+
   const PolyRing *R;
 
   bool const mPostponeKoszul;
@@ -0,0 +1,110 @@
+// MathicGB copyright 2012 all rights reserved. MathicGB comes with ABSOLUTELY
+// NO WARRANTY and is licensed as GPL v2.0 or later - see LICENSE.txt.
+#include "stdinc.h"
+#include "TimeTrace.hpp"
+
+#include "mtbb.hpp"
+#include "CFile.hpp"
+#include <vector>
+#include <cstdio>
+
+MATHICGB_NAMESPACE_BEGIN
+
+std::atomic<bool> TimeTrace::sEnabled(false);
+
+namespace {
+  struct RecordedRegion {
+    const char* name;
+    TimeTrace::Time begin;
+    TimeTrace::Time end;
+  };
+
+  struct ThreadRegions {
+    size_t thread;
+    std::vector<RecordedRegion> regions;
+  };
+
+  struct TraceData {
+    TraceData():
+      threadCount(0),
+      threadRegions([this]() {
+        mgb::mtbb::mutex::scoped_lock lockGuard(lock);
+        ThreadRegions regions;
+        regions.thread = threadCount;
+        ++threadCount;
+        return regions;
+      })
+    {}
+
+    std::string fileName;
+    mgb::mtbb::tick_count startTime;
+    mgb::mtbb::mutex lock;
+    size_t threadCount;
+    mgb::mtbb::enumerable_thread_specific<ThreadRegions> threadRegions;
+  };
+
+  TraceData& traceData() {
+    static TraceData data;
+    return data;
+  }
+}
+
+void TimeTrace::start(std::string fileName) {
+  auto& data = traceData();
+  data.threadRegions.clear();
+  data.threadCount = 0;
+  data.fileName = std::move(fileName);
+  data.startTime = mgb::mtbb::tick_count::now();
+  sEnabled.store(true, std::memory_order_relaxed);
+}
+
+void TimeTrace::stop() {
+  sEnabled.store(false, std::memory_order_relaxed);
+  traceData().threadRegions.clear();
+}
+
+void TimeTrace::finish() {
+  if (!enabled())
+    return;
+  auto& data = traceData();
+  CFile file(data.fileName, "w");
+  const auto out = file.handle();
+
+  // Times are in microseconds in the Chrome trace event format. The
+  // regions of a thread are properly nested, so complete events ("ph":"X")
+  // are enough.
+  std::fputs("{\"traceEvents\":[", out);
+  const char* separator = "\n";
+  for (const auto& thread : data.threadRegions) {
+    const auto tid = static_cast<unsigned long>(thread.thread);
+    std::fprintf(out, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,"
+      "\"tid\":%lu,\"args\":{\"name\":\"thread %lu\"}}", separator, tid, tid);
+    separator = ",\n";
+    for (const auto& region : thread.regions) {
+      std::fprintf(out, "%s{\"name\":\"%s\",\"cat\":\"mathicgb\",\"ph\":\"X\","
+        "\"pid\":1,\"tid\":%lu,\"ts\":%.3f,\"dur\":%.3f}",
+        separator,
+        region.name,
+        tid,
+        region.begin * 1e6,
+        (region.end - region.begin) * 1e6
+      );
+    }
+  }
+  std::fputs("\n],\"displayTimeUnit\":\"ms\"}\n", out);
+  stop();
+}
+
+auto TimeTrace::now() -> Time {
+  MATHICGB_ASSERT(enabled());
+  return (mgb::mtbb::tick_count::now() - traceData().startTime).seconds();
+}
+
+void TimeTrace::record(const char* name, const Time begin, const Time end) {
+  MATHICGB_ASSERT(enabled());
+  MATHICGB_ASSERT(name != nullptr);
+  const RecordedRegion region = {name, begin, end};
+  traceData().threadRegions.local().regions.push_back(region);
+}
+
+MATHICGB_NAMESPACE_END
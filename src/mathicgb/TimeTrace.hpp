@@ -0,0 +1,75 @@
+// MathicGB copyright 2012 all rights reserved. MathicGB comes with ABSOLUTELY
+// NO WARRANTY and is licensed as GPL v2.0 or later - see LICENSE.txt.
+#ifndef MATHICGB_TIME_TRACE_GUARD
+#define MATHICGB_TIME_TRACE_GUARD
+
+#include <string>
+#include <atomic>
+
+MATHICGB_NAMESPACE_BEGIN
+
+/// Records when each thread was in which timed region, so that the
+/// timeline of a computation can be looked at in chrome://tracing or in
+/// Perfetto. The regions are the timers of the log domains and the chunks
+/// of mtbb::parallel_for. Tracing is turned on with the log command
+/// trace=FILE, see LogDomainSet::performLogCommand.
+///
+/// Each thread appends its regions to its own buffer, so recording a
+/// region takes two reads of the clock and an append to a vector. When
+/// tracing is off, it takes a check of a bool. The buffers grow for as
+/// long as tracing is on, using 24 bytes per region.
+class TimeTrace {
+public:
+  /// Seconds since tracing was turned on.
+  typedef double Time;
+
+  static bool enabled() {return sEnabled.load(std::memory_order_relaxed);}
+
+  /// Turns tracing on and forgets any regions recorded before. The trace
+  /// is written to fileName by finish().
+  static void start(std::string fileName);
+
+  /// Turns tracing off and forgets the recorded regions.
+  static void stop();
+
+  /// If tracing is on, writes the recorded regions to the file given to
+  /// start() in the Chrome trace event format and then calls stop().
+  static void finish();
+
+  /// Returns the current time. Only call this while tracing is on.
+  static Time now();
+
+  /// Records that the calling thread was in the region name from begin to
+  /// end. name must stay valid until the trace has been written, and it
+  /// must not contain characters that need escaping in JSON. Only call
+  /// this while tracing is on.
+  static void record(const char* name, Time begin, Time end);
+
+  /// Records the region from construction to destruction if tracing is on
+  /// at construction.
+  class Region {
+  public:
+    Region(const char* name):
+      mName(name),
+      mTracing(enabled()),
+      mBegin(mTracing ? now() : 0)
+    {}
+
+    ~Region() {
+      if (mTracing && enabled())
+        record(mName, mBegin, now());
+    }
+
+  private:
+    const char* const mName;
+    const bool mTracing;
+    const Time mBegin;
+  };
+
+private:
+  /// Written by start() and stop() and read by every thread.
+  static std::atomic<bool> sEnabled;
+};
+
+MATHICGB_NAMESPACE_END
+#endif
@@ -160,6 +160,20 @@ void TypicalReducer::classicReducePolySet
   }  
 }
 
+void TypicalReducer::classicTailReduceBasis(
+  const PolyBasis& basis,
+  std::vector<std::unique_ptr<Poly>>& reducedOut
+) {
+  reducedOut.clear();
+  reducedOut.resize(basis.size());
+  for (size_t i = 0; i < basis.size(); ++i) {
+    if (basis.retired(i))
+      continue;
+    reducedOut[i] = classicTailReduce(basis.poly(i), basis);
+    reducedOut[i]->makeMonic();
+  }
+}
+
 void TypicalReducer::setMemoryQuantum(size_t quantum) {
 }
 
@@ -53,6 +53,11 @@ public:
     std::vector<std::unique_ptr<Poly> >& reducedOut
   );
 
+  virtual void classicTailReduceBasis(
+    const PolyBasis& basis,
+    std::vector<std::unique_ptr<Poly>>& reducedOut
+  );
+
   virtual void setMemoryQuantum(size_t quantum);
 
 protected:
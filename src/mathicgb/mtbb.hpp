@@ -3,6 +3,8 @@
 #ifndef MATHICGB_M_TBB_GUARD
 #define MATHICGB_M_TBB_GUARD
 
+#include "TimeTrace.hpp"
+
 #ifndef MATHICGB_NO_TBB
 #include <tbb/tbb.h>
 
@@ -15,17 +17,37 @@ MATHICGB_NAMESPACE_BEGIN
 /// without tbb being present. TBB doesn't work on Cygwin, so that is at least
 /// one good reason to have this compatibility layer. This only works if all
 /// uses of tbb go through mtbb, so make sure to do that.
+///
+/// Each call of the body of parallel_for is recorded as a region in the
+/// TimeTrace if tracing is on.
 
 namespace mtbb {
   using ::tbb::task_scheduler_init;
+  using ::tbb::task_arena;
   using ::tbb::mutex;
+  using ::tbb::queuing_rw_mutex;
   using ::tbb::parallel_do_feeder;
   using ::tbb::enumerable_thread_specific;
   using ::tbb::parallel_do;
-  using ::tbb::parallel_for;
   using ::tbb::parallel_sort;
   using ::tbb::blocked_range;
   using ::tbb::tick_count;
+
+  template<class Range, class Func>
+  void parallel_for(const Range& range, const Func& f) {
+    ::tbb::parallel_for(range, [&](const Range& subRange) {
+      TimeTrace::Region region("parallel_for");
+      f(subRange);
+    });
+  }
+
+  template<class Index, class Func>
+  void parallel_for(Index begin, Index end, Index step, const Func& f) {
+    ::tbb::parallel_for(begin, end, step, [&](const Index i) {
+      TimeTrace::Region region("parallel_for");
+      f(i);
+    });
+  }
 }
 
 MATHICGB_NAMESPACE_END
@@ -46,6 +68,17 @@ namespace mtbb {
     static const int automatic = 1;
   };
 
+  class task_arena {
+  public:
+    task_arena(int) {}
+    static const int automatic = -1;
+
+    void initialize() {}
+
+    template<class F>
+    void execute(const F& f) {f();}
+  };
+
   class mutex {
   public:
     mutex(): mLocked(false) {}
@@ -103,6 +136,44 @@ namespace mtbb {
     bool mLocked;
   };
 
+  class queuing_rw_mutex {
+  public:
+    queuing_rw_mutex(): mReaderCount(0), mWriting(false) {}
+
+    class scoped_lock {
+    public:
+      scoped_lock(queuing_rw_mutex& m, bool write = true):
+        mMutex(m),
+        mWrite(write)
+      {
+        MATHICGB_ASSERT(!mMutex.mWriting); // deadlock
+        if (mWrite) {
+          MATHICGB_ASSERT(mMutex.mReaderCount == 0); // deadlock
+          mMutex.mWriting = true;
+        } else
+          ++mMutex.mReaderCount;
+      }
+
+      ~scoped_lock() {
+        if (mWrite) {
+          MATHICGB_ASSERT(mMutex.mWriting);
+          mMutex.mWriting = false;
+        } else {
+          MATHICGB_ASSERT(mMutex.mReaderCount > 0);
+          --mMutex.mReaderCount;
+        }
+      }
+
+    private:
+      queuing_rw_mutex& mMutex;
+      const bool mWrite;
+    };
+
+  private:
+    size_t mReaderCount;
+    bool mWriting;
+  };
+
   template<class T>
   class enumerable_thread_specific {
   public:
@@ -166,13 +237,16 @@ namespace mtbb {
     
   template<class Range, class Func>
   void parallel_for(Range&& range, Func&& f) {
+    TimeTrace::Region region("parallel_for");
     f(range);
   }
 
   template<class Index, class Func>
   void parallel_for(Index begin, Index end, Index step, Func&& f) {
-    for (auto i = begin; i < end; i += step)
+    for (auto i = begin; i < end; i += step) {
+      TimeTrace::Region region("parallel_for");
       f(i);
+    }
   }
 
   template<class T>
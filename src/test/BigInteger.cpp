@@ -0,0 +1,74 @@
+// MathicGB copyright 2012 all rights reserved. MathicGB comes with ABSOLUTELY
+// NO WARRANTY and is licensed as GPL v2.0 or later - see LICENSE.txt.
+#include "mathicgb/stdinc.h"
+#include "mathicgb/BigInteger.hpp"
+
+#include <gtest/gtest.h>
+#include <limits>
+
+using namespace mgb;
+
+namespace {
+  BigInteger big(const char* text) {return BigInteger::fromString(text);}
+}
+
+TEST(BigInteger, ToAndFromString) {
+  EXPECT_EQ("0", BigInteger().toString());
+  EXPECT_EQ("0", big("-0").toString());
+  EXPECT_EQ("0", big("000").toString());
+  EXPECT_EQ("-17", BigInteger(-17).toString());
+  EXPECT_EQ("1000000000", BigInteger(1000000000).toString());
+  EXPECT_EQ("-9223372036854775808",
+    BigInteger(std::numeric_limits<int64>::min()).toString());
+  const char* const large = "-123456789012345678901234567890000000001";
+  EXPECT_EQ(large, big(large).toString());
+  EXPECT_TRUE(big(large).isNegative());
+  EXPECT_FALSE(big("-0").isNegative());
+}
+
+TEST(BigInteger, Arithmetic) {
+  const auto a = big("340282366920938463463374607431768211456"); // 2^128
+  const auto b = big("-18446744073709551617"); // -(2^64 + 1)
+  EXPECT_EQ("340282366920938463444927863358058659839", (a + b).toString());
+  EXPECT_EQ("340282366920938463481821351505477763073", (a - b).toString());
+  EXPECT_EQ("-340282366920938463481821351505477763073", (b - a).toString());
+  EXPECT_EQ("-6277101735386680764176071790128604879565730051895802724352",
+    (a * b).toString());
+  EXPECT_EQ(BigInteger(), a - a);
+  EXPECT_FALSE((b - b).isNegative());
+  EXPECT_TRUE(b < a);
+  EXPECT_TRUE(-a < b);
+  EXPECT_TRUE(a <= a);
+  EXPECT_TRUE(a != b);
+
+  // The remainder has the sign of the dividend as for the built-in types.
+  const int64 values[] = {0, 1, 7, -7, 100, -100, 4294967296, -4294967297};
+  for (const auto x : values) {
+    for (const auto y : values) {
+      if (y == 0)
+        continue;
+      BigInteger quotient;
+      BigInteger remainder;
+      BigInteger::divide(BigInteger(x), BigInteger(y), quotient, remainder);
+      EXPECT_EQ(BigInteger(x / y), quotient) << x << " / " << y;
+      EXPECT_EQ(BigInteger(x % y), remainder) << x << " % " << y;
+    }
+  }
+  BigInteger quotient;
+  BigInteger remainder;
+  BigInteger::divide(a * a + BigInteger(5), b, quotient, remainder);
+  EXPECT_EQ(a * a + BigInteger(5), quotient * b + remainder);
+  EXPECT_TRUE(remainder < -b);
+  EXPECT_FALSE(remainder.isNegative());
+}
+
+TEST(BigInteger, Residue) {
+  EXPECT_EQ(0u, BigInteger().residue(7));
+  EXPECT_EQ(4u, BigInteger(-3).residue(7));
+  EXPECT_EQ(0u, BigInteger(-14).residue(7));
+  // 2^128 - 1 is divisible by 65537 and by 2^32 - 1.
+  const auto a = big("340282366920938463463374607431768211456");
+  EXPECT_EQ(1u, a.residue(65537));
+  EXPECT_EQ(65536u, (-a).residue(65537));
+  EXPECT_EQ(1u, a.residue(4294967295u));
+}
@@ -125,4 +125,112 @@ TEST(F4MatrixReducer, Reduce) {
     "1: 1#1 3#66 4#34\n";
   reduced.sortRowsByIncreasingPivots();
   ASSERT_EQ(redStr, reduced.toString()) << "Printed reduced:\n" << reduced;
+
+  // The out-of-core reduction must give the same answer, including when its
+  // window is so small that it handles one row at a time.
+  for (size_t window = 1; window <= 1000 * 1000; window *= 10) {
+    QuadMatrix copy(*ring);
+    copy.topLeft = m.topLeft;
+    copy.topRight = m.topRight;
+    copy.bottomLeft = m.bottomLeft;
+    copy.bottomRight = m.bottomRight;
+    copy.leftColumnMonomials = m.leftColumnMonomials;
+    copy.rightColumnMonomials = m.rightColumnMonomials;
+    SparseMatrix outOfCore(F4MatrixReducer(ring->charac()).
+      reducedRowEchelonFormBottomRightOutOfCore(copy, window));
+    ASSERT_EQ(0u, copy.topLeft.rowCount());
+    ASSERT_EQ(0u, copy.bottomRight.rowCount());
+    outOfCore.sortRowsByIncreasingPivots();
+    ASSERT_EQ(redStr, outOfCore.toString()) << "window " << window;
+  }
+
+  SparseMatrix probabilistic(F4MatrixReducer(ring->charac()).
+    reducedRowEchelonFormBottomRightProbabilistic(m));
+  probabilistic.sortRowsByIncreasingPivots();
+  ASSERT_EQ(redStr, probabilistic.toString());
+}
+
+namespace {
+  // Most bottom rows are linear combinations of top rows, so they reduce to
+  // zero. The others add a different unit vector on the right, so there
+  // are exactly as many new pivots as there are such rows.
+  void testReduceProbabilistic(const SparseMatrix::Scalar modulus) {
+    const SparseMatrix::ColIndex leftColCount = 20;
+    const SparseMatrix::ColIndex rightColCount = 30;
+    const size_t bottomRowCount = 300;
+    const size_t newPivotCount = 5;
+
+    std::ostringstream ringString;
+    ringString << modulus << " 6 1\n10 1 1 1 1 1";
+    auto ring = ringFromString(ringString.str());
+    QuadMatrix m(*ring);
+    unsigned int state = 1;
+    auto random = [&](unsigned int bound) {
+      state = state * 1103515245 + 12345;
+      return (state >> 16) % bound;
+    };
+
+    std::vector<std::vector<unsigned int>> top;
+    for (SparseMatrix::ColIndex row = 0; row < leftColCount; ++row) {
+      std::vector<unsigned int> dense(leftColCount + rightColCount);
+      dense[row] = 1;
+      for (auto col = row + 1; col < dense.size(); ++col)
+        if (random(3) == 0)
+          dense[col] = random(modulus);
+      top.push_back(dense);
+    }
+    auto appendRow = [&](const std::vector<unsigned int>& dense, bool isTop) {
+      auto& left = isTop ? m.topLeft : m.bottomLeft;
+      auto& right = isTop ? m.topRight : m.bottomRight;
+      for (SparseMatrix::ColIndex col = 0; col < dense.size(); ++col) {
+        const auto entry = static_cast<SparseMatrix::Scalar>(dense[col]);
+        if (entry == 0)
+          continue;
+        if (col < leftColCount)
+          left.appendEntry(col, entry);
+        else
+          right.appendEntry(col - leftColCount, entry);
+      }
+      left.rowDone();
+      right.rowDone();
+    };
+    for (const auto& row : top)
+      appendRow(row, true);
+
+    for (size_t row = 0; row < bottomRowCount; ++row) {
+      std::vector<unsigned int> dense(leftColCount + rightColCount);
+      for (size_t i = 0; i < 3; ++i) {
+        const auto& topRow = top[random(leftColCount)];
+        const auto multiple = random(modulus);
+        for (size_t col = 0; col < dense.size(); ++col)
+          dense[col] = (dense[col] + multiple * topRow[col]) % modulus;
+      }
+      const auto spacing = bottomRowCount / newPivotCount;
+      if (row % spacing == 7) {
+        const auto col = leftColCount + 2 * (row / spacing);
+        dense[col] = (dense[col] + 1) % modulus;
+      }
+      appendRow(dense, false);
+    }
+    MATHICGB_ASSERT(m.debugAssertValid());
+
+    F4MatrixReducer reducer(modulus);
+    SparseMatrix reduced(reducer.reducedRowEchelonFormBottomRight(m));
+    SparseMatrix probabilistic
+      (reducer.reducedRowEchelonFormBottomRightProbabilistic(m));
+    ASSERT_EQ(newPivotCount, reduced.rowCount());
+    reduced.sortRowsByIncreasingPivots();
+    probabilistic.sortRowsByIncreasingPivots();
+    ASSERT_EQ(reduced.toString(), probabilistic.toString());
+  }
+}
+
+TEST(F4MatrixReducer, ReduceProbabilistic) {
+  // 2 and 3 are below F4MatrixReducer::MinProbabilisticModulus, 67 is just
+  // above it.
+  testReduceProbabilistic(2);
+  testReduceProbabilistic(3);
+  testReduceProbabilistic(67);
+  testReduceProbabilistic(101);
+  testReduceProbabilistic(32003);
 }
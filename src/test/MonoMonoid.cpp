@@ -209,6 +209,24 @@ TYPED_TEST(Monoids, MonoArena) {
   Monoid monoid(15);
   Arena a(monoid);
   a.push_back();
+  ASSERT_FALSE(a.empty());
+  ASSERT_TRUE(monoid.isIdentity(a.front()));
+
+  // References stay valid as the arena grows and when it is moved.
+  auto mono = monoid.alloc();
+  std::vector<typename Monoid::ConstMonoPtr> ptrs;
+  for (size_t i = 0; i < 1000; ++i) {
+    monoid.setExponent(0, static_cast<typename Monoid::Exponent>(i % 100), *mono);
+    a.push_back(*mono);
+    ptrs.push_back(a.back().ptr());
+  }
+  std::vector<Arena> arenas;
+  arenas.push_back(std::move(a));
+  arenas.emplace_back(monoid);
+  arenas.emplace_back(monoid);
+  ASSERT_EQ(1001, arenas.front().size());
+  for (size_t i = 0; i < ptrs.size(); ++i)
+    ASSERT_EQ(i % 100, monoid.exponent(*ptrs[i], 0));
   return;
 
   testMonoVector<Monoid, MonoArena<Monoid>>();
@@ -332,6 +350,52 @@ TYPED_TEST(Monoids, MonoPool) {
   }
 }
 
+TYPED_TEST(Monoids, MonoPoolConcurrent) {
+  typedef TypeParam Monoid;
+  typedef typename Monoid::MonoPtr MonoPtr;
+
+  Monoid monoid(5);
+  typename Monoid::MonoPool pool(monoid);
+
+  // Each chunk allocates a batch of monomials and frees every other one
+  // right away. The rest are freed afterwards, typically by another thread.
+  const size_t chunkCount = 64;
+  const size_t perChunk = 300;
+  std::vector<MonoPtr> kept(chunkCount * perChunk);
+  mgb::mtbb::parallel_for(
+    mgb::mtbb::blocked_range<size_t>(0, chunkCount),
+    [&](const mgb::mtbb::blocked_range<size_t>& range) {
+      for (auto chunk = range.begin(); chunk != range.end(); ++chunk) {
+        for (size_t i = 0; i < perChunk; ++i) {
+          auto mono = pool.alloc();
+          ASSERT_TRUE(monoid.isIdentity(*mono));
+          const auto index = chunk * perChunk + i;
+          monoid.setExponent(0, static_cast<typename Monoid::Exponent>(
+            index % 100), *mono);
+          if (i % 2 == 0)
+            pool.free(std::move(mono));
+          else
+            kept[index] = mono.release();
+        }
+      }
+    }
+  );
+  for (size_t i = 0; i < kept.size(); ++i) {
+    if (i % 2 == 1) {
+      ASSERT_TRUE(pool.fromPool(*kept[i]));
+      ASSERT_EQ(i % 100, monoid.exponent(*kept[i], 0));
+    }
+  }
+  mgb::mtbb::parallel_for(
+    mgb::mtbb::blocked_range<size_t>(0, kept.size()),
+    [&](const mgb::mtbb::blocked_range<size_t>& range) {
+      for (auto i = range.begin(); i != range.end(); ++i)
+        if (!kept[i].isNull())
+          pool.freeRaw(*kept[i]);
+    }
+  );
+}
+
 namespace {
   template<class M>
   typename M::MonoVector parseVector(
@@ -9,6 +9,9 @@
 #include "mathicgb/SigPolyBasis.hpp"
 #include "mathicgb/SignatureGB.hpp"
 #include "mathicgb/ClassicGBAlg.hpp"
+#include "mathicgb/ClassicGBTrace.hpp"
+#include "mathicgb/MemoryAccount.hpp"
+#include "mathicgb/MultiModularGB.hpp"
 #include "mathicgb/mtbb.hpp"
 #include "mathicgb/MathicIO.hpp"
 #include "mathicgb/Scanner.hpp"
@@ -152,6 +155,12 @@ spairQueue	reducerType	divLookup	monTable	buchberger	postponeKoszul	useBaseDivis
 2	18	1	1	1	0	0	0	1	0	0	10	1
 3	16	2	3	1	0	0	1	1	1	0	10	8
 2	20	4	1	0	1	1	0	0	0	1	10	8
+0	27	2	1	1	0	0	1	1	0	0	10	2
+1	28	3	2	0	1	1	0	0	1	1	0	1
+2	29	4	3	1	0	0	0	1	1	0	100	8
+3	30	1	4	0	0	1	0	0	0	1	2	2
+0	31	2	2	1	0	0	1	0	0	0	1	1
+1	32	3	3	0	1	0	0	0	1	1	10	8
 );
   std::istringstream tests(allPairsTests);
   // skip the initial line with the parameter names.
@@ -188,7 +197,7 @@ spairQueue	reducerType	divLookup	monTable	buchberger	postponeKoszul	useBaseDivis
 
     int reducerType;
     tests >> reducerType;
-    MATHICGB_ASSERT(0 <= reducerType && reducerType <= 30);
+    MATHICGB_ASSERT(0 <= reducerType && reducerType <= 32);
 
     int divLookup;
     tests >> divLookup;
@@ -276,8 +285,15 @@ spairQueue	reducerType	divLookup	monTable	buchberger	postponeKoszul	useBaseDivis
       params.printInterval = 0;
       params.sPairGroupSize = sPairGroupSize;
       params.reducerMemoryQuantum = 100 * 1024;
+      params.memoryBudget = 0;
       params.useAutoTopReduction = autoTopReduce;
       params.useAutoTailReduction = autoTailReduce;
+      params.useSugar = false;
+      params.useFinalInterreduction = false;
+      params.checkpointInterval = 0;
+      params.resumeFromCheckpoint = false;
+      params.recordTrace = nullptr;
+      params.replayTrace = nullptr;
       params.callback = nullptr;
 
       auto gb = computeGBClassicAlg(std::move(basis), params);
@@ -380,3 +396,295 @@ TEST(GB, gerdt93_0_7) {
   testGB(gerdt93IdealComponentFirst(false), gerdt93_gb_strat0_free7,
          gerdt93_syzygies_strat0_free7, gerdt93_initial_strat0_free7, 9);
 }
+
+namespace {
+  // Checks that the signature basis algorithm gives the expected
+  // signature basis and syzygies with the given reducer and module
+  // monomial set types.
+  void testSigGB(
+    std::string idealStr,
+    std::string sigBasisStr,
+    std::string syzygiesStr,
+    Reducer::ReducerType reducerType,
+    int monTable
+  ) {
+    std::istringstream inStream(idealStr);
+    Scanner in(inStream);
+    auto p = MathicIO<>().readRing(true, in);
+    auto& ring = *p.first;
+    auto& processor = p.second;
+    auto basis = MathicIO<>().readBasis(ring, false, in);
+    if (processor.schreyering())
+      processor.setSchreyerMultipliers(basis);
+
+    SignatureGB alg(
+      std::move(basis),
+      std::move(processor),
+      reducerType,
+      2, // divLookup
+      monTable,
+      false, // postponeKoszul
+      false, // useBaseDivisors
+      false, // preferSparseReducers
+      false, // useSingularCriterionEarly
+      0 // spairQueue
+    );
+    alg.computeGrobnerBasis();
+    EXPECT_EQ(sigBasisStr, toString(alg.getGB(), 1));
+    EXPECT_EQ(syzygiesStr, toString(alg.getSyzTable()));
+  }
+}
+
+TEST(GB, sigF4Reducer) {
+  const auto red = Reducer::Reducer_F4_New;
+  testSigGB(smallIdealComponentLastDescending(),
+    idealSmallBasis, idealSmallSyzygies, red, 2);
+  testSigGB(liuIdealComponentLastDescending(),
+    liu_gb_strat0_free1, liu_syzygies_strat0_free1, red, 2);
+  testSigGB(weispfennig97IdealComponentLast(true),
+    weispfennig97_gb_strat0_free4, weispfennig97_syzygies_strat0_free4, red, 2);
+  testSigGB(gerdt93IdealComponentMiddle(true),
+    gerdt93_gb_strat0_free2, gerdt93_syzygies_strat0_free2, red, 2);
+}
+
+TEST(GB, sigDegreeModuleMonoSet) {
+  const auto red = Reducer::Reducer_Geobucket_Hashed;
+  testSigGB(smallIdealComponentLastDescending(),
+    idealSmallBasis, idealSmallSyzygies, red, 5);
+  testSigGB(liuIdealComponentLastDescending(),
+    liu_gb_strat0_free1, liu_syzygies_strat0_free1, red, 5);
+  testSigGB(weispfennig97IdealComponentLast(false),
+    weispfennig97_gb_strat0_free5, weispfennig97_syzygies_strat0_free5, red, 5);
+  testSigGB(gerdt93IdealComponentFirst(false),
+    gerdt93_gb_strat0_free7, gerdt93_syzygies_strat0_free7, red, 5);
+}
+
+namespace {
+  std::string classicGB(
+    const std::string& idealStr,
+    ClassicGBTrace* recordTrace,
+    const ClassicGBTrace* replayTrace,
+    bool useSugar,
+    size_t memoryBudget = 0
+  ) {
+    std::istringstream inStream(idealStr);
+    Scanner in(inStream);
+    auto p = MathicIO<>().readRing(true, in);
+    auto& ring = *p.first;
+    auto basis = MathicIO<>().readBasis(ring, false, in);
+    const auto reducer = Reducer::makeReducer(Reducer::Reducer_F4_New, ring);
+
+    ClassicGBAlgParams params;
+    params.reducer = reducer.get();
+    params.monoLookupType = 2;
+    params.preferSparseReducers = true;
+    params.sPairQueueType = 0;
+    params.breakAfter = 0;
+    params.printInterval = 0;
+    params.sPairGroupSize = 0;
+    params.reducerMemoryQuantum = 100 * 1024;
+    params.memoryBudget = memoryBudget;
+    params.useAutoTopReduction = true;
+    params.useAutoTailReduction = false;
+    params.useSugar = useSugar;
+    params.useFinalInterreduction = true;
+    params.checkpointInterval = 0;
+    params.resumeFromCheckpoint = false;
+    params.recordTrace = recordTrace;
+    params.replayTrace = replayTrace;
+    params.callback = nullptr;
+    auto gb = computeGBClassicAlg(std::move(basis), params);
+    gb.sort();
+    return toString(&gb);
+  }
+}
+
+TEST(GB, classicTraceReplay) {
+  const auto ideal = weispfennig97IdealComponentLast(true);
+  ClassicGBTrace recorded;
+  const auto gb = classicGB(ideal, &recorded, nullptr, false);
+  ASSERT_EQ(recorded.groupEnds.size(), recorded.matrixPlans.size());
+  size_t planColumnCount = 0;
+  size_t zeroRowCount = 0;
+  for (const auto& plan : recorded.matrixPlans) {
+    planColumnCount += plan.reducers.size();
+    zeroRowCount += plan.zeroRowPolys.size();
+  }
+  EXPECT_LT(0u, planColumnCount);
+  EXPECT_LT(0u, zeroRowCount);
+
+  const char* const fileName = "classicTraceReplay.trace";
+  recorded.write(fileName);
+  ClassicGBTrace read;
+  read.read(fileName);
+  std::remove(fileName);
+  EXPECT_EQ(recorded.pairs, read.pairs);
+  EXPECT_EQ(recorded.groupEnds, read.groupEnds);
+  EXPECT_EQ(recorded.nonZeroCounts, read.nonZeroCounts);
+  ASSERT_EQ(recorded.matrixPlans.size(), read.matrixPlans.size());
+  for (size_t i = 0; i < read.matrixPlans.size(); ++i) {
+    EXPECT_EQ(recorded.matrixPlans[i].monomials, read.matrixPlans[i].monomials);
+    EXPECT_EQ(recorded.matrixPlans[i].reducers, read.matrixPlans[i].reducers);
+    EXPECT_EQ(
+      recorded.matrixPlans[i].zeroRowPolys,
+      read.matrixPlans[i].zeroRowPolys
+    );
+    EXPECT_EQ(
+      recorded.matrixPlans[i].zeroRowLeads,
+      read.matrixPlans[i].zeroRowLeads
+    );
+  }
+
+  EXPECT_EQ(gb, classicGB(ideal, nullptr, &read, false));
+}
+
+TEST(GB, classicMemoryBudget) {
+  // A budget of 1 byte is always exceeded, so the computation ends up
+  // reducing one S-pair at a time, which must not change the result.
+  const std::string ideals[] = {
+    liuIdealComponentLastDescending(),
+    weispfennig97IdealComponentLast(true)
+  };
+  for (const auto& ideal : ideals) {
+    EXPECT_EQ(
+      classicGB(ideal, nullptr, nullptr, false),
+      classicGB(ideal, nullptr, nullptr, false, 1)
+    );
+  }
+}
+
+TEST(GB, MemoryAccount) {
+  MemoryAccount account(100);
+  account.setUse(MemoryAccount::BasisMemory, 30);
+  account.setUse(MemoryAccount::SPairMemory, 20);
+  EXPECT_EQ(50u, account.totalUse());
+  EXPECT_FALSE(account.takeBudgetExceeded());
+
+  account.noteTransientUse(MemoryAccount::F4MatrixBuildMemory, 40);
+  account.noteTransientUse(MemoryAccount::F4ReductionMemory, 20, 40);
+  EXPECT_EQ(0u, account.use(MemoryAccount::F4ReductionMemory));
+  EXPECT_EQ(20u, account.peakUse(MemoryAccount::F4ReductionMemory));
+  EXPECT_EQ(110u, account.peakTotalUse());
+  EXPECT_TRUE(account.takeBudgetExceeded());
+  EXPECT_FALSE(account.takeBudgetExceeded());
+
+  account.setUse(MemoryAccount::BasisMemory, 10);
+  EXPECT_EQ(30u, account.totalUse());
+  EXPECT_EQ(30u, account.peakUse(MemoryAccount::BasisMemory));
+  EXPECT_EQ(110u, account.peakTotalUse());
+  EXPECT_FALSE(account.takeBudgetExceeded());
+}
+
+TEST(GB, classicSugar) {
+  // The reduced Groebner basis is unique, so the selection strategy must
+  // not change it.
+  const std::string ideals[] = {
+    smallIdealComponentLastDescending(),
+    liuIdealComponentLastDescending(),
+    weispfennig97IdealComponentLast(true),
+    gerdt93IdealComponentLast(true, false)
+  };
+  for (const auto& ideal : ideals) {
+    EXPECT_EQ(
+      classicGB(ideal, nullptr, nullptr, false),
+      classicGB(ideal, nullptr, nullptr, true)
+    );
+  }
+}
+
+namespace {
+  typedef MultiModularGB::RationalPoly RationalPoly;
+
+  MultiModularGB::Term rationalTerm(
+    BigInteger numerator,
+    BigInteger denominator,
+    std::vector<MultiModularGB::Exponent> exponents
+  ) {
+    MultiModularGB::Term t = {numerator, denominator, std::move(exponents)};
+    return t;
+  }
+
+  std::string toString(const std::vector<RationalPoly>& basis) {
+    std::ostringstream out;
+    for (const auto& poly : basis) {
+      for (const auto& t : poly) {
+        out << ' ' << t.numerator << '/' << t.denominator << '*';
+        for (const auto e : t.exponents)
+          out << e;
+      }
+      out << '\n';
+    }
+    return out.str();
+  }
+}
+
+TEST(MultiModularGB, KnownBasis) {
+  // The ideal (3x - 200000y, 7y^2 - 5) in grevlex with x > y has the
+  // reduced Groebner basis (x - 200000/3 y, y^2 - 5/7). Reconstructing
+  // 200000/3 takes more than one prime.
+  std::vector<RationalPoly> ideal(2);
+  ideal[0].push_back(rationalTerm(3, 1, {1, 0}));
+  ideal[0].push_back(rationalTerm(-200000, 1, {0, 1}));
+  ideal[1].push_back(rationalTerm(-5, 1, {0, 0}));
+  ideal[1].push_back(rationalTerm(7, 1, {0, 2}));
+
+  for (int useTrace = 0; useTrace < 2; ++useTrace) {
+    MultiModularGB alg(MultiModularGB::Order(2));
+    alg.setUseTrace(useTrace != 0);
+    alg.setPrimeBatchSize(1);
+    const auto gb = alg.computeGroebnerBasis(ideal);
+    EXPECT_EQ(" 1/1*10 -200000/3*01\n 1/1*02 -5/7*00\n", toString(gb));
+    EXPECT_LT(2u, alg.stats().primeCount);
+  }
+}
+
+TEST(MultiModularGB, LargeCoefficients) {
+  // The numerator and denominator of the coefficient of y in the basis do
+  // not fit in 64 bits, so lifting them takes multiple precision.
+  const auto numerator = BigInteger::fromString("123456789012345678901234567");
+  const auto denominator = BigInteger::fromString("98765432109876543211");
+  std::vector<RationalPoly> ideal(2);
+  ideal[0].push_back(rationalTerm(denominator, 1, {1, 0}));
+  ideal[0].push_back(rationalTerm(-numerator, 1, {0, 1}));
+  ideal[1].push_back(rationalTerm(-5, 1, {0, 0}));
+  ideal[1].push_back(rationalTerm(7, 1, {0, 2}));
+
+  MultiModularGB alg(MultiModularGB::Order(2));
+  const auto gb = alg.computeGroebnerBasis(ideal);
+  EXPECT_EQ(" 1/1*10 -123456789012345678901234567/98765432109876543211*01\n"
+    " 1/1*02 -5/7*00\n", toString(gb));
+  EXPECT_LT(10u, alg.stats().primeCount);
+}
+
+TEST(MultiModularGB, TraceAndReducers) {
+  // cyclic-4 with some rational coefficients thrown in.
+  std::vector<RationalPoly> ideal(4);
+  ideal[0].push_back(rationalTerm(1, 2, {1, 0, 0, 0}));
+  ideal[0].push_back(rationalTerm(1, 1, {0, 1, 0, 0}));
+  ideal[0].push_back(rationalTerm(3, 1, {0, 0, 1, 0}));
+  ideal[0].push_back(rationalTerm(1, 1, {0, 0, 0, 1}));
+  ideal[1].push_back(rationalTerm(1, 1, {1, 1, 0, 0}));
+  ideal[1].push_back(rationalTerm(-2, 5, {0, 1, 1, 0}));
+  ideal[1].push_back(rationalTerm(1, 1, {0, 0, 1, 1}));
+  ideal[1].push_back(rationalTerm(1, 1, {1, 0, 0, 1}));
+  ideal[2].push_back(rationalTerm(1, 1, {1, 1, 1, 0}));
+  ideal[2].push_back(rationalTerm(1, 1, {0, 1, 1, 1}));
+  ideal[2].push_back(rationalTerm(7, 1, {1, 0, 1, 1}));
+  ideal[2].push_back(rationalTerm(1, 1, {1, 1, 0, 1}));
+  ideal[3].push_back(rationalTerm(1, 1, {1, 1, 1, 1}));
+  ideal[3].push_back(rationalTerm(-1, 1, {0, 0, 0, 0}));
+
+  std::string expected;
+  for (int i = 0; i < 4; ++i) {
+    MultiModularGB alg(MultiModularGB::Order(4));
+    alg.setUseTrace(i % 2 == 0);
+    alg.setReducerType(i < 2 ?
+      Reducer::Reducer_F4_New : Reducer::Reducer_Geobucket_Hashed);
+    const auto gb = toString(alg.computeGroebnerBasis(ideal));
+    if (i == 0)
+      expected = gb;
+    else
+      EXPECT_EQ(expected, gb) << i;
+  }
+  EXPECT_FALSE(expected.empty());
+}
@@ -3,7 +3,15 @@
 #include "mathicgb/stdinc.h"
 
 #include "mathicgb.h"
+#include "mathicgb/LogDomainSet.hpp"
+#include "mathicgb/TimeTrace.hpp"
 #include <gtest/gtest.h>
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
 
 using namespace mgb;
 
@@ -718,6 +726,129 @@ TEST(MathicGBLib, SimpleModuleIdeal) {
   }
 }
 
+namespace {
+  /// Records the polynomials written to it so that a test can inspect them.
+  class PolyCollector : public mgb::NullIdealStream {
+  public:
+    struct Term {
+      Component com;
+      std::vector<Exponent> exponents;
+      Coefficient coefficient;
+    };
+    typedef std::vector<Term> Polynomial;
+
+    PolyCollector(Coefficient modulus, VarIndex varCount, Component comCount):
+      NullIdealStream(modulus, varCount, comCount) {}
+
+    void idealBegin() {mPolys.clear();}
+    void idealBegin(size_t polyCount) {idealBegin();}
+    void appendPolynomialBegin() {mPolys.emplace_back();}
+    void appendPolynomialBegin(size_t termCount) {appendPolynomialBegin();}
+    void appendTermBegin(Component com) {
+      Term term = {com, std::vector<Exponent>(varCount()), 0};
+      mPolys.back().push_back(std::move(term));
+    }
+    void appendExponent(VarIndex index, Exponent exponent) {
+      mPolys.back().back().exponents[index] = exponent;
+    }
+    void appendTermDone(Coefficient coefficient) {
+      mPolys.back().back().coefficient = coefficient;
+    }
+
+    const std::vector<Polynomial>& polys() const {return mPolys;}
+
+  private:
+    std::vector<Polynomial> mPolys;
+  };
+
+  bool divides(const PolyCollector::Term& a, const PolyCollector::Term& b) {
+    if (a.com != b.com)
+      return false;
+    for (size_t var = 0; var < a.exponents.size(); ++var)
+      if (a.exponents[var] > b.exponents[var])
+        return false;
+    return true;
+  }
+
+  /// Checks that every polynomial is monic and that no term of any
+  /// polynomial is divisible by the leading term of another polynomial.
+  void checkReduced(const std::vector<PolyCollector::Polynomial>& polys) {
+    for (const auto& poly : polys) {
+      ASSERT_FALSE(poly.empty());
+      ASSERT_EQ(1, poly.front().coefficient);
+    }
+    for (size_t i = 0; i < polys.size(); ++i) {
+      for (size_t j = 0; j < polys.size(); ++j) {
+        for (size_t term = i == j; term < polys[j].size(); ++term) {
+          ASSERT_FALSE(divides(polys[i].front(), polys[j][term]))
+            << "lead term of basis element " << i
+            << " divides term " << term << " of basis element " << j;
+        }
+      }
+    }
+  }
+
+  /// Checks that a and b are the same reduced Groebner basis up to the
+  /// order of the basis elements.
+  void expectSameBasis(
+    std::vector<PolyCollector::Polynomial> a,
+    std::vector<PolyCollector::Polynomial> b
+  ) {
+    checkReduced(a);
+    checkReduced(b);
+    auto byLeadTerm = [](
+      const PolyCollector::Polynomial& x,
+      const PolyCollector::Polynomial& y
+    ) {
+      return x.front().exponents < y.front().exponents;
+    };
+    std::sort(a.begin(), a.end(), byLeadTerm);
+    std::sort(b.begin(), b.end(), byLeadTerm);
+    ASSERT_EQ(a.size(), b.size());
+    for (size_t i = 0; i < a.size(); ++i) {
+      ASSERT_EQ(a[i].size(), b[i].size());
+      for (size_t term = 0; term < a[i].size(); ++term) {
+        ASSERT_EQ(a[i][term].exponents, b[i][term].exponents);
+        ASSERT_EQ(a[i][term].coefficient, b[i][term].coefficient);
+      }
+    }
+  }
+
+  std::vector<PolyCollector::Polynomial> reducedCyclic5(bool useClassic) {
+    mgb::GroebnerConfiguration configuration(101, 5, 1);
+    configuration.setReducer(useClassic ?
+      mgb::GroebnerConfiguration::ClassicReducer :
+      mgb::GroebnerConfiguration::MatrixReducer);
+    configuration.setReducedBasis(true);
+    EXPECT_TRUE(configuration.reducedBasis());
+    mgb::GroebnerInputIdealStream input(configuration);
+    makeCyclic5Basis(input);
+    PolyCollector computed(101, 5, 1);
+    mgb::computeGroebnerBasis(input, computed);
+    return computed.polys();
+  }
+}
+
+TEST(MathicGBLib, ReducedBasis) {
+  // The basis of cyclic-5 is large enough that the matrix reducer
+  // interreduces it with a matrix. The reduced basis is unique, so both
+  // reducers must compute the same set of polynomials.
+  auto classic = reducedCyclic5(true);
+  auto matrix = reducedCyclic5(false);
+
+  expectSameBasis(classic, matrix);
+
+  // This basis is small so the matrix reducer interreduces it classically.
+  mgb::GroebnerConfiguration configuration(101, 3, 1);
+  configuration.setReducedBasis(true);
+  mgb::GroebnerInputIdealStream input(configuration);
+  makeBasis(input);
+  PolyCollector computed(101, 3, 1);
+  mgb::computeGroebnerBasis(input, computed);
+  ASSERT_EQ(3u, computed.polys().size());
+  checkReduced(computed.polys());
+}
+
 namespace {
   class TestCallback : public mgb::GroebnerConfiguration::Callback {
   public:
@@ -728,6 +859,8 @@ namespace {
       return mCount == 0 ? mAction : ContinueAction;
     }
 
+    int count() const {return mCount;}
+
   private:
     int mCount;
     const Action mAction;
@@ -765,6 +898,336 @@ TEST(MathicGBLib, EarlyExit) {
   }
 }
 
+TEST(MathicGBLib, CheckpointResume) {
+  typedef mgb::GroebnerConfiguration::Callback::Action Action;
+  const char* const fileName = "mathicgb-test-checkpoint.tmp";
+  auto compute = [&](
+    bool useClassic,
+    bool resume,
+    int stopAfter,
+    size_t& callCount
+  ) {
+    mgb::GroebnerConfiguration configuration(101, 5, 1);
+    configuration.setReducer(useClassic ?
+      mgb::GroebnerConfiguration::ClassicReducer :
+      mgb::GroebnerConfiguration::MatrixReducer);
+    configuration.setMaxSPairGroupSize(useClassic ? 1 : 0);
+    configuration.setReducedBasis(true);
+    configuration.setCheckpointFile(fileName);
+    configuration.setCheckpointInterval(0);
+    configuration.setResumeFromCheckpoint(resume);
+    configuration.setSugarStrategy(useClassic);
+    TestCallback callback(stopAfter, Action::StopWithPartialOutputAction);
+    configuration.setCallback(&callback);
+    mgb::GroebnerInputIdealStream input(configuration);
+    makeCyclic5Basis(input);
+    PolyCollector computed(101, 5, 1);
+    mgb::computeGroebnerBasis(input, computed);
+    callCount = stopAfter - callback.count();
+    return computed.polys();
+  };
+
+  for (int useClassic = 0; useClassic < 2; ++useClassic) {
+    std::remove(fileName);
+    size_t fullCalls;
+    const auto full = compute(useClassic, false, -1, fullCalls);
+    ASSERT_LT(4u, fullCalls);
+
+    // Stop part of the way, then resume from the checkpoint written when
+    // the computation stopped.
+    std::remove(fileName);
+    size_t calls;
+    compute(useClassic, false, 4, calls);
+    ASSERT_EQ(4u, calls);
+    size_t resumedCalls;
+    const auto resumed = compute(useClassic, true, -1, resumedCalls);
+    ASSERT_LT(resumedCalls, fullCalls);
+
+    expectSameBasis(full, resumed);
+
+    // The last checkpoint is of the finished computation.
+    size_t finishedCalls;
+    const auto finished = compute(useClassic, true, -1, finishedCalls);
+    ASSERT_LT(finishedCalls, resumedCalls);
+    expectSameBasis(full, finished);
+  }
+  std::remove(fileName);
+}
+
+TEST(MathicGBLib, TimeTrace) {
+  const char* const fileName = "mathicgb-test-trace.tmp";
+  std::remove(fileName);
+  mgb::GroebnerConfiguration configuration(101, 5, 1);
+  configuration.setReducer(mgb::GroebnerConfiguration::MatrixReducer);
+  configuration.setLogging("SPairEarly,trace=mathicgb-test-trace.tmp");
+  mgb::GroebnerInputIdealStream input(configuration);
+  makeCyclic5Basis(input);
+  mgb::NullIdealStream computed
+    (input.modulus(), input.varCount(), input.comCount());
+  mgb::computeGroebnerBasis(input, computed);
+
+  // The logging is turned off again so that computations without logging
+  // can run at the same time as each other.
+  EXPECT_FALSE(mgb::LogDomainSet::singleton().anyEnabled());
+  EXPECT_FALSE(mgb::TimeTrace::enabled());
+
+  // The trace has regions for timed logs and for parallel_for even though
+  // no logs were enabled.
+  std::ifstream in(fileName);
+  ASSERT_TRUE(in.good());
+  const std::string trace((std::istreambuf_iterator<char>(in)),
+    std::istreambuf_iterator<char>());
+  in.close();
+  std::remove(fileName);
+  EXPECT_EQ(0u, trace.find("{\"traceEvents\":["));
+  EXPECT_NE(std::string::npos, trace.find("\"name\":\"F4MatReduceTop\""));
+  EXPECT_NE(std::string::npos, trace.find("\"name\":\"parallel_for\""));
+  EXPECT_NE(std::string::npos, trace.find("\"ph\":\"X\""));
+  ASSERT_LT(2u, trace.size());
+  EXPECT_EQ("}\n", trace.substr(trace.size() - 2));
+}
+
+TEST(MathicGBLib, KnownGroebnerBasis) {
+  typedef mgb::GroebnerConfiguration::Callback::Action Action;
+  const auto cyclic5 = reducedCyclic5(false);
+
+  // x0^4 x3^3 - x4^3
+  PolyCollector::Polynomial newGen(2);
+  newGen[0].com = 0;
+  newGen[0].exponents = {4, 0, 0, 3, 0};
+  newGen[0].coefficient = 1;
+  newGen[1].com = 0;
+  newGen[1].exponents = {0, 0, 0, 0, 3};
+  newGen[1].coefficient = 100;
+
+  auto compute = [&](
+    bool useClassic,
+    bool withNewGen,
+    size_t knownCount,
+    size_t& callCount
+  ) {
+    mgb::GroebnerConfiguration configuration(101, 5, 1);
+    configuration.setReducer(useClassic ?
+      mgb::GroebnerConfiguration::ClassicReducer :
+      mgb::GroebnerConfiguration::MatrixReducer);
+    configuration.setMaxSPairGroupSize(1);
+    configuration.setReducedBasis(true);
+    TestCallback callback(-1, Action::ContinueAction);
+    configuration.setCallback(&callback);
+    mgb::GroebnerInputIdealStream input(configuration);
+    input.setKnownGroebnerBasisCount(knownCount);
+    EXPECT_EQ(knownCount, input.knownGroebnerBasisCount());
+
+    auto polys = cyclic5;
+    if (withNewGen)
+      polys.push_back(newGen);
+    input.idealBegin(polys.size());
+    for (const auto& poly : polys) {
+      input.appendPolynomialBegin(poly.size());
+      for (const auto& term : poly) {
+        input.appendTermBegin(term.com);
+        for (size_t var = 0; var < term.exponents.size(); ++var)
+          if (term.exponents[var] != 0)
+            input.appendExponent(var, term.exponents[var]);
+        input.appendTermDone(term.coefficient);
+      }
+      input.appendPolynomialDone();
+    }
+    input.idealDone();
+
+    PolyCollector computed(101, 5, 1);
+    mgb::computeGroebnerBasis(input, computed);
+    callCount = -1 - callback.count();
+    return computed.polys();
+  };
+
+  for (int useClassic = 0; useClassic < 2; ++useClassic) {
+    size_t fullCalls;
+    const auto full = compute(useClassic, true, 0, fullCalls);
+    size_t knownCalls;
+    const auto known =
+      compute(useClassic, true, cyclic5.size(), knownCalls);
+    expectSameBasis(full, known);
+    ASSERT_LT(knownCalls, fullCalls);
+
+    // A count larger than the number of polynomials means that all of
+    // them are a Groebner basis already.
+    size_t allCalls;
+    const auto all = compute(useClassic, false, 1000, allCalls);
+    expectSameBasis(cyclic5, all);
+    ASSERT_EQ(0u, allCalls);
+  }
+}
+
+TEST(MathicGBLib, HilbertNumerator) {
+  typedef mgb::GroebnerConfiguration::Callback::Action Action;
+  typedef mgb::GroebnerConfiguration::Coefficient Coefficient;
+  typedef mgb::GroebnerConfiguration::VarIndex VarIndex;
+  // Generic quadrics in as many variables as there are quadrics form a
+  // regular sequence, so the Hilbert numerator is (1 - t^2)^VarCount.
+  const VarIndex VarCount = 6;
+  std::vector<long long> numerator(1, 1);
+  for (VarIndex i = 0; i < VarCount; ++i) {
+    numerator.resize(numerator.size() + 2);
+    for (size_t j = numerator.size() - 1; j >= 2; --j)
+      numerator[j] -= numerator[j - 2];
+  }
+  auto compute = [&](
+    bool useClassic,
+    const std::vector<long long>& numerator,
+    size_t& callCount
+  ) {
+    mgb::GroebnerConfiguration configuration(101, VarCount, 1);
+    configuration.setReducer(useClassic ?
+      mgb::GroebnerConfiguration::ClassicReducer :
+      mgb::GroebnerConfiguration::MatrixReducer);
+    configuration.setMaxSPairGroupSize(1);
+    configuration.setReducedBasis(true);
+    configuration.setHilbertNumerator(numerator);
+    EXPECT_EQ(numerator, configuration.hilbertNumerator());
+    TestCallback callback(-1, Action::ContinueAction);
+    configuration.setCallback(&callback);
+    mgb::GroebnerInputIdealStream input(configuration);
+
+    unsigned long long state = 1;
+    input.idealBegin(VarCount);
+    for (VarIndex i = 0; i < VarCount; ++i) {
+      input.appendPolynomialBegin(VarCount * (VarCount + 1) / 2);
+      for (VarIndex a = 0; a < VarCount; ++a) {
+        for (VarIndex b = a; b < VarCount; ++b) {
+          input.appendTermBegin(0);
+          if (a == b)
+            input.appendExponent(a, 2);
+          else {
+            input.appendExponent(a, 1);
+            input.appendExponent(b, 1);
+          }
+          state = state * 6364136223846793005ull + 1442695040888963407ull;
+          input.appendTermDone(static_cast<Coefficient>(state >> 33) % 100 + 1);
+        }
+      }
+      input.appendPolynomialDone();
+    }
+    input.idealDone();
+
+    PolyCollector computed(101, VarCount, 1);
+    mgb::computeGroebnerBasis(input, computed);
+    callCount = -1 - callback.count();
+    return computed.polys();
+  };
+
+  for (int useClassic = 0; useClassic < 2; ++useClassic) {
+    size_t plainCalls;
+    const auto plain =
+      compute(useClassic, std::vector<long long>(), plainCalls);
+    size_t hilbertCalls;
+    const auto hilbert = compute(useClassic, numerator, hilbertCalls);
+    expectSameBasis(plain, hilbert);
+    ASSERT_LT(hilbertCalls, plainCalls);
+  }
+}
+
+TEST(MathicGBLib, Context) {
+  const auto withoutContext = reducedCyclic5(false);
+  mgb::GroebnerContext context(2);
+  ASSERT_EQ(2u, context.maxThreadCount());
+  for (int i = 0; i < 3; ++i) {
+    mgb::GroebnerConfiguration configuration(101, 5, 1);
+    configuration.setReducedBasis(true);
+    mgb::GroebnerInputIdealStream input(configuration);
+    makeCyclic5Basis(input);
+    PolyCollector computed(101, 5, 1);
+    mgb::computeGroebnerBasis(input, computed, context);
+    expectSameBasis(withoutContext, computed.polys());
+  }
+}
+
+TEST(MathicGBLib, Batch) {
+  // Alternate between cyclic-5 and a small ideal in 3 variables so that
+  // the batch has inputs both with the same ring and with different rings.
+  const size_t count = 6;
+  auto makeConfiguration = [](size_t i) {
+    mgb::GroebnerConfiguration configuration(101, i % 2 == 0 ? 5 : 3, 1);
+    configuration.setReducer(i % 4 < 2 ?
+      mgb::GroebnerConfiguration::ClassicReducer :
+      mgb::GroebnerConfiguration::MatrixReducer);
+    configuration.setReducedBasis(true);
+    return configuration;
+  };
+  auto makeInput = [](size_t i, mgb::GroebnerInputIdealStream& input) {
+    if (i % 2 == 0)
+      makeCyclic5Basis(input);
+    else
+      makeBasis(input);
+  };
+
+  std::vector<std::vector<PolyCollector::Polynomial>> expected;
+  for (size_t i = 0; i < count; ++i) {
+    mgb::GroebnerInputIdealStream input(makeConfiguration(i));
+    makeInput(i, input);
+    PolyCollector computed(101, input.varCount(), 1);
+    mgb::computeGroebnerBasis(input, computed);
+    expected.push_back(computed.polys());
+  }
+
+  mgb::GroebnerContext context(2);
+  for (int useContext = 0; useContext < 2; ++useContext) {
+    std::vector<std::unique_ptr<mgb::GroebnerInputIdealStream>> inputs;
+    std::vector<mgb::GroebnerInputIdealStream*> inputPointers;
+    std::vector<PolyCollector> outputs;
+    for (size_t i = 0; i < count; ++i) {
+      const auto configuration = makeConfiguration(i);
+      inputs.emplace_back(useContext ?
+        new mgb::GroebnerInputIdealStream(configuration, context) :
+        new mgb::GroebnerInputIdealStream(configuration));
+      makeInput(i, *inputs.back());
+      inputPointers.push_back(inputs.back().get());
+      outputs.emplace_back(101, configuration.varCount(), 1);
+    }
+    if (useContext) {
+      mgb::computeGroebnerBases
+        (inputPointers.data(), outputs.data(), count, context);
+    } else
+      mgb::computeGroebnerBases(inputPointers.data(), outputs.data(), count);
+    for (size_t i = 0; i < count; ++i)
+      expectSameBasis(expected[i], outputs[i].polys());
+  }
+}
+
+TEST(MathicGBLib, RationalBasis) {
+  // The ideal (3x - 200000y, 7y^2 - 5) has the reduced Groebner basis
+  // (x - 200000/3 y, y^2 - 5/7).
+  auto term = [](const char* numerator, const char* denominator,
+    mgb::GroebnerConfiguration::Exponent x,
+    mgb::GroebnerConfiguration::Exponent y
+  ) {
+    mgb::RationalTerm t;
+    t.numerator = numerator;
+    t.denominator = denominator;
+    t.exponents.push_back(x);
+    t.exponents.push_back(y);
+    return t;
+  };
+  std::vector<mgb::RationalPolynomial> ideal(2);
+  ideal[0].push_back(term("3", "1", 1, 0));
+  ideal[0].push_back(term("-200000", "1", 0, 1));
+  ideal[1].push_back(term("-5", "1", 0, 0));
+  ideal[1].push_back(term("7", "1", 0, 2));
+
+  mgb::GroebnerConfiguration configuration(101, 2, 1);
+  const auto gb = mgb::computeRationalGroebnerBasis(configuration, ideal);
+  ASSERT_EQ(2u, gb.size());
+  std::ostringstream out;
+  for (const auto& poly : gb) {
+    for (const auto& t : poly) {
+      out << ' ' << t.numerator << '/' << t.denominator << '*' <<
+        t.exponents[0] << t.exponents[1];
+    }
+    out << '\n';
+  }
+  EXPECT_EQ(" 1/1*10 -200000/3*01\n 1/1*02 -5/7*00\n", out.str());
+}
+
 TEST(MathicGBLib, SimpleEliminationGB) {
   typedef mgb::GroebnerConfiguration::Exponent Exponent;
   Exponent v[] = {1,0,0,0,  1,1,1,1};
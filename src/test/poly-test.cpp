@@ -4,12 +4,17 @@
 #include "mathicgb/Poly.hpp"
 
 #include "mathicgb/Basis.hpp"
+#include "mathicgb/ClassicReducerCache.hpp"
+#include "mathicgb/FrozenMonoLookup.hpp"
 #include "mathicgb/ModuleMonoSet.hpp"
+#include "mathicgb/PolyBasis.hpp"
+#include "mathicgb/mtbb.hpp"
 #include "mathicgb/io-util.hpp"
 #include "mathicgb/SigPolyBasis.hpp"
 #include "mathicgb/SignatureGB.hpp"
 #include "mathicgb/MathicIO.hpp"
 #include <gtest/gtest.h>
+#include <algorithm>
 #include <cstdio>
 #include <string>
 #include <iostream>
@@ -536,6 +541,189 @@ TEST(MTArray,KDTree1) {
   EXPECT_FALSE(M->member(monomialParseFromString(R.get(), "ad<1>")));
 }
 
+TEST(MTArray,DegreeList1) {
+  std::unique_ptr<PolyRing> R(ringFromString("32003 6 1\n1 1 1 1 1 1"));
+  auto M = ModuleMonoSet::make(R->monoid(), 5, 6, true);
+  EXPECT_TRUE(M->insert(monomialParseFromString(R.get(), "abc<1>")));
+  EXPECT_TRUE(M->insert(monomialParseFromString(R.get(), "a2d<1>")));
+  EXPECT_FALSE(M->insert(monomialParseFromString(R.get(), "a3d<1>")));
+  EXPECT_TRUE(M->insert(monomialParseFromString(R.get(), "e6<2>")));
+  EXPECT_EQ(3u, M->elementCount());
+
+  EXPECT_TRUE(M->member(monomialParseFromString(R.get(), "abc4d<1>")));
+  EXPECT_TRUE(M->member(monomialParseFromString(R.get(), "a2d2<1>")));
+  EXPECT_TRUE(M->member(monomialParseFromString(R.get(), "abc<1>")));
+  EXPECT_TRUE(M->member(monomialParseFromString(R.get(), "a2d<1>")));
+  EXPECT_FALSE(M->member(monomialParseFromString(R.get(), "a2d<2>")));
+  EXPECT_FALSE(M->member(monomialParseFromString(R.get(), "ad<1>")));
+  EXPECT_FALSE(M->member(monomialParseFromString(R.get(), "e5f<2>")));
+
+  // inserting ad removes its multiple a2d.
+  EXPECT_TRUE(M->insert(monomialParseFromString(R.get(), "ad<1>")));
+  EXPECT_EQ(3u, M->elementCount());
+  EXPECT_TRUE(M->member(monomialParseFromString(R.get(), "a2d<1>")));
+  EXPECT_FALSE(M->member(monomialParseFromString(R.get(), "a2d<2>")));
+  EXPECT_TRUE(M->member(monomialParseFromString(R.get(), "ae6<2>")));
+  EXPECT_FALSE(M->member(monomialParseFromString(R.get(), "bc<1>")));
+  EXPECT_TRUE(M->member(monomialParseFromString(R.get(), "ad<1>")));
+}
+
+namespace {
+  class CollectIndexes : public MonoLookup::EntryOutput {
+  public:
+    virtual bool proceed(size_t index) {
+      indexes.push_back(index);
+      return true;
+    }
+    std::vector<size_t> indexes;
+  };
+
+  std::vector<size_t> multiplesOf(
+    const FrozenMonoLookup& lookup,
+    FrozenMonoLookup::ConstMonoRef mono
+  ) {
+    CollectIndexes out;
+    lookup.multiples(mono, out);
+    std::sort(out.indexes.begin(), out.indexes.end());
+    return out.indexes;
+  }
+
+  std::vector<size_t> multiplesOf(
+    const MonoLookup& lookup,
+    MonoLookup::ConstMonoRef mono
+  ) {
+    CollectIndexes out;
+    lookup.multiples(mono, out);
+    std::sort(out.indexes.begin(), out.indexes.end());
+    return out.indexes;
+  }
+
+  /// Returns monomials to look up in a basis of the generators of I: the
+  /// identity, the lead monomials and the products of two lead monomials.
+  /// The products have several divisors among the lead monomials, so they
+  /// check the choice of reducer. Free the monomials when done.
+  std::vector<PolyRing::Monoid::Mono> lookupQueries(const Basis& I) {
+    const auto& monoid = I.ring().monoid();
+    const auto gens = I.size();
+    std::vector<PolyRing::Monoid::Mono> queries;
+    queries.push_back(monoid.alloc());
+    for (size_t a = 0; a < gens; ++a) {
+      for (size_t b = a; b < gens; ++b) {
+        queries.push_back(monoid.alloc());
+        monoid.multiply
+          (I.getPoly(a)->leadMono(), I.getPoly(b)->leadMono(), *queries.back());
+      }
+      queries.push_back(monoid.alloc());
+      monoid.copy(I.getPoly(a)->leadMono(), *queries.back());
+    }
+    return queries;
+  }
+}
+
+TEST(FrozenMonoLookup, sameAsMonoLookup) {
+  std::unique_ptr<Basis> I = basisParseFromString(ideal2);
+  std::unique_ptr<const PolyRing> R(I->getPolyRing());
+  const auto& monoid = R->monoid();
+  const auto gens = I->viewGenerators().size();
+  auto queries = lookupQueries(*I);
+
+  for (int type = 1; type <= 4; ++type) {
+    for (int preferSparse = 0; preferSparse < 2; ++preferSparse) {
+      auto factory = MonoLookup::makeFactory(monoid, type);
+      PolyBasis basis(*R, factory->make(preferSparse != 0, true));
+      for (size_t gen = 0; gen < gens; ++gen)
+        basis.insert(make_unique<Poly>(*I->getPoly(gen)));
+      basis.retire(1);
+
+      FrozenMonoLookup frozen(basis);
+      EXPECT_EQ(gens - 1, frozen.size());
+      for (const auto& query : queries) {
+        EXPECT_EQ(basis.classicReducer(*query), frozen.classicReducer(*query));
+        const auto divisor = frozen.divisor(*query);
+        EXPECT_EQ(basis.divisor(*query) == size_t(-1), divisor == size_t(-1));
+        if (divisor != size_t(-1)) {
+          EXPECT_TRUE(monoid.divides(basis.leadMono(divisor), *query));
+        }
+        EXPECT_EQ(
+          multiplesOf(basis.monoLookup(), *query),
+          multiplesOf(frozen, *query)
+        );
+      }
+
+      // The same queries as one batch.
+      std::vector<FrozenMonoLookup::ConstMonoPtr> monos;
+      for (const auto& query : queries)
+        monos.push_back(query.ptr());
+      std::vector<size_t> batch(queries.size());
+      frozen.classicReducers(monos.data(), monos.size(), batch.data());
+      std::vector<size_t> lookupBatch(queries.size());
+      basis.monoLookup().classicReducers
+        (monos.data(), monos.size(), lookupBatch.data());
+      for (size_t i = 0; i < queries.size(); ++i) {
+        EXPECT_EQ(basis.classicReducer(*queries[i]), batch[i]);
+        EXPECT_EQ(batch[i], lookupBatch[i]);
+      }
+
+      // The same queries from several threads at once.
+      std::vector<size_t> reducers(queries.size());
+      mgb::mtbb::parallel_for(
+        mgb::mtbb::blocked_range<size_t>(0, queries.size(), 1),
+        [&](const mgb::mtbb::blocked_range<size_t>& range) {
+          for (auto i = range.begin(); i != range.end(); ++i)
+            reducers[i] = frozen.classicReducer(*queries[i]);
+        }
+      );
+      for (size_t i = 0; i < queries.size(); ++i)
+        EXPECT_EQ(basis.classicReducer(*queries[i]), reducers[i]);
+    }
+  }
+  for (auto& query : queries)
+    monoid.free(std::move(query));
+}
+
+TEST(ClassicReducerCache, staysCorrect) {
+  std::unique_ptr<Basis> I = basisParseFromString(ideal2);
+  std::unique_ptr<const PolyRing> R(I->getPolyRing());
+  const auto& monoid = R->monoid();
+  const auto gens = I->viewGenerators().size();
+  auto queries = lookupQueries(*I);
+
+  // Insert the generators one at a time, retiring one of them along the
+  // way, and check that whatever the cache remembers is what the basis says.
+  for (size_t maxEntryCount = 3; maxEntryCount < 1000; maxEntryCount *= 30) {
+    ClassicReducerCache cache(*R, maxEntryCount);
+    auto factory = MonoLookup::makeFactory(monoid, 1);
+    PolyBasis basis(*R, factory->make(false, true));
+    size_t hits = 0;
+    for (size_t gen = 0; gen < gens; ++gen) {
+      basis.insert(make_unique<Poly>(*I->getPoly(gen)));
+      if (gen == 4)
+        basis.retire(1);
+      cache.update(basis);
+      for (const auto& query : queries) {
+        size_t reducer;
+        if (cache.find(*query, reducer)) {
+          ++hits;
+          EXPECT_EQ(basis.classicReducer(*query), reducer);
+        } else
+          cache.insert(*query, basis.classicReducer(*query));
+        EXPECT_LE(cache.size(), maxEntryCount);
+      }
+    }
+    if (maxEntryCount >= queries.size()) {
+      EXPECT_LT(0u, hits);
+    }
+
+    // A different basis makes the cache forget everything.
+    PolyBasis other(*R, factory->make(false, true));
+    other.insert(make_unique<Poly>(*I->getPoly(gens - 1)));
+    cache.update(other);
+    EXPECT_EQ(0u, cache.size());
+  }
+  for (auto& query : queries)
+    monoid.free(std::move(query));
+}
+
 //#warning "remove this code"
 #if 0
 bool test_find_signatures(const PolyRing *R, 